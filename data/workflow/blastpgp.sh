@@ -26,22 +26,45 @@ STEP=0
 # processing
 [ -z "$NUM_IT" ] && NUM_IT=3;
 while [ $STEP -lt $NUM_IT ]; do
+    # with REUSE_HITS only the queries that gained hits in the previous iteration are prefiltered again,
+    # the profiles of all other queries were built from the same hits as before
+    PREF_QUERYDB="$QUERYDB"
+    SKIP_PREF=""
+    if [ -n "$REUSE_HITS" ] && [ $STEP -ge 2 ]; then
+        STEPONE=$((STEP-1))
+        if [ -s "$TMP_PATH/changed_$STEPONE" ]; then
+            if notExists "$TMP_PATH/query_$STEP.dbtype"; then
+                # shellcheck disable=SC2086
+                "$MMSEQS" createsubdb "$TMP_PATH/changed_$STEPONE" "$QUERYDB" "$TMP_PATH/query_$STEP" ${VERBOSITY_PAR} --subdb-mode 1 \
+                    || fail "createsubdb died"
+            fi
+            PREF_QUERYDB="$TMP_PATH/query_$STEP"
+        else
+            SKIP_PREF="TRUE"
+            if notExists "$TMP_PATH/aln_tmp_$STEP.dbtype"; then
+                # shellcheck disable=SC2086
+                "$MMSEQS" createsubdb "$TMP_PATH/changed_$STEPONE" "$TMP_PATH/aln_$STEPONE" "$TMP_PATH/aln_tmp_$STEP" ${VERBOSITY_PAR} \
+                    || fail "createsubdb died"
+            fi
+        fi
+    fi
+
     # call prefilter module
-    if notExists "$TMP_PATH/pref_$STEP.dbtype"; then
+    if [ -z "$SKIP_PREF" ] && notExists "$TMP_PATH/pref_$STEP.dbtype"; then
         PARAM="PREFILTER_PAR_$STEP"
         eval TMP="\$$PARAM"
         if [ $STEP -eq 0 ]; then
             # shellcheck disable=SC2086
-            $RUNNER "$MMSEQS" prefilter "$QUERYDB" "$2" "$TMP_PATH/pref_$STEP" ${TMP} \
+            $RUNNER "$MMSEQS" prefilter "$PREF_QUERYDB" "$2" "$TMP_PATH/pref_$STEP" ${TMP} \
                 || fail "Prefilter died"
         else
             # shellcheck disable=SC2086
-            $RUNNER "$MMSEQS" prefilter "$QUERYDB" "$2" "$TMP_PATH/pref_tmp_$STEP" ${TMP} \
+            $RUNNER "$MMSEQS" prefilter "$PREF_QUERYDB" "$2" "$TMP_PATH/pref_tmp_$STEP" ${TMP} \
                 || fail "Prefilter died"
         fi
     fi
 
-    if [ $STEP -ge 1 ]; then
+    if [ -z "$SKIP_PREF" ] && [ $STEP -ge 1 ]; then
         if notExists "$TMP_PATH/pref_$STEP.dbtype"; then
             STEPONE=$((STEP-1))
             # shellcheck disable=SC2086
@@ -55,8 +78,16 @@ while [ $STEP -lt $NUM_IT ]; do
         fi
     fi
 
+    # the query subset links to the previous profiles, it has to be removed before them
+    if [ -n "$REMOVE_TMP" ] && [ "$PREF_QUERYDB" != "$QUERYDB" ]; then
+        # shellcheck disable=SC2086
+        "$MMSEQS" rmdb "$PREF_QUERYDB" ${VERBOSITY}
+        # shellcheck disable=SC2086
+        "$MMSEQS" rmdb "${PREF_QUERYDB}_h" ${VERBOSITY}
+    fi
+
 	# call alignment module
-	if notExists "$TMP_PATH/aln_tmp_$STEP.dbtype"; then
+	if [ -z "$SKIP_PREF" ] && notExists "$TMP_PATH/aln_tmp_$STEP.dbtype"; then
 	    PARAM="ALIGNMENT_PAR_$STEP"
         eval TMP="\$$PARAM"
 
@@ -74,16 +105,40 @@ while [ $STEP -lt $NUM_IT ]; do
     if [ $STEP -gt 0 ]; then
         if notExists "$TMP_PATH/aln_$STEP.dbtype"; then
             STEPONE=$((STEP-1))
+            PREV_ALN="$TMP_PATH/aln_$STEPONE"
+            if [ -n "$REUSE_HITS" ]; then
+                # the accepted hits of the previous iteration are aligned directly against the updated profile
+                if notExists "$TMP_PATH/aln_rescore_$STEP.dbtype"; then
+                    PARAM="ALIGNMENT_PAR_$STEP"
+                    eval TMP="\$$PARAM"
+                    # shellcheck disable=SC2086
+                    $RUNNER "$MMSEQS" "${ALIGN_MODULE}" "$QUERYDB" "$2" "$TMP_PATH/aln_$STEPONE" "$TMP_PATH/aln_rescore_$STEP" ${TMP} \
+                        || fail "Alignment died"
+                fi
+                PREV_ALN="$TMP_PATH/aln_rescore_$STEP"
+                # queries with new hits get a new prefilter in the next iteration
+                # the index entry lengths cannot tell empty results apart if they are compressed
+                "$MMSEQS" result2stats "$QUERYDB" "$2" "$TMP_PATH/aln_tmp_$STEP" "$TMP_PATH/aln_count_$STEP" --stat linecount ${VERBOSITY_PAR} \
+                    || fail "result2stats died"
+                "$MMSEQS" prefixid "$TMP_PATH/aln_count_$STEP" "$TMP_PATH/aln_count_$STEP.tsv" --tsv ${VERBOSITY_PAR} \
+                    || fail "prefixid died"
+                awk '$2 > 0 { print $1 }' "$TMP_PATH/aln_count_$STEP.tsv" > "$TMP_PATH/changed_$STEP"
+                "$MMSEQS" rmdb "$TMP_PATH/aln_count_$STEP" ${VERBOSITY_PAR}
+                rm -f "$TMP_PATH/aln_count_$STEP.tsv"
+            fi
 
             if [ $STEP -ne $((NUM_IT  - 1)) ]; then
-                "$MMSEQS" mergedbs "$QUERYDB" "$TMP_PATH/aln_$STEP" "$TMP_PATH/aln_$STEPONE" "$TMP_PATH/aln_tmp_$STEP" \
+                "$MMSEQS" mergedbs "$QUERYDB" "$TMP_PATH/aln_$STEP" "$PREV_ALN" "$TMP_PATH/aln_tmp_$STEP" \
                     || fail "Alignment died"
             else
-                "$MMSEQS" mergedbs "$QUERYDB" "$3" "$TMP_PATH/aln_$STEPONE" "$TMP_PATH/aln_tmp_$STEP" \
+                "$MMSEQS" mergedbs "$QUERYDB" "$3" "$PREV_ALN" "$TMP_PATH/aln_tmp_$STEP" \
                         || fail "Alignment died"
             fi
             "$MMSEQS" rmdb "$TMP_PATH/aln_$STEPONE"
             "$MMSEQS" rmdb "$TMP_PATH/aln_tmp_$STEP"
+            if [ -n "$REUSE_HITS" ]; then
+                "$MMSEQS" rmdb "$TMP_PATH/aln_rescore_$STEP"
+            fi
         fi
     fi
 
@@ -110,6 +165,9 @@ if [ -n "$REMOVE_TMP" ]; then
         "$MMSEQS" rmdb "${TMP_PATH}/aln_$STEP" ${VERBOSITY}
         # shellcheck disable=SC2086
         "$MMSEQS" rmdb "${TMP_PATH}/profile_$STEP" ${VERBOSITY}
+        if [ -n "$REUSE_HITS" ]; then
+            rm -f "${TMP_PATH}/changed_$STEP"
+        fi
         STEP=$((STEP+1))
     done
     rm -f "$TMP_PATH/blastpgp.sh"
@@ -159,18 +159,6 @@ if [ -s "${TMP_PATH}/newSeqsHits.swapped.hasHits" ] && notExists "${TMP_PATH}/ne
         || fail "filterdb died"
 fi
 
-UPDATEDCLUST="${TMP_PATH}/updatedClust"
-if [ -f "${TMP_PATH}/newSeqsHits.swapped.dbtype" ]; then
-    if notExists "${TMP_PATH}/updatedClust.dbtype"; then
-        log "=== Merge found sequences with previous clustering"
-        # shellcheck disable=SC2086
-        "$MMSEQS" mergedbs "$OLDCLUST" "${TMP_PATH}/updatedClust" "$OLDCLUST" "${TMP_PATH}/newSeqsHits.swapped" ${VERBOSITY} \
-            || fail "mergedbs died"
-    fi
-else
-    UPDATEDCLUST="$OLDCLUST"
-fi
-
 if notExists "${TMP_PATH}/toBeClusteredSeparately.dbtype"; then
     log "=== Extract unmapped sequences"
     awk '$3 == 1 {print $1}' "${TMP_PATH}/newSeqsHits.index" > "${TMP_PATH}/noHitSeqList"
@@ -186,16 +174,25 @@ if notExists "${TMP_PATH}/newClusters.dbtype" && [ -s "${TMP_PATH}/toBeClustered
         || fail "cluster of new seq. died"
 fi
 
+APPEND_DBS=""
+if [ -f "${TMP_PATH}/newSeqsHits.swapped.dbtype" ]; then
+    APPEND_DBS="${TMP_PATH}/newSeqsHits.swapped"
+fi
 if [ -f "${TMP_PATH}/newClusters.dbtype" ]; then
-    if notExists "$NEWCLUST"; then
-        log "=== Merge updated clustering with new clusters"
+    APPEND_DBS="${APPEND_DBS} ${TMP_PATH}/newClusters"
+fi
+
+if [ -n "${APPEND_DBS}" ]; then
+    if notExists "${NEWCLUST}.dbtype"; then
+        log "=== Append found sequences and new clusters to previous clustering"
+        # only changed clusters are written, the data of the previous clustering is linked
         # shellcheck disable=SC2086
-        "$MMSEQS" concatdbs "${UPDATEDCLUST}" "${TMP_PATH}/newClusters" "$NEWCLUST" --preserve-keys ${THREADS_PAR} \
-            || fail "concatdbs died"
+        "$MMSEQS" appendclusters "$OLDCLUST" "$NEWCLUST" ${APPEND_DBS} ${VERBOSITY} \
+            || fail "appendclusters died"
     fi
 else
     # shellcheck disable=SC2086
-    "$MMSEQS" mvdb "${UPDATEDCLUST}" "$NEWCLUST" ${VERBOSITY}
+    "$MMSEQS" mvdb "${OLDCLUST}" "$NEWCLUST" ${VERBOSITY}
 fi
 
 if [ -n "$REMOVE_TMP" ]; then
@@ -229,8 +226,6 @@ if [ -n "$REMOVE_TMP" ]; then
     "$MMSEQS" rmdb "${TMP_PATH}/newSeqsHits.swapped.all" ${VERBOSITY}
     # shellcheck disable=SC2086
     "$MMSEQS" rmdb "${TMP_PATH}/OLDDB.repSeq" ${VERBOSITY}
-    # shellcheck disable=SC2086
-    "$MMSEQS" rmdb "${TMP_PATH}/updatedClust" ${VERBOSITY}
 
     rm -rf "${TMP_PATH}/search" "${TMP_PATH}/cluster"
     rm -f "${TMP_PATH}/update_clustering.sh"
@@ -109,6 +109,7 @@ typedef __m512  simd_float;
 #define VECSIZE_INT         AVX512_VECSIZE_INT
 typedef __m512i simd_int;
 #define simdi32_add(x,y)    _mm512_add_epi32(x,y)
+#define simdi64_add(x,y)    _mm512_add_epi64(x,y)
 #define simdi16_add(x,y)    _mm512_add_epi16(x,y)
 #define simdi16_adds(x,y)   _mm512_adds_epi16(x,y)
 #define simdui8_adds(x,y)   _mm512_adds_epu8()
@@ -123,6 +124,7 @@ typedef __m512i simd_int;
 #define simdi_store(x,y)    _mm512_store_si512(x,y)
 #define simdi_storeu(x,y)   _mm512_storeu_si512(x,y)
 #define simdi32_set(x)      _mm512_set1_epi32(x)
+#define simdi64_set(x)      _mm512_set1_epi64(x)
 #define simdi16_set(x)      _mm512_set1_epi16(x)
 #define simdi8_set(x)       _mm512_set1_epi8(x)
 #define simdi32_shuffle(x,y) _mm512_shuffle_epi32(x,y)
@@ -210,6 +212,7 @@ inline unsigned short extract_epi16(__m256i v, int pos) {
 
 typedef __m256i simd_int;
 #define simdi32_add(x,y)    _mm256_add_epi32(x,y)
+#define simdi64_add(x,y)    _mm256_add_epi64(x,y)
 #define simdi16_add(x,y)    _mm256_add_epi16(x,y)
 #define simdi16_adds(x,y)   _mm256_adds_epi16(x,y)
 #define simdui8_adds(x,y)   _mm256_adds_epu8(x,y)
@@ -228,6 +231,7 @@ typedef __m256i simd_int;
 #define simdi_store(x,y)    _mm256_store_si256(x,y)
 #define simdi_storeu(x,y)   _mm256_storeu_si256(x,y)
 #define simdi32_set(x)      _mm256_set1_epi32(x)
+#define simdi64_set(x)      _mm256_set1_epi64x(x)
 #define simdi16_set(x)      _mm256_set1_epi16(x)
 #define simdi8_set(x)       _mm256_set1_epi8(x)
 #define simdi32_shuffle(x,y) _mm256_shuffle_epi32(x,y)
@@ -398,6 +402,7 @@ inline unsigned short extract_epi16(__m128i v, int pos) {
 #define VECSIZE_INT         SSE_VECSIZE_INT
 typedef __m128i simd_int;
 #define simdi32_add(x,y)    _mm_add_epi32(x,y)
+#define simdi64_add(x,y)    _mm_add_epi64(x,y)
 #define simdi16_add(x,y)    _mm_add_epi16(x,y)
 #define simdi16_adds(x,y)   _mm_adds_epi16(x,y)
 #define simdui8_adds(x,y)   _mm_adds_epu8(x,y)
@@ -416,6 +421,7 @@ typedef __m128i simd_int;
 #define simdi_storeu(x,y)   _mm_storeu_si128(x,y)
 #define simdi_store(x,y)    _mm_store_si128(x,y)
 #define simdi32_set(x)      _mm_set1_epi32(x)
+#define simdi64_set(x)      _mm_set1_epi64x(x)
 #define simdi16_set(x)      _mm_set1_epi16(x)
 #define simdi8_set(x)       _mm_set1_epi8(x)
 #define simdi32_shuffle(x,y) _mm_shuffle_epi32(x,y)
@@ -637,10 +637,20 @@ std::vector<Command> baseCommands = {
                 CITATION_MMSEQS2, {{"sequenceDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb },
                                                           {"clusterDB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::clusterDb },
                                                           {"clusterDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA | DbType::VARIADIC, &DbValidator::clusterDb }}},
+        {"appendclusters",       appendclusters,       &par.onlyverbosity,        COMMAND_CLUSTER,
+                "Append members and clusters to a clustering without rewriting unchanged clusters",
+                "# Entries of DB1 ... DBn with a key of clusterDB are appended to that cluster, others become new clusters.\n"
+                "# The data of oldClusterDB is hard linked into the output and only changed clusters are written\n"
+                "mmseqs appendclusters oldClusterDB newClusterDB newMembersDB newSingletonClusterDB\n",
+                "Martin Steinegger <martin.steinegger@snu.ac.kr>",
+                "<i:clusterDB> <o:clusterDB> <i:DB1> ... <i:DBn>",
+                CITATION_MMSEQS2, {{"clusterDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::clusterDb },
+                                          {"clusterDB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::clusterDb },
+                                          {"DB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA | DbType::VARIADIC, &DbValidator::allDb }}},
 
 
 
-        {"compress",             compress,             &par.onlythreads,          COMMAND_STORAGE,
+        {"compress",             compress,             &par.compress,          COMMAND_STORAGE,
                 "Compress DB entries",
                 NULL,
                 "Milot Mirdita <milot@mirdita.de>",
@@ -734,7 +744,7 @@ std::vector<Command> baseCommands = {
                 "Martin Steinegger <martin.steinegger@snu.ac.kr>",
                 "<i:DB>",
                 CITATION_MMSEQS2, {{"DB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::allDb }}},
-        {"apply",                apply,                &par.threadsandcompression,
+        {"apply",                apply,                &par.apply,
 #ifdef __CYGWIN__
                 COMMAND_HIDDEN,
 #else
@@ -746,7 +756,10 @@ std::vector<Command> baseCommands = {
                 "# Build MSAs with Clustal-Omega\n"
                 "mmseqs apply unalignedDB msaDB -- clustalo -i - -o stdout --threads=1\n\n"
                 "# Count lines in each DB entry inefficiently (result2stats is way faster)\n"
-                "mmseqs apply DB wcDB -- awk '{ counter++; } END { print counter; }'\n",
+                "mmseqs apply DB wcDB -- awk '{ counter++; } END { print counter; }'\n\n"
+                "# Keep one program per thread running, it reads \"key<tab>size<newline>\" followed by size bytes\n"
+                "# for each entry and answers with \"status<tab>size<newline>\" followed by size bytes\n"
+                "mmseqs apply DB resultDB --persistent-workers -- python3 worker.py\n",
                 "Milot Mirdita <milot@mirdita.de>",
                 "<i:DB> <o:DB> -- program [args...]",
                 CITATION_MMSEQS2, {{"DB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::allDb },
@@ -855,6 +868,16 @@ std::vector<Command> baseCommands = {
                 "<i:sequenceDB> <o:sequenceDB>",
                 CITATION_MMSEQS2, {{"sequenceDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb },
                                           {"sequenceDB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::sequenceDb }}},
+        {"createmaskdb",        createmaskdb,          &par.createmaskdb,         COMMAND_SEQUENCE,
+                "Precompute low complexity masks of a sequence DB using tantan",
+                "# Masks are written run-length encoded to sequenceDB_mask and are used instead of recomputing them\n"
+                "# by prefilter and createindex (--mask-db-mode 0), masksequence (1) or kmermatcher (2)\n"
+                "# if they were computed with the same substitution matrix and alphabet size\n"
+                "mmseqs createmaskdb sequenceDB\n"
+                "mmseqs createmaskdb sequenceDB --mask-db-mode 2 --alph-size aa:13,nucl:5\n",
+                "Martin Steinegger <martin.steinegger@snu.ac.kr>",
+                "<i:sequenceDB>",
+                CITATION_MMSEQS2, {{"sequenceDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb }}},
         {"extractalignedregion", extractalignedregion, &par.extractalignedregion, COMMAND_SEQUENCE,
                 "Extract aligned sequence region from query",
                 NULL,
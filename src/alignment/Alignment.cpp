@@ -14,6 +14,8 @@
 #include "IndexReader.h"
 #include "Parameters.h"
 #include "FastSort.h"
+#include "Metrics.h"
+#include "Timer.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -27,7 +29,7 @@ Alignment::Alignment(const std::string &querySeqDB,
 
         covThr(par.covThr), canCovThr(par.covThr), covMode(par.covMode), seqIdMode(par.seqIdMode), evalThr(par.evalThr), seqIdThr(par.seqIdThr),
         alnLenThr(par.alnLenThr), includeIdentity(par.includeIdentity), addBacktrace(par.addBacktrace), realign(par.realign), scoreBias(par.scoreBias),
-        threads(static_cast<unsigned int>(par.threads)), compressed(par.compressed), outDB(outDB), outDBIndex(outDBIndex),
+        threads(static_cast<unsigned int>(par.threads)), compressed(par.compressed), mpiDynamic(par.mpiDynamic), outDB(outDB), outDBIndex(outDBIndex),
         maxSeqLen(par.maxSeqLen), compBiasCorrection(par.compBiasCorrection), altAlignment(par.altAlignment), qdbr(NULL), qDbrIdx(NULL),
         tdbr(NULL), tDbrIdx(NULL) {
 
@@ -53,6 +55,7 @@ Alignment::Alignment(const std::string &querySeqDB,
     }
 
     bool touch = (par.preloadMode != Parameters::PRELOAD_MODE_MMAP);
+    prefetchTargets = (touch == false);
     tDbrIdx = new IndexReader(targetSeqDB, par.threads, IndexReader::SEQUENCES, (touch) ? (IndexReader::PRELOAD_INDEX | IndexReader::PRELOAD_DATA) : 0 );
     tdbr = tDbrIdx->sequenceReader;
     targetSeqType = tdbr->getDbtype();
@@ -124,6 +127,15 @@ Alignment::Alignment(const std::string &querySeqDB,
     Debug(Debug::INFO) << "Query database size: "  << qdbr->getSize() << " type: " << Parameters::getDbTypeName(querySeqType) << "\n";
     Debug(Debug::INFO) << "Target database size: " << tdbr->getSize() << " type: " << Parameters::getDbTypeName(targetSeqType) << "\n";
 
+    targetSweepBatch = par.targetSweepBatch;
+    if (targetSweepBatch > 0 && tdbr->isCompressed()) {
+        Debug(Debug::WARNING) << "Target sweeps are not supported for compressed target databases\n";
+        targetSweepBatch = 0;
+    }
+    if (targetSweepBatch > 0) {
+        prefetchTargets = false;
+    }
+
     prefdbr = new DBReader<unsigned int>(prefDB.c_str(), prefDBIndex.c_str(), threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     prefdbr->open(DBReader<unsigned int>::LINEAR_ACCCESS);
     reversePrefilterResult = (Parameters::isEqualDbtype(prefdbr->getDbtype(), Parameters::DBTYPE_PREFILTER_REV_RES));
@@ -225,6 +237,36 @@ Alignment::~Alignment() {
 
 void Alignment::run(const unsigned int mpiRank, const unsigned int mpiNumProc,
                     const unsigned int maxAlnNum, const unsigned int maxRejected, bool wrappedScoring) {
+    if (mpiDynamic && mpiNumProc > 1) {
+        // the ranks fetch small chunks of the prefilter result on demand, since the alignment time per query
+        // depends on its length and number of hits a static split lets some ranks finish much earlier
+        const size_t chunkCount = std::min(prefdbr->getSize(), static_cast<size_t>(mpiNumProc) * MMseqsMPI::CHUNKS_PER_RANK);
+        std::vector<std::pair<size_t, size_t>> chunks = prefdbr->decomposeDomainByAminoAcid(chunkCount);
+        {
+            MMseqsMPI::WorkQueue queue(chunkCount);
+            size_t chunk;
+            while (queue.next(&chunk)) {
+                Debug(Debug::INFO) << "Compute chunk " << (chunk + 1) << " of " << chunkCount << " from " << chunks[chunk].first << " to " << (chunks[chunk].first + chunks[chunk].second) << "\n";
+                std::pair<std::string, std::string> tmpOutput = Util::createTmpFileNames(outDB, outDBIndex, chunk);
+                run(tmpOutput.first, tmpOutput.second, chunks[chunk].first, chunks[chunk].second, maxAlnNum, maxRejected, true, wrappedScoring);
+            }
+        }
+
+#ifdef HAVE_MPI
+        MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
+        if (MMseqsMPI::isMaster()) {
+            std::vector<std::pair<std::string, std::string> > splitFiles;
+            for (size_t i = 0; i < chunkCount; i++) {
+                splitFiles.push_back(Util::createTmpFileNames(outDB, outDBIndex, i));
+            }
+            Metrics::startPhase("merging");
+            DBWriter::mergeResults(outDB, outDBIndex, splitFiles);
+            Metrics::stopPhase("merging");
+        }
+        return;
+    }
 
     size_t dbFrom = 0;
     size_t dbSize = 0;
@@ -245,7 +287,9 @@ void Alignment::run(const unsigned int mpiRank, const unsigned int mpiNumProc,
         }
 
         // merge output databases
+        Metrics::startPhase("merging");
         DBWriter::mergeResults(outDB, outDBIndex, splitFiles);
+        Metrics::stopPhase("merging");
     }
 }
 
@@ -273,11 +317,18 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
     if(totalMemory > prefdbr->getTotalDataSize()){
         flushSize = dbSize;
     }
+    if (targetSweepBatch > 0) {
+        flushSize = std::min(flushSize, targetSweepBatch);
+    }
 
+    Metrics::startPhase("gapped_alignment");
     size_t iterations = static_cast<size_t>(ceil(static_cast<double>(dbSize) / static_cast<double>(flushSize)));
     for (size_t i = 0; i < iterations; i++) {
         size_t start = dbFrom + (i * flushSize);
         size_t bucketSize = std::min(dbSize - (i * flushSize), flushSize);
+        if (targetSweepBatch > 0) {
+            readTargetBatch(start, bucketSize);
+        }
         Debug::Progress progress(bucketSize);
 
 #pragma omp parallel num_threads(threads)
@@ -306,10 +357,25 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
             std::vector<Matcher::result_t> swRealignResults;
             swRealignResults.reserve(300);
 
+            std::vector<size_t> prefetchIds;
+            prefetchIds.reserve(300);
+            size_t prefetchedId = SIZE_MAX;
+
 #pragma omp for schedule(dynamic, 5) reduction(+: alignmentsNum, totalPassedNum)
             for (size_t id = start; id < (start + bucketSize); id++) {
                 progress.updateProgress();
 
+                // the targets of the next entry load while the current one is aligned
+                if (prefetchTargets) {
+                    if (prefetchedId != id) {
+                        prefetchTargetSequences(id, thread_idx, prefetchIds);
+                    }
+                    if (id + 1 < start + bucketSize) {
+                        prefetchTargetSequences(id + 1, thread_idx, prefetchIds);
+                    }
+                    prefetchedId = id + 1;
+                }
+
                 // get the prefiltering list
                 char *data = prefdbr->getData(id, thread_idx);
                 unsigned int queryDbKey = prefdbr->getDbKey(id);
@@ -357,7 +423,7 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
                         diagonal = static_cast<short>(hit.diagonal);
                     }
                     size_t dbId = tdbr->getId(dbKey);
-                    char *dbSeqData = tdbr->getData(dbId, thread_idx);
+                    char *dbSeqData = getTargetData(dbId, thread_idx);
 
                     if (dbSeqData == NULL) {
                         Debug(Debug::ERROR) << "Sequence " << dbKey <<" is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
@@ -405,7 +471,7 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
                     realigner->initQuery(&qSeq);
                     for (size_t result = 0; result < swResults.size(); result++) {
                         size_t dbId = tdbr->getId(swResults[result].dbKey);
-                        char *dbSeqData = tdbr->getData(dbId, thread_idx);
+                        char *dbSeqData = getTargetData(dbId, thread_idx);
                         if (dbSeqData == NULL) {
                             Debug(Debug::ERROR) << "Sequence " << swResults[result].dbKey <<" is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
                             EXIT(EXIT_FAILURE);
@@ -458,8 +524,18 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
 
 
     }
-
+    Metrics::stopPhase("gapped_alignment");
+    std::vector<size_t>().swap(batchTargetIds);
+    std::vector<size_t>().swap(batchTargetPositions);
+    std::vector<char>().swap(batchTargetData);
+    Metrics::addCounter("queries", dbSize);
+    Metrics::addCounter("alignments", alignmentsNum);
+    Metrics::addCounter("alignments_accepted", totalPassedNum);
+    Metrics::addCounter("alignments_rejected", alignmentsNum - totalPassedNum);
+
+    Metrics::startPhase("writing");
     dbw.close(merge);
+    Metrics::stopPhase("writing");
 
     Debug(Debug::INFO) << "\n" << alignmentsNum << " alignments calculated.\n";
     Debug(Debug::INFO) << totalPassedNum << " sequence pairs passed the thresholds ("
@@ -498,6 +574,86 @@ bool Alignment::checkCriteria(Matcher::result_t &res, bool isIdentity, double ev
     }
 }
 
+void Alignment::readTargetBatch(size_t start, size_t size) {
+    Timer timer;
+    batchTargetIds.clear();
+#pragma omp parallel num_threads(threads)
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        std::vector<size_t> threadIds;
+        char dbKeyBuffer[255 + 1];
+#pragma omp for schedule(dynamic, 10) nowait
+        for (size_t id = start; id < (start + size); id++) {
+            char *data = prefdbr->getData(id, thread_idx);
+            while (*data != '\0') {
+                Util::parseKey(data, dbKeyBuffer);
+                const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
+                const size_t dbId = tdbr->getId(dbKey);
+                if (dbId != UINT_MAX) {
+                    threadIds.push_back(dbId);
+                }
+                data = Util::skipLine(data);
+            }
+        }
+#pragma omp critical
+        batchTargetIds.insert(batchTargetIds.end(), threadIds.begin(), threadIds.end());
+    }
+    SORT_PARALLEL(batchTargetIds.begin(), batchTargetIds.end());
+    batchTargetIds.erase(std::unique(batchTargetIds.begin(), batchTargetIds.end()), batchTargetIds.end());
+
+    // lay out the targets in the order of their data offsets and copy them in that order
+    std::vector<std::pair<size_t, size_t>> readOrder(batchTargetIds.size());
+    for (size_t i = 0; i < batchTargetIds.size(); i++) {
+        readOrder[i] = std::make_pair(tdbr->getOffset(batchTargetIds[i]), i);
+    }
+    SORT_PARALLEL(readOrder.begin(), readOrder.end());
+    batchTargetPositions.resize(batchTargetIds.size());
+    size_t dataSize = 0;
+    for (size_t i = 0; i < readOrder.size(); i++) {
+        batchTargetPositions[readOrder[i].second] = dataSize;
+        dataSize += tdbr->getEntryLen(batchTargetIds[readOrder[i].second]);
+    }
+    batchTargetData.resize(dataSize);
+
+    // static chunks, every thread reads one contiguous range of the data file
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (size_t i = 0; i < readOrder.size(); i++) {
+        const size_t idx = readOrder[i].second;
+        memcpy(&batchTargetData[batchTargetPositions[idx]], tdbr->getDataUncompressed(batchTargetIds[idx]),
+               tdbr->getEntryLen(batchTargetIds[idx]));
+    }
+    Debug(Debug::INFO) << "Read " << batchTargetIds.size() << " target sequences (" << dataSize << " bytes) in " << timer.lap() << "\n";
+}
+
+char *Alignment::getTargetData(size_t dbId, unsigned int thread_idx) {
+    if (batchTargetIds.empty() == false) {
+        std::vector<size_t>::const_iterator it = std::lower_bound(batchTargetIds.begin(), batchTargetIds.end(), dbId);
+        if (it != batchTargetIds.end() && *it == dbId) {
+            return &batchTargetData[batchTargetPositions[it - batchTargetIds.begin()]];
+        }
+    }
+    return tdbr->getData(dbId, thread_idx);
+}
+
+void Alignment::prefetchTargetSequences(size_t id, unsigned int thread_idx, std::vector<size_t> &targetIds) {
+    targetIds.clear();
+    char *data = prefdbr->getData(id, thread_idx);
+    char dbKeyBuffer[255 + 1];
+    while (*data != '\0') {
+        Util::parseKey(data, dbKeyBuffer);
+        const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
+        const size_t dbId = tdbr->getId(dbKey);
+        if (dbId != UINT_MAX) {
+            targetIds.push_back(dbId);
+        }
+        data = Util::skipLine(data);
+    }
+    tdbr->prefetchData(targetIds);
+}
+
 void Alignment::computeAlternativeAlignment(unsigned int queryDbKey, Sequence &dbSeq,
                                             std::vector<Matcher::result_t> &swResults,
                                             Matcher &matcher, float evalThr, int swMode, int thread_idx) {
@@ -510,7 +666,7 @@ void Alignment::computeAlternativeAlignment(unsigned int queryDbKey, Sequence &d
             continue;
         }
         size_t dbId = tdbr->getId(swResults[i].dbKey);
-        char *dbSeqData = tdbr->getData(dbId, thread_idx);
+        char *dbSeqData = getTargetData(dbId, thread_idx);
         if (dbSeqData == NULL) {
             Debug(Debug::ERROR) << "Sequence " << swResults[i].dbKey <<" is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
             EXIT(EXIT_FAILURE);
@@ -80,6 +80,7 @@ private:
     unsigned int swMode;
     unsigned int threads;
     unsigned int compressed;
+    bool mpiDynamic;
 
     const std::string outDB;
     const std::string outDBIndex;
@@ -112,9 +113,24 @@ private:
     DBReader<unsigned int> *prefdbr;
 
     bool reversePrefilterResult;
+    // targets are not preloaded and page faults would block the alignment threads
+    bool prefetchTargets;
+
+    // targets of the current batch of queries, read in one sweep in data file order (--target-sweep-batch)
+    size_t targetSweepBatch;
+    // sorted target ids and the start of their data in batchTargetData
+    std::vector<size_t> batchTargetIds;
+    std::vector<size_t> batchTargetPositions;
+    std::vector<char> batchTargetData;
 
     static size_t estimateHDDMemoryConsumption(int dbSize, int maxSeqs);
 
+    void readTargetBatch(size_t start, size_t size);
+    char *getTargetData(size_t dbId, unsigned int thread_idx);
+
+    // asks the target reader to load the sequences of the prefiltering list of entry id in the background
+    void prefetchTargetSequences(size_t id, unsigned int thread_idx, std::vector<size_t> &targetIds);
+
     void computeAlternativeAlignment(unsigned int queryDbKey, Sequence &dbSeq,
                                      std::vector<Matcher::result_t> &vector, Matcher &matcher,
                                      float evalThr, int swMode, int thread_idx);
@@ -96,10 +96,8 @@ size_t MsaFilter::filter(const int N_in, const int L, const int coverage, const
     int seqid_step = 0;         // previous increment of seqid
 
     float diff_min_frac;  // minimum fraction of differing positions between sequence j and k needed to accept sequence k
-    float qdiff_max_frac = 0.9999 - 0.01 * qid;  // maximum allowable number of residues different from query sequence
     int diff = 0;  // number of differing positions between sequences j and k (counted so far)
     int diff_suff;  // number of differing positions between sequences j and k that would be sufficient
-    int qdiff_max;  // maximum number of residues required to be different from query
     int cov_kj;  // upper limit of number of positions where both sequence k and j have a residue
     int first_kj;             // first non-gap position in sequence j AND k
     int last_kj;              // last  non-gap position in sequence j AND k
@@ -194,67 +192,11 @@ size_t MsaFilter::filter(const int N_in, const int L, const int coverage, const
     for (k = 0; k < N_in; ++k) {
         if (keep[k] == 0 || keep[k] == 2)
             continue;  // seq k not regular sequence OR is marked sequence
-        if (100 * nres[k] < coverage * L) {
+        // coverage too low or too different from query? => reject once and for all
+        if (checkQueryCriteria(X[kfirst], X[k], first[k], last[k], nres[k], L, coverage, qid, qsc) == false) {
             keep[k] = 0;
             continue;
-        }  // coverage too low? => reject once and for all
-
-        float qsc_sum = 0.0;
-
-        // Check if score-per-column with query is at least qsc
-        if (qsc > -10) {
-            float qsc_min = qsc * nres[k];  // minimum total score of seq k with query
-
-            int gapq = 0, gapk = 0;  // number of consecutive gaps in query or k'th sequence at position i
-            for (int i = first[k]; i <= last[k]; ++i) {
-                if (X[k][i] < 20) {
-                    gapk = 0;
-                    if (X[kfirst][i] < 20) {
-                        gapq = 0;
-                        qsc_sum += static_cast<float>(m->subMatrix[(int) X[kfirst][i]][(int) X[k][i]]);
-                    } else if (X[kfirst][i] == MultipleAlignment::ANY)
-                        // Treat score of X with other amino acid as 0.0
-                        continue;
-                    else if (gapq++)
-                        qsc_sum -= PLTY_GAPEXTD;
-                    else
-                        qsc_sum -= PLTY_GAPOPEN;
-                } else if (X[k][i] == MultipleAlignment::ANY)
-                    // Treat score of X with other amino acid as 0.0
-                    continue;
-                else if (X[kfirst][i] < 20) {
-                    gapq = 0;
-                    if (gapk++)
-                        qsc_sum -= PLTY_GAPEXTD;
-                    else
-                        qsc_sum -= PLTY_GAPOPEN;
-                }
-            }
-//        printf("k=%3i qsc=%6.2f\n",k,qsc_sum);
-            if (qsc_sum < qsc_min) {
-                keep[k] = 0;
-                continue;
-            }  // too different from query? => reject once and for all
-        }
-//                  printf("  diff=%4i\n",diff);
-        //Check if sequence similarity with query at least qid?
-        if (qdiff_max_frac < 0.999) {
-
-            qdiff_max = int(qdiff_max_frac * nres[k] + 0.9999);
-//                  printf("k=%-4i  nres=%-4i  qdiff_max=%-4i first=%-4i last=%-4i",k,nres[k],qdiff_max,first[k],last[k]);
-            diff = 0;
-            for (int i = first[k]; i <= last[k]; ++i)
-                // enough different residues to reject based on minimum qid with query? => break
-                if (X[k][i] < MultipleAlignment::NAA
-                    && X[k][i] != X[kfirst][i] && ++diff >= qdiff_max)
-                    break;
-//                  printf("  diff=%4i\n",diff);
-            if (diff >= qdiff_max) {
-                keep[k] = 0;
-                continue;
-            }  // too different from query? => reject once and for all
         }
-        // printf("%d  qsc=%6.2f  %d  %d qid=%6.2f  \n",k,qsc_sum/nres[k],nres[k], diff, 100.0*(1.0-(float)(diff)/nres[k]));
     }
 
     // If no sequence left, issue warning and put back first real sequence into alignment
@@ -510,6 +452,82 @@ void MsaFilter::getKept(bool *kept, size_t setSize) {
     }
 }
 
+bool MsaFilter::keepSequence(const char *query, const char *X, const int L, const int coverage, const int qid, const float qsc) {
+    int first;
+    for (first = 0; first < L; ++first)
+        if (X[first] < MultipleAlignment::NAA)
+            break;
+    int last;
+    for (last = (L - 1); last > 0; last--)
+        if (X[last] < MultipleAlignment::NAA)
+            break;
+    int nres = 0;
+    for (int i = first; i <= last; ++i)
+        if (X[i] < MultipleAlignment::NAA)
+            nres++;
+    if (nres == 0) {
+        return false;
+    }
+    return checkQueryCriteria(query, X, first, last, nres, L, coverage, qid, qsc);
+}
+
+bool MsaFilter::checkQueryCriteria(const char *query, const char *X, const int first, const int last, const int nres,
+                                   const int L, const int coverage, const int qid, const float qsc) {
+    // coverage too low?
+    if (100 * nres < coverage * L) {
+        return false;
+    }
+
+    // Check if score-per-column with query is at least qsc
+    if (qsc > -10) {
+        float qsc_min = qsc * nres;  // minimum total score of seq k with query
+        float qsc_sum = 0.0;
+        int gapq = 0, gapk = 0;  // number of consecutive gaps in query or k'th sequence at position i
+        for (int i = first; i <= last; ++i) {
+            if (X[i] < 20) {
+                gapk = 0;
+                if (query[i] < 20) {
+                    gapq = 0;
+                    qsc_sum += static_cast<float>(m->subMatrix[(int) query[i]][(int) X[i]]);
+                } else if (query[i] == MultipleAlignment::ANY)
+                    // Treat score of X with other amino acid as 0.0
+                    continue;
+                else if (gapq++)
+                    qsc_sum -= PLTY_GAPEXTD;
+                else
+                    qsc_sum -= PLTY_GAPOPEN;
+            } else if (X[i] == MultipleAlignment::ANY)
+                // Treat score of X with other amino acid as 0.0
+                continue;
+            else if (query[i] < 20) {
+                gapq = 0;
+                if (gapk++)
+                    qsc_sum -= PLTY_GAPEXTD;
+                else
+                    qsc_sum -= PLTY_GAPOPEN;
+            }
+        }
+        if (qsc_sum < qsc_min) {
+            return false;
+        }
+    }
+
+    //Check if sequence similarity with query at least qid?
+    float qdiff_max_frac = 0.9999 - 0.01 * qid;  // maximum allowable number of residues different from query sequence
+    if (qdiff_max_frac < 0.999) {
+        int qdiff_max = int(qdiff_max_frac * nres + 0.9999);
+        int diff = 0;
+        for (int i = first; i <= last; ++i)
+            // enough different residues to reject based on minimum qid with query? => break
+            if (X[i] < MultipleAlignment::NAA && X[i] != query[i] && ++diff >= qdiff_max)
+                break;
+        if (diff >= qdiff_max) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void MsaFilter::pruneAlignment(char ** msaSequence, int N_in, int L) {
     int   bg = 5;  // below this number of end gaps the loose HSP pruning score is used
     float bl = 0.0;   // minimum per-residue bit score with query at ends of HSP for loose end pruning
@@ -40,6 +40,10 @@ public:
 
     void getKept(bool *offsets, size_t setSize);
 
+    // Applies only the query-dependent criteria of filter() (coverage, qid and qsc) to a single MSA row.
+    // These do not depend on the other members, so they can be decided while streaming the MSA.
+    bool keepSequence(const char *query, const char *X, const int L, const int coverage, const int qid, const float qsc);
+
     const float PLTY_GAPOPEN; // for -qsc option (filter for min similarity to query): 6 bits to open gap
     const float PLTY_GAPEXTD; // for -qsc option (filter for min similarity to query): 1 bit to extend gap
 
@@ -50,6 +54,10 @@ private:
     // shuffles the filtered sequences to the back of the array, the unfiltered ones remain in the front
     void shuffleSequences(const char ** X, size_t setSize);
 
+    // coverage, qsc and qid criteria of a sequence against the query, shared by filter() and keepSequence()
+    bool checkQueryCriteria(const char *query, const char *X, const int first, const int last, const int nres,
+                            const int L, const int coverage, const int qid, const float qsc);
+
     // prune sequence based on score
     int prune(int start, int end, float b, char * query, char *target);
 
@@ -44,6 +44,49 @@ void MultipleAlignment::print(MSAResult msaResult, SubstitutionMatrix * subMat){
     }
 }
 
+void MultipleAlignment::computeNoDeletionRow(char *msaRow, size_t centerLength, const unsigned char *edgeSeq,
+                                             const Matcher::result_t &alignment) {
+    std::fill(msaRow, msaRow + centerLength, GAP);
+    // score was 0 and sequence was rejected, keep the row empty
+    if (alignment.dbStartPos < 0 || alignment.qStartPos < 0) {
+        return;
+    }
+    const std::string &bt = alignment.backtrace;
+    size_t queryPos = alignment.qStartPos;
+    size_t targetPos = alignment.dbStartPos;
+    size_t count = 0;
+    bool hasCount = false;
+    for (size_t i = 0; i < bt.size(); ++i) {
+        const char state = bt[i];
+        if (isdigit(state)) {
+            count = count * 10 + (state - '0');
+            hasCount = true;
+            continue;
+        }
+        // uncompressed backtraces contain one state per column
+        if (hasCount == false) {
+            count = 1;
+        }
+        switch (state) {
+            case 'M':
+                for (size_t j = 0; j < count && queryPos < centerLength; ++j) {
+                    msaRow[queryPos++] = static_cast<char>(edgeSeq[targetPos++]);
+                }
+                break;
+            case 'I':
+                queryPos += count;
+                break;
+            case 'D':
+                targetPos += count;
+                break;
+            default:
+                break;
+        }
+        count = 0;
+        hasCount = false;
+    }
+}
+
 void MultipleAlignment::computeQueryGaps(unsigned int *queryGaps, Sequence *centerSeq, size_t edges, const std::vector<Matcher::result_t>& alignmentResults) {
     // init query gaps
     memset(queryGaps, 0, sizeof(unsigned int) * centerSeq->L);
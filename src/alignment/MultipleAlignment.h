@@ -38,6 +38,12 @@ public:
 
     static void print(MSAResult msaResult, SubstitutionMatrix * subMat);
 
+    // writes the row of a single edge sequence of a MSA without deletions (as computeMSA with noDeletionMSA)
+    // into msaRow (centerLength elements, GAP for unaligned columns). Accepts compressed (e.g. 3M1I2M) and
+    // uncompressed backtraces, so members can be processed one by one without materializing the full MSA
+    static void computeNoDeletionRow(char *msaRow, size_t centerLength, const unsigned char *edgeSeq,
+                                     const Matcher::result_t &alignment);
+
     // init aligned memory for the MSA
     static char *initX(int len);
 
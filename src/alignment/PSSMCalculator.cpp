@@ -38,6 +38,10 @@ PSSMCalculator::PSSMCalculator(BaseMatrix *subMat, size_t maxSeqLength, size_t m
     }
     this->pca = pca;
     this->pcb = pcb;
+    streamCounts = new int[(maxSeqLength + 1) * Sequence::PROFILE_AA_SIZE];
+    columnWeight = new float[maxSeqLength + 1];
+    streamLength = 0;
+    streamWeightSum = 0.0f;
 }
 
 PSSMCalculator::~PSSMCalculator() {
@@ -55,6 +59,8 @@ PSSMCalculator::~PSSMCalculator() {
     free(n_backing);
     delete[] n;
     free(f);
+    delete[] streamCounts;
+    delete[] columnWeight;
 }
 
 PSSMCalculator::Profile PSSMCalculator::computePSSMFromMSA(size_t setSize,
@@ -74,6 +80,10 @@ PSSMCalculator::Profile PSSMCalculator::computePSSMFromMSA(size_t setSize,
         // compute NEFF_M
         computeNeff_M(matchWeight, seqWeight, Neff_M, queryLength, setSize, msaSeqs);
     }
+    return computePSSMFromMatchWeights(queryLength);
+}
+
+PSSMCalculator::Profile PSSMCalculator::computePSSMFromMatchWeights(size_t queryLength) {
     // compute consensus sequence
     std::string consensusSequence = computeConsensusSequence(matchWeight, queryLength, subMat->pBack, subMat->num2aa);
     if(pca > 0.0){
@@ -96,6 +106,74 @@ PSSMCalculator::Profile PSSMCalculator::computePSSMFromMSA(size_t setSize,
     return Profile(pssm, profile, Neff_M, consensusSequence);
 }
 
+void PSSMCalculator::initStreaming(size_t queryLength) {
+    streamLength = queryLength;
+    streamWeightSum = 0.0f;
+    streamResidues.clear();
+    memset(streamCounts, 0, queryLength * Sequence::PROFILE_AA_SIZE * sizeof(int));
+    memset(matchWeight, 0, queryLength * Sequence::PROFILE_AA_SIZE * sizeof(float));
+    memset(columnWeight, 0, queryLength * sizeof(float));
+}
+
+void PSSMCalculator::countStreamingRow(const char *msaRow) {
+    unsigned int nr = 0;
+    for (size_t pos = 0; pos < streamLength; pos++) {
+        if (msaRow[pos] != MultipleAlignment::GAP) {
+            nr++;
+            const unsigned int aa_pos = msaRow[pos];
+            if (aa_pos < Sequence::PROFILE_AA_SIZE) {
+                streamCounts[pos * Sequence::PROFILE_AA_SIZE + aa_pos]++;
+            }
+        }
+    }
+    streamResidues.emplace_back(nr);
+}
+
+void PSSMCalculator::addStreamingRow(size_t rowIdx, const char *msaRow) {
+    if (rowIdx == 0) {
+        // all rows are counted, compute the number of distinct amino acids per column
+        for (size_t pos = 0; pos < streamLength; pos++) {
+            int distinct_aa_count = 0;
+            for (size_t aa = 0; aa < Sequence::PROFILE_AA_SIZE; ++aa) {
+                if (streamCounts[pos * Sequence::PROFILE_AA_SIZE + aa]) {
+                    ++distinct_aa_count;
+                }
+            }
+            naa[pos] = distinct_aa_count;
+        }
+    }
+    // "Position-based Sequence Weights", Henikoff (1994), see computeSequenceWeights
+    float weight = 1e-6;
+    const float residues = static_cast<float>(streamResidues[rowIdx]) + 30.0f;
+    for (size_t pos = 0; pos < streamLength; pos++) {
+        const unsigned int aa_pos = msaRow[pos];
+        if (aa_pos < Sequence::PROFILE_AA_SIZE && naa[pos] != 0) {
+            weight += 1.0f / (float(streamCounts[pos * Sequence::PROFILE_AA_SIZE + aa_pos]) * float(naa[pos]) * residues);
+        }
+    }
+    // matchWeight is normalized per column later, the scale of the sequence weights does not matter
+    for (size_t pos = 0; pos < streamLength; pos++) {
+        if (msaRow[pos] != MultipleAlignment::GAP) {
+            const unsigned int aa_pos = msaRow[pos];
+            if (aa_pos < Sequence::PROFILE_AA_SIZE) {
+                matchWeight[pos * Sequence::PROFILE_AA_SIZE + aa_pos] += weight;
+            }
+            columnWeight[pos] += weight;
+        }
+    }
+    streamWeightSum += weight;
+}
+
+PSSMCalculator::Profile PSSMCalculator::computePSSMFromStreaming() {
+    const size_t setSize = streamResidues.size();
+    for (size_t pos = 0; pos < streamLength; pos++) {
+        MathUtil::NormalizeTo1(&matchWeight[pos * Sequence::PROFILE_AA_SIZE], Sequence::PROFILE_AA_SIZE, subMat->pBack);
+        columnWeight[pos] = -1.0f / setSize + columnWeight[pos] / streamWeightSum;
+    }
+    computeNeff_MFromColumnWeights(matchWeight, columnWeight, Neff_M, streamLength);
+    return computePSSMFromMatchWeights(streamLength);
+}
+
 void PSSMCalculator::printProfile(size_t queryLength) {
     printf("Pos");
     for (size_t aa = 0; aa < Sequence::PROFILE_AA_SIZE; aa++) {
@@ -158,6 +236,19 @@ void PSSMCalculator::preparePseudoCounts(float *frequency, float *frequency_with
 }
 void PSSMCalculator::computeNeff_M(float *frequency, float *seqWeight, float *Neff_M,
                                    size_t queryLength, size_t setSize, char const **msaSeqs) {
+    for (size_t pos = 0; pos < queryLength; pos++) {
+        float w_M = -1.0 / setSize;
+        for (size_t k = 0; k < setSize; ++k){
+            if ( msaSeqs[k][pos] != MultipleAlignment::GAP) {
+                w_M += seqWeight[k];
+            }
+        }
+        columnWeight[pos] = w_M;
+    }
+    computeNeff_MFromColumnWeights(frequency, columnWeight, Neff_M, queryLength);
+}
+
+void PSSMCalculator::computeNeff_MFromColumnWeights(float *frequency, const float *w_M, float *Neff_M, size_t queryLength) {
     float Neff_HMM = 0.0f;
     for (size_t pos = 0; pos < queryLength; pos++) {
         float sum = 0.0f;
@@ -173,13 +264,7 @@ void PSSMCalculator::computeNeff_M(float *frequency, float *seqWeight, float *Ne
     float Nlim = fmax(10.0, Neff_HMM + 1.0);    // limiting Neff
     float scale = MathUtil::flog2((Nlim - Neff_HMM) / (Nlim - 1.0));  // for calculating Neff for those seqs with inserts at specific pos
     for (size_t pos = 0; pos < queryLength; pos++) {
-        float w_M = -1.0 / setSize;
-        for (size_t k = 0; k < setSize; ++k){
-            if ( msaSeqs[k][pos] != MultipleAlignment::GAP) {
-                w_M += seqWeight[k];
-            }
-        }
-        Neff_M[pos] = (w_M < 0) ? 1.0 : Nlim - (Nlim - 1.0) * MathUtil::fpow2(scale * w_M);
+        Neff_M[pos] = (w_M[pos] < 0) ? 1.0 : Nlim - (Nlim - 1.0) * MathUtil::fpow2(scale * w_M[pos]);
 //        fprintf(stderr,"M  i=%3i  ncol=---  Neff_M=%5.2f  Nlim=%5.2f  w_M=%5.3f  Neff_M=%5.2f\n",pos,Neff_HMM,Nlim,w_M,Neff_M[pos]);
     }
 }
@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <string>
+#include <vector>
 
 class BaseMatrix;
 class Sequence;
@@ -27,6 +28,14 @@ public:
     Profile computePSSMFromMSA(size_t setSize, size_t queryLength, const char **msaSeqs,
                                     bool wg);
 
+    // Streaming variant of computePSSMFromMSA with global sequence weighting (wg) that never holds the MSA.
+    // Every row (query first) has to be passed twice: to countStreamingRow, and after all rows were counted,
+    // in the same order to addStreamingRow. Memory is O(queryLength * alphabet) and one counter per row.
+    void initStreaming(size_t queryLength);
+    void countStreamingRow(const char *msaRow);
+    void addStreamingRow(size_t rowIdx, const char *msaRow);
+    Profile computePSSMFromStreaming();
+
     void printProfile(size_t queryLength);
     void printPSSM(size_t queryLength);
 
@@ -83,6 +92,13 @@ private:
     size_t maxSeqLength;
     size_t maxSetSize;
 
+    // streaming state: residue counts per column and amino acid, residues per row
+    int *streamCounts;
+    float *columnWeight;
+    std::vector<unsigned int> streamResidues;
+    size_t streamLength;
+    float streamWeightSum;
+
     // compute position-specific scoring matrix PSSM score
     // 1.) convert PFM to PPM (position probability matrix)
     //     Both PPMs assume statistical independence between positions in the pattern
@@ -93,6 +109,12 @@ private:
     // compute the Neff_M per column -p log(p)
     void computeNeff_M(float *frequency, float *seqWeight, float *Neff_M, size_t queryLength, size_t setSize, char const **msaSeqs);
 
+    // compute Neff_M given the summed weight of sequences with a residue per column (minus 1/setSize)
+    void computeNeff_MFromColumnWeights(float *frequency, const float *w_M, float *Neff_M, size_t queryLength);
+
+    // consensus, pseudocounts and log-odds from the already computed matchWeight and Neff_M
+    Profile computePSSMFromMatchWeights(size_t queryLength);
+
     void computeMatchWeights(float * matchWeight, float * seqWeight, size_t setSize, size_t queryLength, const char **msaSeqs);
 
     void computeContextSpecificWeights(float * matchWeight, float *seqWeight, float * Neff_M, size_t queryLength, size_t setSize, const char **msaSeqs);
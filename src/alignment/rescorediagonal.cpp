@@ -12,6 +12,7 @@
 #include "NucleotideMatrix.h"
 #include "IndexReader.h"
 #include "FastSort.h"
+#include "Metrics.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -113,6 +114,7 @@ int doRescorediagonal(Parameters &par,
     }
     size_t iterations = static_cast<int>(ceil(static_cast<double>(dbSize) / static_cast<double>(flushSize)));
 
+    Metrics::startPhase("ungapped_alignment");
     for (size_t i = 0; i < iterations; i++) {
         size_t start = dbFrom + (i * flushSize);
         size_t bucketSize = std::min(dbSize - (i * flushSize), flushSize);
@@ -356,6 +358,8 @@ int doRescorediagonal(Parameters &par,
         }
         resultReader.remapData();
     }
+    Metrics::stopPhase("ungapped_alignment");
+    Metrics::addCounter("queries", dbSize);
 
 
     if (tDbrIdx != NULL) {
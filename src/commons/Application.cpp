@@ -3,6 +3,8 @@
 #include "Command.h"
 #include "DistanceCalculator.h"
 #include "Timer.h"
+#include "Metrics.h"
+#include "Parameters.h"
 
 #include <iomanip>
 
@@ -36,6 +38,10 @@ Command *getCommandByName(const char *s) {
 int runCommand(Command *p, int argc, const char **argv) {
     Timer timer;
     int status = p->commandFunction(argc, argv, *p);
+    Parameters &par = Parameters::getInstance();
+    if (status == EXIT_SUCCESS && par.metricsFile.empty() == false && MMseqsMPI::isMaster()) {
+        Metrics::write(par.metricsFile, p->cmd, timer.getTimediff());
+    }
     Debug(Debug::INFO) << "Time for processing: " << timer.lap() << "\n";
     return status;
 }
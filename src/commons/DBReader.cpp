@@ -26,7 +26,7 @@ DBReader<T>::DBReader(const char* dataFileName_, const char* indexFileName_, int
 threads(threads), dataMode(dataMode), dataFileName(strdup(dataFileName_)),
         indexFileName(strdup(indexFileName_)), size(0), dataFiles(NULL), dataSizeOffset(NULL), dataFileCnt(0),
         totalDataSize(0), dataSize(0), lastKey(T()), closed(1), dbtype(Parameters::DBTYPE_GENERIC_DB),
-        compressedBuffers(NULL), compressedBufferSizes(NULL), index(NULL), id2local(NULL), local2id(NULL),
+        compressedBuffers(NULL), compressedBufferSizes(NULL), ddict(NULL), index(NULL), id2local(NULL), local2id(NULL),
         dataMapped(false), accessType(0), externalData(false), didMlock(false)
 {}
 
@@ -35,7 +35,7 @@ DBReader<T>::DBReader(DBReader<T>::Index *index, size_t size, size_t dataSize, T
         int dbType, unsigned int maxSeqLen, int threads) :
         threads(threads), dataMode(USE_INDEX), dataFileName(NULL), indexFileName(NULL),
         size(size), dataFiles(NULL), dataSizeOffset(NULL), dataFileCnt(0), totalDataSize(0), dataSize(dataSize), lastKey(lastKey),
-        maxSeqLen(maxSeqLen), closed(1), dbtype(dbType), compressedBuffers(NULL), compressedBufferSizes(NULL), index(index), sortedByOffset(true),
+        maxSeqLen(maxSeqLen), closed(1), dbtype(dbType), compressedBuffers(NULL), compressedBufferSizes(NULL), ddict(NULL), index(index), sortedByOffset(true),
         id2local(NULL), local2id(NULL), dataMapped(false), accessType(NOSORT), externalData(true), didMlock(false)
 {}
 
@@ -209,6 +209,16 @@ template <typename T> bool DBReader<T>::open(int accessType){
                 EXIT(EXIT_FAILURE);
             }
         }
+        std::string dictFile = (dataFileName != NULL) ? std::string(dataFileName) + ".zdict" : "";
+        if (dictFile.empty() == false && FileUtil::fileExists(dictFile.c_str())) {
+            MemoryMapped dictData(dictFile, MemoryMapped::WholeFile, MemoryMapped::SequentialScan);
+            if (!dictData.isValid()) {
+                Debug(Debug::ERROR) << "Can not open dictionary file " << dictFile << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            setDictionary((const char *) dictData.getData(), dictData.size());
+            dictData.close();
+        }
     }
 
     closed = 0;
@@ -494,6 +504,10 @@ template <typename T> void DBReader<T>::close(){
         delete [] compressedBufferSizes;
         delete [] dstream;
     }
+    if (ddict != NULL) {
+        ZSTD_freeDDict(ddict);
+        ddict = NULL;
+    }
 
     if(externalData == false) {
         delete[] index;
@@ -519,6 +533,9 @@ template <typename T> char* DBReader<T>::getDataCompressed(size_t id, int thrIdx
     const char *dataStart = data + sizeof(unsigned int);
     bool isCompressed = (dataStart[cSize] == 0) ? true : false;
     if(isCompressed){
+        if (ddict != NULL) {
+            ZSTD_initDStream_usingDDict(dstream[thrIdx], ddict);
+        }
         ZSTD_inBuffer input = {cBuff, cSize, 0};
         while (input.pos < input.size) {
             ZSTD_outBuffer output = {compressedBuffers[thrIdx], compressedBufferSizes[thrIdx], 0};
@@ -603,6 +620,50 @@ void DBReader<T>::touchData(size_t id) {
     }
 }
 
+template <typename T>
+void DBReader<T>::prefetchData(const std::vector<size_t> &ids) {
+#ifdef HAVE_POSIX_MADVISE
+    if (dataMapped == false || ids.empty()) {
+        return;
+    }
+    const size_t pageSize = Util::getPageSize();
+    // page aligned (file, start, end) ranges, neighbouring entries are advised together
+    std::vector<std::pair<size_t, std::pair<size_t, size_t>>> ranges;
+    ranges.reserve(ids.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (ids[i] >= size) {
+            continue;
+        }
+        const size_t idx = (local2id != NULL) ? local2id[ids[i]] : ids[i];
+        const size_t offset = index[idx].offset;
+        size_t cnt = 0;
+        while ((offset >= dataSizeOffset[cnt] && offset < dataSizeOffset[cnt+1]) == false) {
+            cnt++;
+        }
+        const size_t fileOffset = offset - dataSizeOffset[cnt];
+        ranges.emplace_back(cnt, std::make_pair(fileOffset - (fileOffset % pageSize), fileOffset + index[idx].length));
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    size_t i = 0;
+    while (i < ranges.size()) {
+        const size_t cnt = ranges[i].first;
+        const size_t start = ranges[i].second.first;
+        size_t end = ranges[i].second.second;
+        i++;
+        while (i < ranges.size() && ranges[i].first == cnt && ranges[i].second.first <= end) {
+            end = std::max(end, ranges[i].second.second);
+            i++;
+        }
+        end = std::min(end, dataSizeOffset[cnt + 1] - dataSizeOffset[cnt]);
+        // only a hint, failures are not fatal
+        posix_madvise(dataFiles[cnt] + start, end - start, POSIX_MADV_WILLNEED);
+    }
+#else
+    (void) ids;
+#endif
+}
+
 template <typename T> char* DBReader<T>::getDataByDBKey(T dbKey, int thrIdx) {
     size_t id = getId(dbKey);
     if(compression == COMPRESSED ){
@@ -940,6 +1001,18 @@ DBReader<unsigned int> *DBReader<unsigned int>::unserialize(const char* data, in
     return new DBReader<unsigned int>(idx, size, dataSize, lastKey, dbType, maxSeqLen, threads);
 }
 
+template<typename T>
+void DBReader<T>::setDictionary(const char *dictData, size_t dictSize) {
+    if (ddict != NULL) {
+        ZSTD_freeDDict(ddict);
+    }
+    ddict = ZSTD_createDDict(dictData, dictSize);
+    if (ddict == NULL) {
+        Debug(Debug::ERROR) << "ZSTD_createDDict() error\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
 template<typename T>
 void DBReader<T>::setData(char *data, size_t dataSize) {
     if(dataFiles == NULL){
@@ -1064,6 +1137,9 @@ void DBReader<T>::moveDb(const std::string &srcDbName, const std::string &dstDbN
     if (FileUtil::fileExists((srcDbName + ".lookup").c_str())) {
         FileUtil::move((srcDbName + ".lookup").c_str(), (dstDbName + ".lookup").c_str());
     }
+    if (FileUtil::fileExists((srcDbName + ".zdict").c_str())) {
+        FileUtil::move((srcDbName + ".zdict").c_str(), (dstDbName + ".zdict").c_str());
+    }
 }
 
 template<typename T>
@@ -1088,6 +1164,10 @@ void DBReader<T>::removeDb(const std::string &databaseName){
     if (FileUtil::fileExists(lookupFile.c_str())) {
         FileUtil::remove(lookupFile.c_str());
     }
+    std::string dictFile = databaseName + ".zdict";
+    if (FileUtil::fileExists(dictFile.c_str())) {
+        FileUtil::remove(dictFile.c_str());
+    }
 }
 
 void copyLinkDb(const std::string &databaseName, const std::string &outDb, DBFiles::Files dbFilesFlags, bool link) {
@@ -1130,6 +1210,8 @@ void copyLinkDb(const std::string &databaseName, const std::string &outDb, DBFil
         { DBFiles::HEADER,        "_h"                },
         { DBFiles::HEADER_INDEX,  "_h.index"          },
         { DBFiles::HEADER_DBTYPE, "_h.dbtype"         },
+        { DBFiles::DATA_ZDICT,    ".zdict"            },
+        { DBFiles::HEADER_ZDICT,  "_h.zdict"          },
         { DBFiles::LOOKUP,        ".lookup"           },
         { DBFiles::SOURCE,        ".source"           },
         { DBFiles::TAX_MAPPING,   "_mapping"          },
@@ -1169,6 +1251,13 @@ void DBReader<T>::copyDb(const std::string &databaseName, const std::string &out
 
 template<typename T>
 void DBReader<T>::decomposeDomainByAminoAcid(size_t worldRank, size_t worldSize, size_t *startEntry, size_t *numEntries){
+    std::vector<std::pair<size_t, size_t>> domains = decomposeDomainByAminoAcid(worldSize);
+    *startEntry = domains[worldRank].first;
+    *numEntries = domains[worldRank].second;
+}
+
+template<typename T>
+std::vector<std::pair<size_t, size_t>> DBReader<T>::decomposeDomainByAminoAcid(size_t worldSize){
     const size_t dataSize = getDataSize();
     const size_t dbEntries = getSize();
     if (worldSize > dataSize) {
@@ -1177,39 +1266,37 @@ void DBReader<T>::decomposeDomainByAminoAcid(size_t worldRank, size_t worldSize,
         EXIT(EXIT_FAILURE);
     }
 
+    std::vector<std::pair<size_t, size_t>> domains(worldSize, std::make_pair(0, 0));
     if (worldSize == 1) {
-        *startEntry = 0;
-        *numEntries = dbEntries;
-        return;
+        domains[0].second = dbEntries;
+        return domains;
     }
 
     if (dbEntries <= worldSize) {
-        *startEntry = worldRank < dbEntries ? worldRank : 0;
-        *numEntries = worldRank < dbEntries ? 1 : 0;
-        return;
+        for (size_t rank = 0; rank < dbEntries; ++rank) {
+            domains[rank] = std::make_pair(rank, 1);
+        }
+        return domains;
     }
 
     size_t chunkSize = ceil(static_cast<double>(dataSize) / static_cast<double>(worldSize));
 
-    size_t *entriesPerWorker = (size_t*)calloc(worldSize, sizeof(size_t));
-
     size_t currentRank = 0;
     size_t sumCharsAssignedToCurrRank = 0;
     for (size_t i = 0; i < dbEntries; ++i) {
         if (sumCharsAssignedToCurrRank >= chunkSize) {
             sumCharsAssignedToCurrRank = 0;
             currentRank++;
+            domains[currentRank].first = i;
         }
         sumCharsAssignedToCurrRank += index[i].length;
-        entriesPerWorker[currentRank] += 1;
+        domains[currentRank].second += 1;
     }
-
-    *startEntry = 0;
-    *numEntries = entriesPerWorker[worldRank];
-    for (size_t j = 0; j < worldRank; ++j) {
-        *startEntry += entriesPerWorker[j];
+    for (size_t rank = currentRank + 1; rank < worldSize; ++rank) {
+        domains[rank].first = dbEntries;
     }
-    free(entriesPerWorker);
+
+    return domains;
 }
 
 template class DBReader<unsigned int>;
@@ -38,10 +38,12 @@ struct DBFiles {
         CA3M_SEQ_IDX      = (1ull << 15),
         CA3M_HDR          = (1ull << 16),
         CA3M_HDR_IDX      = (1ull << 17),
+        DATA_ZDICT        = (1ull << 18),
+        HEADER_ZDICT      = (1ull << 19),
 
 
-        GENERIC           = DATA | DATA_INDEX | DATA_DBTYPE,
-        HEADERS           = HEADER | HEADER_INDEX | HEADER_DBTYPE,
+        GENERIC           = DATA | DATA_INDEX | DATA_DBTYPE | DATA_ZDICT,
+        HEADERS           = HEADER | HEADER_INDEX | HEADER_DBTYPE | HEADER_ZDICT,
         TAXONOMY          = TAX_MAPPING | TAX_NAMES | TAX_NODES | TAX_MERGED,
         SEQUENCE_DB       = GENERIC | HEADERS | TAXONOMY | LOOKUP | SOURCE,
         SEQUENCE_ANCILLARY= SEQUENCE_DB & (~GENERIC),
@@ -161,6 +163,10 @@ public:
 
     void touchData(size_t id);
 
+    // starts reading the pages of the given entries in the background if the data is mapped,
+    // so that a later getData does not block on a page fault
+    void prefetchData(const std::vector<size_t> &ids);
+
     char* getDataByDBKey(T key, int thrIdx);
 
     char * getDataByOffset(size_t offset);
@@ -324,6 +330,9 @@ public:
 
     static DBReader<unsigned int> *unserialize(const char* data, int threads);
 
+    // sets the zstd dictionary of the compressed entries, needed by readers without a data file (e.g. unserialized ones)
+    void setDictionary(const char *dictData, size_t dictSize);
+
     int getDbtype(){
         return dbtype;
     }
@@ -400,6 +409,9 @@ public:
 
     void decomposeDomainByAminoAcid(size_t worldRank, size_t worldSize, size_t *startEntry, size_t *numEntries);
 
+    // computes the (start entry, number of entries) pairs of all ranks at once
+    std::vector<std::pair<size_t, size_t>> decomposeDomainByAminoAcid(size_t worldSize);
+
 private:
     void checkClosed() const;
 
@@ -435,6 +447,8 @@ private:
     char ** compressedBuffers;
     size_t * compressedBufferSizes;
     ZSTD_DStream ** dstream;
+    // trained zstd dictionary of the database (<data>.zdict), NULL if entries were compressed without one
+    ZSTD_DDict * ddict;
 
     Index * index;
     size_t lookupSize;
@@ -13,6 +13,8 @@
 #include <sstream>
 #include <unistd.h>
 
+#include <dictBuilder/zdict.h>
+
 #ifdef OPENMP
 #include <omp.h>
 #endif
@@ -31,6 +33,7 @@ DBWriter::DBWriter(const char *dataFileName_, const char *indexFileName_, unsign
     indexFileNames = new char *[threads];
     compressedBuffers=NULL;
     compressedBufferSizes=NULL;
+    cdict = NULL;
     if((mode & Parameters::WRITER_COMPRESSED_MODE) != 0){
         compressedBuffers = new char*[threads];
         compressedBufferSizes = new size_t[threads];
@@ -90,6 +93,38 @@ DBWriter::~DBWriter() {
         delete [] cstream;
         delete [] state;
     }
+    if (cdict != NULL) {
+        ZSTD_freeCDict(cdict);
+    }
+}
+
+void DBWriter::setDictionary(const std::string &dictionary) {
+    if (cdict != NULL) {
+        ZSTD_freeCDict(cdict);
+        cdict = NULL;
+    }
+    this->dictionary = dictionary;
+    if (dictionary.empty()) {
+        return;
+    }
+    cdict = ZSTD_createCDict(dictionary.c_str(), dictionary.size(), COMPRESSION_LEVEL);
+    if (cdict == NULL) {
+        Debug(Debug::ERROR) << "ZSTD_createCDict() error\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
+std::string DBWriter::trainDictionary(const std::string &samples, const std::vector<size_t> &sampleSizes) {
+    const size_t maxSize = MAX_DICTIONARY_SIZE;
+    const size_t capacity = std::min(maxSize, std::max(samples.size() / 100, static_cast<size_t>(1024)));
+    std::string dictionary(capacity, '\0');
+    size_t dictSize = ZDICT_trainFromBuffer(&dictionary[0], capacity, samples.c_str(), sampleSizes.data(), static_cast<unsigned int>(sampleSizes.size()));
+    if (ZDICT_isError(dictSize)) {
+        Debug(Debug::WARNING) << "Can not train compression dictionary: " << ZDICT_getErrorName(dictSize) << "\n";
+        return std::string();
+    }
+    dictionary.resize(dictSize);
+    return dictionary;
 }
 
 void DBWriter::sortDatafileByIdOrder(DBReader<unsigned int> &dbr) {
@@ -207,6 +242,31 @@ void DBWriter::writeDbtypeFile(const char* path, int dbtype, bool isCompressed)
 }
 
 
+void DBWriter::writeDictionaryFile() {
+    std::string name = std::string(dataFileName) + ".zdict";
+    // writers of raw entries copy the compressed data of another database, its dictionary is linked by the caller
+    if ((mode & Parameters::WRITER_COMPRESSED_MODE) == 0) {
+        return;
+    }
+    if (cdict == NULL) {
+        // a stale dictionary of a previous database would break the decompression
+        if (FileUtil::fileExists(name.c_str())) {
+            FileUtil::remove(name.c_str());
+        }
+        return;
+    }
+    FILE* file = FileUtil::openAndDelete(name.c_str(), "wb");
+    size_t written = fwrite(dictionary.c_str(), sizeof(char), dictionary.size(), file);
+    if (written != dictionary.size()) {
+        Debug(Debug::ERROR) << "Can not write to dictionary file " << name << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (fclose(file) != 0) {
+        Debug(Debug::ERROR) << "Cannot close file " << name << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
 void DBWriter::close(bool merge, bool needsSort) {
     // close all datafiles
     for (unsigned int i = 0; i < threads; i++) {
@@ -234,6 +294,7 @@ void DBWriter::close(bool merge, bool needsSort) {
                  threads, merge, ((mode & Parameters::WRITER_LEXICOGRAPHIC_MODE) != 0), needsSort);
 
     writeDbtypeFile(dataFileName, dbtype, (mode & Parameters::WRITER_COMPRESSED_MODE) != 0);
+    writeDictionaryFile();
 
     for (unsigned int i = 0; i < threads; i++) {
         delete [] dataFilesBuffer[i];
@@ -254,8 +315,8 @@ void DBWriter::writeStart(unsigned int thrIdx) {
     if((mode & Parameters::WRITER_COMPRESSED_MODE) != 0){
         state[thrIdx] = INIT_STATE;
         threadBufferOffset[thrIdx]=0;
-        int cLevel = 3;
-        size_t const initResult = ZSTD_initCStream(cstream[thrIdx], cLevel);
+        size_t const initResult = (cdict != NULL) ? ZSTD_initCStream_usingCDict(cstream[thrIdx], cdict)
+                                                  : ZSTD_initCStream(cstream[thrIdx], COMPRESSION_LEVEL);
         if (ZSTD_isError(initResult)) {
             Debug(Debug::ERROR) << "ZSTD_initCStream() error in thread " << thrIdx << ". Error "
                                 << ZSTD_getErrorName(initResult) << "\n";
@@ -271,13 +332,14 @@ size_t DBWriter::writeAdd(const char* data, size_t dataSize, unsigned int thrIdx
         EXIT(EXIT_FAILURE);
     }
     bool isCompressedDB = (mode & Parameters::WRITER_COMPRESSED_MODE) != 0;
-    if(isCompressedDB && state[thrIdx] == INIT_STATE && dataSize < 60){
+    // zstd seems to have a hard time with elements < 60, a dictionary helps for short entries
+    const size_t minCompressSize = (cdict != NULL) ? 16 : 60;
+    if(isCompressedDB && state[thrIdx] == INIT_STATE && dataSize < minCompressSize){
         state[thrIdx] = NOTCOMPRESSED;
     }
     size_t totalWriten = 0;
     if(isCompressedDB && (state[thrIdx] == INIT_STATE || state[thrIdx] == COMPRESSED) ) {
         state[thrIdx] = COMPRESSED;
-        // zstd seems to have a hard time with elements < 60
         ZSTD_inBuffer input = { data, dataSize, 0 };
         while (input.pos < input.size) {
             ZSTD_outBuffer output = {compressedBuffers[thrIdx], compressedBufferSizes[thrIdx], 0};
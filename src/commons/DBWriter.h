@@ -25,6 +25,18 @@ public:
 
     char* getIndexFileName() { return indexFileName; }
 
+    unsigned int getThreads() { return threads; }
+
+    // compressed entries are written with this zstd dictionary, it is stored next to the data file as <data>.zdict
+    void setDictionary(const std::string &dictionary);
+
+    // zstd recommends about a hundred times more sample data than the dictionary size
+    static const size_t MAX_DICTIONARY_SIZE = 112640;
+    static const size_t DICTIONARY_SAMPLE_SIZE = 100 * MAX_DICTIONARY_SIZE;
+
+    // returns an empty dictionary if the samples are not suited for training
+    static std::string trainDictionary(const std::string &samples, const std::vector<size_t> &sampleSizes);
+
     void writeStart(unsigned int thrIdx = 0);
     size_t writeAdd(const char* data, size_t dataSize, unsigned int thrIdx = 0);
     void writeEnd(unsigned int key, unsigned int thrIdx = 0, bool addNullByte = true, bool addIndexEntry = true);
@@ -67,6 +79,7 @@ public:
 private:
     size_t addToThreadBuffer(const void *data, size_t itmesize, size_t nitems, int threadIdx);
     void writeThreadBuffer(unsigned int idx, size_t dataSize);
+    void writeDictionaryFile();
 
     void checkClosed();
 
@@ -101,7 +114,10 @@ private:
     static const int INIT_STATE=0;
     static const int NOTCOMPRESSED=1;
     static const int COMPRESSED=2;
+    static const int COMPRESSION_LEVEL=3;
     ZSTD_CStream** cstream;
+    ZSTD_CDict* cdict;
+    std::string dictionary;
 
     const unsigned int threads;
     const size_t mode;
@@ -25,6 +25,11 @@ bool FileUtil::directoryExists(const char* directoryName) {
     return stat(directoryName, &st) == 0 && S_ISDIR(st.st_mode);
 }
 
+bool FileUtil::isRegularFile(const char* fileName) {
+    struct stat st;
+    return stat(fileName, &st) == 0 && S_ISREG(st.st_mode);
+}
+
 bool FileUtil::makeDir(const char* directoryName, const int mode ) {
     return mkdir(directoryName, mode) == 0;
 }
@@ -307,6 +312,15 @@ void FileUtil::copyFile(const char *src, const char *dst) {
     close(dest);
 }
 
+void FileUtil::linkOrCopyFile(const char *src, const char *dst) {
+    if (FileUtil::fileExists(dst)) {
+        FileUtil::remove(dst);
+    }
+    if (link(src, dst) != 0) {
+        FileUtil::copyFile(src, dst);
+    }
+}
+
 FILE * FileUtil::openAndDelete(const char *fileName, const char *mode) {
     if(FileUtil::fileExists(fileName) == true){
         if(FileUtil::directoryExists(fileName)){
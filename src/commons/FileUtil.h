@@ -16,6 +16,9 @@ public:
 
     static bool directoryExists(const char *directoryName);
 
+    // false for pipes, character devices (e.g. stdin) and missing files
+    static bool isRegularFile(const char *fileName);
+
     static FILE* openFileOrDie(const char *fileName, const char *mode, bool shouldExist);
 
     static size_t countLines(const char *name);
@@ -51,6 +54,9 @@ public:
 
     static void copyFile(const char *src, const char *dst);
 
+    // hard link src to dst, falls back to a copy if linking is not possible (e.g. across file systems)
+    static void linkOrCopyFile(const char *src, const char *dst);
+
     static FILE *openAndDelete(const char *fileName, const char *mode);
 
     static std::vector<std::string> findDatafiles(const char * datafiles);
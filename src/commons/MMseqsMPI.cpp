@@ -23,8 +23,42 @@ void MMseqsMPI::init(int argc, const char **argv) {
     Debug(Debug::INFO) << "MPI Init\n";
     Debug(Debug::INFO) << "Rank: " << rank << " Size: " << numProc << "\n";
 }
+
+MMseqsMPI::WorkQueue::WorkQueue(size_t chunkCount) : chunkCount(chunkCount), counter(NULL) {
+    MPI_Aint windowSize = isMaster() ? sizeof(unsigned long) : 0;
+    MPI_Win_allocate(windowSize, sizeof(unsigned long), MPI_INFO_NULL, MPI_COMM_WORLD, &counter, &window);
+    if (isMaster()) {
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, MASTER, 0, window);
+        *counter = 0;
+        MPI_Win_unlock(MASTER, window);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+MMseqsMPI::WorkQueue::~WorkQueue() {
+    MPI_Win_free(&window);
+}
+
+bool MMseqsMPI::WorkQueue::next(size_t *chunk) {
+    const unsigned long one = 1;
+    unsigned long current = 0;
+    MPI_Win_lock(MPI_LOCK_SHARED, MASTER, 0, window);
+    MPI_Fetch_and_op(&one, &current, MPI_UNSIGNED_LONG, MASTER, 0, MPI_SUM, window);
+    MPI_Win_unlock(MASTER, window);
+    *chunk = current;
+    return current < chunkCount;
+}
 #else
 void MMseqsMPI::init(int, const char **) {
     rank = 0;
 }
+
+MMseqsMPI::WorkQueue::WorkQueue(size_t chunkCount) : chunkCount(chunkCount), counter(0) {}
+
+MMseqsMPI::WorkQueue::~WorkQueue() {}
+
+bool MMseqsMPI::WorkQueue::next(size_t *chunk) {
+    *chunk = counter++;
+    return *chunk < chunkCount;
+}
 #endif
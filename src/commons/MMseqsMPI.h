@@ -5,9 +5,13 @@
 #include <mpi.h>
 #endif
 
+#include <cstddef>
+
 class MMseqsMPI {
 public:
     static const int MASTER = 0;
+    // number of work chunks per rank for dynamic scheduling
+    static const size_t CHUNKS_PER_RANK = 8;
 
     static bool active;
     static int rank;
@@ -19,6 +23,27 @@ public:
         return rank == MASTER;
 #else
         return true;
+#endif
+    };
+
+    // hands out the chunks [0, chunkCount) to whichever rank asks next. The counter lives on the master
+    // and is fetched and incremented with an atomic one-sided operation, so the master can work as well.
+    // Construction and destruction are collective operations.
+    class WorkQueue {
+    public:
+        WorkQueue(size_t chunkCount);
+        ~WorkQueue();
+
+        // returns false once all chunks were handed out
+        bool next(size_t *chunk);
+
+    private:
+        size_t chunkCount;
+#ifdef HAVE_MPI
+        MPI_Win window;
+        unsigned long *counter;
+#else
+        size_t counter;
 #endif
     };
 };
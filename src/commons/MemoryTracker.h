@@ -8,9 +8,14 @@
 class MemoryTracker{
 public:
     static size_t getSize() { return totalMemorySizeInst;};
+    static size_t getPeakSize() { return peakMemorySizeInst;};
 protected:
     static size_t totalMemorySizeInst;
-    static void incrementMemory(size_t memorySize) { totalMemorySizeInst+=memorySize; }
+    static size_t peakMemorySizeInst;
+    static void incrementMemory(size_t memorySize) {
+        totalMemorySizeInst+=memorySize;
+        peakMemorySizeInst = totalMemorySizeInst > peakMemorySizeInst ? totalMemorySizeInst : peakMemorySizeInst;
+    }
     static void decrementMemory(size_t memorySize) { totalMemorySizeInst-=memorySize; }
 };
 #endif //MMSEQS_MEMORYTRACKER_H
@@ -0,0 +1,127 @@
+#include "Metrics.h"
+#include "MemoryTracker.h"
+#include "Debug.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+std::vector<Metrics::Phase> Metrics::phases;
+std::vector<std::pair<std::string, double>> Metrics::counters;
+
+double Metrics::getWallTime() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + 1e-6 * now.tv_usec;
+}
+
+double Metrics::getCpuTime() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + 1e-6 * usage.ru_utime.tv_usec)
+           + (usage.ru_stime.tv_sec + 1e-6 * usage.ru_stime.tv_usec);
+}
+
+Metrics::Phase &Metrics::getPhase(const char *name) {
+    for (size_t i = 0; i < phases.size(); i++) {
+        if (phases[i].name == name) {
+            return phases[i];
+        }
+    }
+    phases.emplace_back(name);
+    return phases.back();
+}
+
+void Metrics::startPhase(const char *name) {
+#pragma omp critical (metrics)
+    {
+        Phase &phase = getPhase(name);
+        phase.wallStart = getWallTime();
+        phase.cpuStart = getCpuTime();
+    }
+}
+
+void Metrics::stopPhase(const char *name) {
+#pragma omp critical (metrics)
+    {
+        Phase &phase = getPhase(name);
+        phase.count++;
+        phase.wallTime += getWallTime() - phase.wallStart;
+        phase.cpuTime += getCpuTime() - phase.cpuStart;
+        phase.trackedMemory = std::max(phase.trackedMemory, MemoryTracker::getSize());
+    }
+}
+
+void Metrics::addCounter(const char *name, double value) {
+#pragma omp critical (metrics)
+    {
+        bool found = false;
+        for (size_t i = 0; i < counters.size(); i++) {
+            if (counters[i].first == name) {
+                counters[i].second += value;
+                found = true;
+                break;
+            }
+        }
+        if (found == false) {
+            counters.emplace_back(name, value);
+        }
+    }
+}
+
+void Metrics::write(const std::string &fileName, const char *module, double wallTime) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    // ru_maxrss is given in bytes on macOS and in kilobytes elsewhere
+    size_t peakRss = usage.ru_maxrss;
+#else
+    size_t peakRss = static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+
+    // read/written chars include all read/write syscalls, storage bytes also include page faults of mmaped files
+    size_t ioValues[4] = {0, 0, 0, 0};
+    const char *ioKeys[4] = {"rchar:", "wchar:", "read_bytes:", "write_bytes:"};
+    FILE *ioFile = fopen("/proc/self/io", "r");
+    if (ioFile != NULL) {
+        char line[256];
+        while (fgets(line, sizeof(line), ioFile) != NULL) {
+            for (size_t i = 0; i < 4; i++) {
+                size_t keyLen = strlen(ioKeys[i]);
+                if (strncmp(line, ioKeys[i], keyLen) == 0) {
+                    ioValues[i] = strtoull(line + keyLen, NULL, 10);
+                }
+            }
+        }
+        fclose(ioFile);
+    }
+
+    // modules of a workflow append to the same file
+    FILE *file = fopen(fileName.c_str(), "a");
+    if (file == NULL) {
+        Debug(Debug::ERROR) << "Cannot open metrics file " << fileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    fprintf(file, "{\"module\":\"%s\",\"wall_time\":%.6f,\"cpu_time\":%.6f,\"peak_rss\":%zu,\"tracked_memory\":%zu,\"tracked_memory_peak\":%zu,",
+            module, wallTime, getCpuTime(), peakRss, MemoryTracker::getSize(), MemoryTracker::getPeakSize());
+    fprintf(file, "\"io\":{\"read_chars\":%zu,\"written_chars\":%zu,\"read_bytes\":%zu,\"written_bytes\":%zu},",
+            ioValues[0], ioValues[1], ioValues[2], ioValues[3]);
+    fprintf(file, "\"phases\":[");
+    for (size_t i = 0; i < phases.size(); i++) {
+        fprintf(file, "%s{\"name\":\"%s\",\"count\":%zu,\"wall_time\":%.6f,\"cpu_time\":%.6f,\"tracked_memory\":%zu}",
+                (i > 0) ? "," : "", phases[i].name.c_str(), phases[i].count, phases[i].wallTime, phases[i].cpuTime, phases[i].trackedMemory);
+    }
+    fprintf(file, "],\"counters\":{");
+    for (size_t i = 0; i < counters.size(); i++) {
+        fprintf(file, "%s\"%s\":%.17g", (i > 0) ? "," : "", counters[i].first.c_str(), counters[i].second);
+    }
+    fprintf(file, "}}\n");
+    if (fclose(file) != 0) {
+        Debug(Debug::ERROR) << "Cannot close metrics file " << fileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef MMSEQS_METRICS_H
+#define MMSEQS_METRICS_H
+
+// Collects per-phase wall/CPU times and counters of a module run and appends them as
+// a single JSON line to the file given by --metrics-file once the module finishes.
+// Phases with the same name are accumulated, phases may overlap (e.g. pipelined index builds).
+
+#include <string>
+#include <vector>
+#include <utility>
+
+class Metrics {
+public:
+    static void startPhase(const char *name);
+    static void stopPhase(const char *name);
+
+    static void addCounter(const char *name, double value);
+
+    // appends one JSON object (JSON Lines) describing the finished module to fileName
+    static void write(const std::string &fileName, const char *module, double wallTime);
+
+private:
+    struct Phase {
+        std::string name;
+        size_t count;
+        double wallTime;
+        double cpuTime;
+        double wallStart;
+        double cpuStart;
+        size_t trackedMemory;
+        Phase(const char *name) : name(name), count(0), wallTime(0), cpuTime(0), wallStart(0), cpuStart(0), trackedMemory(0) {}
+    };
+
+    static std::vector<Phase> phases;
+    static std::vector<std::pair<std::string, double>> counters;
+
+    static Phase &getPhase(const char *name);
+    static double getWallTime();
+    static double getCpuTime();
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "OrderedFileWriter.h"
+#include "Debug.h"
+#include "Util.h"
+
+#include <zstd.h>
+#include <cstring>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+OrderedFileWriter::OrderedFileWriter(const std::string &fileName)
+        : fileName(fileName), compression(getCompression(fileName)), closed(false),
+          nextEntry(0), pendingSize(0), nextBlockId(0), nextBlockToWrite(0) {
+#ifndef HAVE_ZLIB
+    if (compression == COMPRESSION_GZIP) {
+        Debug(Debug::ERROR) << "MMseqs2 was not compiled with zlib support. Cannot write compressed output.\n";
+        EXIT(EXIT_FAILURE);
+    }
+#endif
+    file = fopen(fileName.c_str(), "w");
+    if (file == NULL) {
+        Debug(Debug::ERROR) << "Cannot open " << fileName << " for writing\n";
+        EXIT(EXIT_FAILURE);
+    }
+    currentBlock.reserve(BLOCK_SIZE);
+}
+
+OrderedFileWriter::~OrderedFileWriter() {
+    if (closed == false) {
+        close();
+    }
+}
+
+OrderedFileWriter::Compression OrderedFileWriter::getCompression(const std::string &fileName) {
+    if (Util::endsWith(".gz", fileName)) {
+        return COMPRESSION_GZIP;
+    }
+    if (Util::endsWith(".zst", fileName)) {
+        return COMPRESSION_ZSTD;
+    }
+    return COMPRESSION_NONE;
+}
+
+void OrderedFileWriter::write(size_t order, const char *data, size_t dataSize) {
+    // the thread holding the next entry never waits, since it writes its entries in increasing order
+    while (order > __atomic_load_n(&nextEntry, __ATOMIC_ACQUIRE)
+           && __atomic_load_n(&pendingSize, __ATOMIC_ACQUIRE) + dataSize > MAX_PENDING_SIZE) {
+        usleep(100);
+    }
+
+    std::string fullBlock;
+    size_t blockId = SIZE_MAX;
+#pragma omp critical (OrderedFileWriterEntries)
+    {
+        if (order == nextEntry) {
+            if (dataSize > 0) {
+                currentBlock.append(data, dataSize);
+            }
+            size_t next = nextEntry + 1;
+            size_t drained = 0;
+            std::map<size_t, std::string>::iterator it;
+            while ((it = pendingEntries.find(next)) != pendingEntries.end()) {
+                currentBlock.append(it->second);
+                drained += it->second.size() + PENDING_ENTRY_OVERHEAD;
+                pendingEntries.erase(it);
+                next++;
+            }
+            __atomic_sub_fetch(&pendingSize, drained, __ATOMIC_RELEASE);
+            __atomic_store_n(&nextEntry, next, __ATOMIC_RELEASE);
+            if (currentBlock.size() >= BLOCK_SIZE) {
+                fullBlock.swap(currentBlock);
+                currentBlock.reserve(BLOCK_SIZE);
+                blockId = nextBlockId++;
+            }
+        } else {
+            std::string &entry = pendingEntries[order];
+            if (dataSize > 0) {
+                entry.assign(data, dataSize);
+            }
+            __atomic_add_fetch(&pendingSize, dataSize + PENDING_ENTRY_OVERHEAD, __ATOMIC_RELEASE);
+        }
+    }
+    // compression and file output happen outside of the entry lock
+    if (blockId != SIZE_MAX) {
+        writeBlock(blockId, fullBlock);
+    }
+}
+
+void OrderedFileWriter::compressBlock(const std::string &block, std::string &out) {
+    if (compression == COMPRESSION_ZSTD) {
+        out.resize(ZSTD_compressBound(block.size()));
+        size_t size = ZSTD_compress(&out[0], out.size(), block.data(), block.size(), 3);
+        if (ZSTD_isError(size)) {
+            Debug(Debug::ERROR) << "Cannot compress block of " << fileName << ": " << ZSTD_getErrorName(size) << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        out.resize(size);
+    }
+#ifdef HAVE_ZLIB
+    if (compression == COMPRESSION_GZIP) {
+        z_stream strm;
+        memset(&strm, 0, sizeof(z_stream));
+        // window bits + 16 write a gzip header and trailer
+        if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            Debug(Debug::ERROR) << "Cannot initialize zlib stream\n";
+            EXIT(EXIT_FAILURE);
+        }
+        out.resize(deflateBound(&strm, block.size()));
+        strm.next_in = (Bytef *) block.data();
+        strm.avail_in = block.size();
+        strm.next_out = (Bytef *) &out[0];
+        strm.avail_out = out.size();
+        if (deflate(&strm, Z_FINISH) != Z_STREAM_END) {
+            Debug(Debug::ERROR) << "Cannot compress block of " << fileName << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        out.resize(strm.total_out);
+        deflateEnd(&strm);
+    }
+#endif
+}
+
+void OrderedFileWriter::writeBlock(size_t blockId, std::string &block) {
+    std::string compressed;
+    if (compression != COMPRESSION_NONE) {
+        compressBlock(block, compressed);
+        block.swap(compressed);
+    }
+#pragma omp critical (OrderedFileWriterFile)
+    {
+        pendingBlocks[blockId].swap(block);
+        std::map<size_t, std::string>::iterator it;
+        while ((it = pendingBlocks.find(nextBlockToWrite)) != pendingBlocks.end()) {
+            if (fwrite(it->second.data(), sizeof(char), it->second.size(), file) != it->second.size()) {
+                Debug(Debug::ERROR) << "Cannot write to " << fileName << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            pendingBlocks.erase(it);
+            nextBlockToWrite++;
+        }
+    }
+}
+
+void OrderedFileWriter::close() {
+    if (pendingEntries.empty() == false) {
+        Debug(Debug::ERROR) << "Entry " << nextEntry << " of " << fileName << " was never written\n";
+        EXIT(EXIT_FAILURE);
+    }
+    // an empty compressed file still needs one valid member
+    if (currentBlock.empty() == false || nextBlockId == 0) {
+        writeBlock(nextBlockId++, currentBlock);
+    }
+    if (fclose(file) != 0) {
+        Debug(Debug::ERROR) << "Cannot close file " << fileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    closed = true;
+}
@@ -0,0 +1,62 @@
+#ifndef MMSEQS_ORDEREDFILEWRITER_H
+#define MMSEQS_ORDEREDFILEWRITER_H
+
+// Streams the entries of a flat output file (e.g. TSV) from many threads directly into a single file.
+// Every entry carries its position in the output, entries that arrive early are kept in a reorder
+// buffer until all of their predecessors are written. A thread whose entry would grow the reorder buffer beyond
+// MAX_PENDING_SIZE waits until the earlier entries are written, so each thread has to write its entries in
+// increasing order (as a for loop with any OpenMP schedule does). Files ending in .gz or .zst are compressed
+// in blocks by the thread that completes a block, the blocks are written as independent gzip members
+// or zstd frames that the standard tools decompress as one stream.
+
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <string>
+
+class OrderedFileWriter {
+public:
+    explicit OrderedFileWriter(const std::string &fileName);
+    ~OrderedFileWriter();
+
+    // each order from 0 up to the last entry has to be written exactly once, even if the entry is empty
+    void write(size_t order, const char *data, size_t dataSize);
+
+    void close();
+
+    enum Compression {
+        COMPRESSION_NONE = 0,
+        COMPRESSION_GZIP,
+        COMPRESSION_ZSTD
+    };
+
+    static Compression getCompression(const std::string &fileName);
+
+private:
+    static const size_t BLOCK_SIZE = 4 * 1024 * 1024;
+    static const size_t MAX_PENDING_SIZE = 16 * BLOCK_SIZE;
+    // bookkeeping of an entry in the reorder buffer
+    static const size_t PENDING_ENTRY_OVERHEAD = 64;
+
+    void compressBlock(const std::string &block, std::string &out);
+    void writeBlock(size_t blockId, std::string &block);
+
+    std::string fileName;
+    FILE *file;
+    Compression compression;
+    bool closed;
+
+    // guarded by the critical section OrderedFileWriterEntries
+    std::map<size_t, std::string> pendingEntries;
+    // read without the lock by threads waiting for the reorder buffer to drain
+    size_t nextEntry;
+    size_t pendingSize;
+    std::string currentBlock;
+    size_t nextBlockId;
+
+    // guarded by the critical section OrderedFileWriterFile
+    std::map<size_t, std::string> pendingBlocks;
+    size_t nextBlockToWrite;
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include "PageAllocator.h"
+#include "Debug.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+// from numaif.h, we do not want to depend on libnuma
+#define MMSEQS_MPOL_BIND 2
+#define MMSEQS_MPOL_INTERLEAVE 3
+#endif
+
+int PageAllocator::hugePages = PageAllocator::HUGE_PAGES_OFF;
+int PageAllocator::numaMode = PageAllocator::NUMA_MODE_LOCAL;
+
+// mapped regions and their mapped sizes, everything else was allocated with malloc
+static std::map<void *, size_t> mappings;
+
+static thread_local int threadNode = -1;
+#ifdef __linux__
+static thread_local bool threadPinned = false;
+static thread_local cpu_set_t threadAffinity;
+#endif
+
+void PageAllocator::configure(int hugePages, int numaMode) {
+    PageAllocator::hugePages = hugePages;
+    PageAllocator::numaMode = numaMode;
+}
+
+void *PageAllocator::allocate(size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    if (hugePages == HUGE_PAGES_OFF && numaMode == NUMA_MODE_LOCAL && threadNode == -1) {
+        return malloc(size);
+    }
+
+    size_t mappedSize = 0;
+    void *ptr = mapPages(size, mappedSize);
+    if (ptr == NULL) {
+        return NULL;
+    }
+    // the policy has to be set before the first touch of the pages
+#ifdef __linux__
+    if (threadNode != -1) {
+        setMemoryPolicy(ptr, mappedSize, MMSEQS_MPOL_BIND, std::vector<int>(1, threadNode));
+    } else if (numaMode != NUMA_MODE_LOCAL) {
+        std::vector<int> nodes = getNumaNodes();
+        if (nodes.size() > 1) {
+            setMemoryPolicy(ptr, mappedSize, MMSEQS_MPOL_INTERLEAVE, nodes);
+        }
+    }
+#endif
+#pragma omp critical (PageAllocator)
+    mappings[ptr] = mappedSize;
+    return ptr;
+}
+
+void PageAllocator::free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    size_t mappedSize = 0;
+#pragma omp critical (PageAllocator)
+    {
+        std::map<void *, size_t>::iterator it = mappings.find(ptr);
+        if (it != mappings.end()) {
+            mappedSize = it->second;
+            mappings.erase(it);
+        }
+    }
+    if (mappedSize == 0) {
+        ::free(ptr);
+    } else if (munmap(ptr, mappedSize) != 0) {
+        Debug(Debug::ERROR) << "Cannot unmap " << mappedSize << " bytes\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
+static size_t roundUp(size_t size, size_t alignment) {
+    return ((size + alignment - 1) / alignment) * alignment;
+}
+
+void *PageAllocator::mapPages(size_t size, size_t &mappedSize) {
+#ifdef MAP_HUGETLB
+    const size_t hugePageSize = (hugePages == HUGE_PAGES_1G) ? (1ull << 30) : (1ull << 21);
+    // tables smaller than a page would waste most of it
+    if ((hugePages == HUGE_PAGES_2M || hugePages == HUGE_PAGES_1G) && size >= hugePageSize) {
+        const int pageFlag = (hugePages == HUGE_PAGES_2M) ? MAP_HUGE_2MB : MAP_HUGE_1GB;
+        mappedSize = roundUp(size, hugePageSize);
+        void *ptr = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | pageFlag, -1, 0);
+        if (ptr != MAP_FAILED) {
+            return ptr;
+        }
+        // only pages reserved in the hugetlbfs pool (vm.nr_hugepages) can be mapped
+        Debug(Debug::WARNING) << "Cannot map " << mappedSize << " bytes of explicit huge pages. "
+                              << "Falling back to transparent huge pages\n";
+    }
+#endif
+
+    // over-allocate to align the region to 2 MB, otherwise the kernel cannot back its ends with huge pages
+    const size_t alignment = (hugePages == HUGE_PAGES_OFF) ? (size_t) sysconf(_SC_PAGESIZE) : (1ull << 21);
+    mappedSize = roundUp(size, alignment);
+    const size_t reserveSize = mappedSize + alignment;
+    char *reserved = (char *) mmap(NULL, reserveSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        return NULL;
+    }
+    char *ptr = (char *) roundUp((size_t) reserved, alignment);
+    if (ptr > reserved) {
+        munmap(reserved, ptr - reserved);
+    }
+    const size_t tail = (reserved + reserveSize) - (ptr + mappedSize);
+    if (tail > 0) {
+        munmap(ptr + mappedSize, tail);
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (hugePages != HUGE_PAGES_OFF && madvise(ptr, mappedSize, MADV_HUGEPAGE) != 0) {
+        Debug(Debug::WARNING) << "Transparent huge pages are not available\n";
+    }
+#endif
+    return ptr;
+}
+
+std::vector<int> PageAllocator::parseList(const char *fileName) {
+    // ranges like "0-3,5"
+    std::vector<int> list;
+    FILE *file = fopen(fileName, "r");
+    if (file == NULL) {
+        return list;
+    }
+    int first, last;
+    int separator = 0;
+    while (separator != '\n' && separator != EOF && fscanf(file, "%d", &first) == 1) {
+        last = first;
+        separator = fgetc(file);
+        if (separator == '-') {
+            if (fscanf(file, "%d", &last) != 1) {
+                break;
+            }
+            separator = fgetc(file);
+        }
+        for (int i = first; i <= last; i++) {
+            list.push_back(i);
+        }
+    }
+    fclose(file);
+    return list;
+}
+
+std::vector<int> PageAllocator::getNumaNodes() {
+    std::vector<int> nodes = parseList("/sys/devices/system/node/online");
+    if (nodes.empty()) {
+        nodes.push_back(0);
+    }
+    return nodes;
+}
+
+void PageAllocator::setThreadNode(int node) {
+    threadNode = node;
+}
+
+void PageAllocator::setMemoryPolicy(void *ptr, size_t size, int policy, const std::vector<int> &nodes) {
+#ifdef __linux__
+    std::vector<unsigned long> nodeMask(16, 0);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i] >= 0 && static_cast<size_t>(nodes[i]) < nodeMask.size() * 64) {
+            nodeMask[nodes[i] / 64] |= 1ul << (nodes[i] % 64);
+        }
+    }
+    if (syscall(SYS_mbind, ptr, size, policy, nodeMask.data(), nodeMask.size() * 64 + 1, 0) != 0) {
+        Debug(Debug::WARNING) << "Cannot set the NUMA policy of " << size << " bytes\n";
+    }
+#else
+    (void) ptr;
+    (void) size;
+    (void) policy;
+    (void) nodes;
+#endif
+}
+
+bool PageAllocator::pinThread(int node) {
+#ifdef __linux__
+    char fileName[64];
+    snprintf(fileName, sizeof(fileName), "/sys/devices/system/node/node%d/cpulist", node);
+    std::vector<int> cpus = parseList(fileName);
+    if (cpus.empty()) {
+        return false;
+    }
+    cpu_set_t nodeCpus;
+    CPU_ZERO(&nodeCpus);
+    for (size_t i = 0; i < cpus.size(); i++) {
+        if (cpus[i] < CPU_SETSIZE) {
+            CPU_SET(cpus[i], &nodeCpus);
+        }
+    }
+    if (threadPinned == false && sched_getaffinity(0, sizeof(cpu_set_t), &threadAffinity) != 0) {
+        return false;
+    }
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &nodeCpus) != 0) {
+        return false;
+    }
+    threadPinned = true;
+    return true;
+#else
+    (void) node;
+    return false;
+#endif
+}
+
+void PageAllocator::unpinThread() {
+#ifdef __linux__
+    if (threadPinned) {
+        sched_setaffinity(0, sizeof(cpu_set_t), &threadAffinity);
+        threadPinned = false;
+    }
+#endif
+}
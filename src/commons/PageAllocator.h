@@ -0,0 +1,60 @@
+#ifndef MMSEQS_PAGEALLOCATOR_H
+#define MMSEQS_PAGEALLOCATOR_H
+
+// Allocates the large, randomly accessed tables of the prefilter (k-mer index table, sequence lookup).
+// The k-mer lookups miss the TLB for almost every access with 4 KB pages, so these tables can be
+// placed on transparent or explicit (hugetlbfs) huge pages. On multi-socket machines the pages
+// can additionally be interleaved over all NUMA nodes, so that no single memory controller serves
+// all threads, or replicated on every node (see Prefiltering::replicateIndexTable). The mode is set
+// globally with --huge-pages and --numa-mode.
+
+#include <cstddef>
+#include <vector>
+
+class PageAllocator {
+public:
+    static const int HUGE_PAGES_OFF = 0;
+    static const int HUGE_PAGES_TRANSPARENT = 1;
+    static const int HUGE_PAGES_2M = 2;
+    static const int HUGE_PAGES_1G = 3;
+
+    static const int NUMA_MODE_LOCAL = 0;
+    static const int NUMA_MODE_INTERLEAVE = 1;
+    // tables that are not replicated are interleaved
+    static const int NUMA_MODE_REPLICATE = 2;
+
+    static void configure(int hugePages, int numaMode);
+
+    // returns NULL if the memory cannot be allocated, the memory is not initialized
+    static void *allocate(size_t size);
+    static void free(void *ptr);
+
+    template <typename T>
+    static T *allocateArray(size_t count) {
+        return static_cast<T *>(allocate(count * sizeof(T)));
+    }
+
+    static int getNumaMode() {
+        return numaMode;
+    }
+
+    // returns the online NUMA nodes, a single node if the topology is unknown
+    static std::vector<int> getNumaNodes();
+
+    // binds all following allocations of the calling thread to the given node, -1 resets it
+    static void setThreadNode(int node);
+
+    // restricts the calling thread to the CPUs of the given node until unpinThread is called
+    static bool pinThread(int node);
+    static void unpinThread();
+
+private:
+    static int hugePages;
+    static int numaMode;
+
+    static void *mapPages(size_t size, size_t &mappedSize);
+    static void setMemoryPolicy(void *ptr, size_t size, int policy, const std::vector<int> &nodes);
+    static std::vector<int> parseList(const char *fileName);
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include "CommandCaller.h"
 #include "ByteParser.h"
 #include "FileUtil.h"
+#include "PageAllocator.h"
 
 #include <map>
 #include <iomanip>
@@ -32,18 +33,21 @@ Parameters::Parameters():
         PARAM_K(PARAM_K_ID, "-k", "k-mer length", "k-mer length (0: automatically set to optimum)", typeid(int), (void *) &kmerSize, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_CLUSTLINEAR | MMseqsParameter::COMMAND_EXPERT),
         PARAM_THREADS(PARAM_THREADS_ID, "--threads", "Threads", "Number of CPU-cores used (all by default)", typeid(int), (void *) &threads, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_COMMON),
         PARAM_COMPRESSED(PARAM_COMPRESSED_ID, "--compressed", "Compressed", "Write compressed output", typeid(int), (void *) &compressed, "^[0-1]{1}$", MMseqsParameter::COMMAND_COMMON),
+        PARAM_COMPRESSION_DICT(PARAM_COMPRESSION_DICT_ID, "--compression-dict", "Compression dictionary", "Compress entries with a zstd dictionary trained on a sample of the database", typeid(bool), (void *) &compressionDict, "", MMseqsParameter::COMMAND_COMMON | MMseqsParameter::COMMAND_EXPERT),
         PARAM_ALPH_SIZE(PARAM_ALPH_SIZE_ID, "--alph-size", "Alphabet size", "Alphabet size (range 2-21)", typeid(MultiParam<int>), (void *) &alphabetSize, "", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_CLUSTLINEAR | MMseqsParameter::COMMAND_EXPERT),
         PARAM_MAX_SEQ_LEN(PARAM_MAX_SEQ_LEN_ID, "--max-seq-len", "Max sequence length", "Maximum sequence length", typeid(int), (void *) &maxSeqLen, "^[0-9]{1}[0-9]*", MMseqsParameter::COMMAND_COMMON | MMseqsParameter::COMMAND_EXPERT),
         PARAM_DIAGONAL_SCORING(PARAM_DIAGONAL_SCORING_ID, "--diag-score", "Diagonal scoring", "Use ungapped diagonal scoring during prefilter", typeid(bool), (void *) &diagonalScoring, "", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_EXACT_KMER_MATCHING(PARAM_EXACT_KMER_MATCHING_ID, "--exact-kmer-matching", "Exact k-mer matching", "Extract only exact k-mers for matching (range 0-1)", typeid(int), (void *) &exactKmerMatching, "^[0-1]{1}$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_MASK_RESIDUES(PARAM_MASK_RESIDUES_ID, "--mask", "Mask residues", "Mask sequences in k-mer stage: 0: w/o low complexity masking, 1: with low complexity masking", typeid(int), (void *) &maskMode, "^[0-1]{1}", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_MASK_LOWER_CASE(PARAM_MASK_LOWER_CASE_ID, "--mask-lower-case", "Mask lower case residues", "Lowercase letters will be excluded from k-mer search 0: include region, 1: exclude region", typeid(int), (void *) &maskLowerCaseMode, "^[0-1]{1}", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_MASK_DB_MODE(PARAM_MASK_DB_MODE_ID, "--mask-db-mode", "Mask DB mode", "Compute masks with the settings of 0: prefilter and createindex, 1: masksequence, 2: kmermatcher (linclust)", typeid(int), (void *) &maskDbMode, "^[0-2]{1}$", MMseqsParameter::COMMAND_MISC),
         PARAM_MIN_DIAG_SCORE(PARAM_MIN_DIAG_SCORE_ID, "--min-ungapped-score", "Minimum diagonal score", "Accept only matches with ungapped alignment score above threshold", typeid(int), (void *) &minDiagScoreThr, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_K_SCORE(PARAM_K_SCORE_ID, "--k-score", "k-score", "k-mer threshold for generating similar k-mer lists", typeid(int), (void *) &kmerScore, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_MAX_SEQS(PARAM_MAX_SEQS_ID, "--max-seqs", "Max results per query", "Maximum results per query sequence allowed to pass the prefilter (affects sensitivity)", typeid(int), (void *) &maxResListLen, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER),
         PARAM_SPLIT(PARAM_SPLIT_ID, "--split", "Split database", "Split input into N equally distributed chunks. 0: set the best split automatically", typeid(int), (void *) &split, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_SPLIT_MODE(PARAM_SPLIT_MODE_ID, "--split-mode", "Split mode", "0: split target db; 1: split query db; 2: auto, depending on main memory", typeid(int), (void *) &splitMode, "^[0-2]{1}$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_SPLIT_MEMORY_LIMIT(PARAM_SPLIT_MEMORY_LIMIT_ID, "--split-memory-limit", "Split memory limit", "Set max memory per split. E.g. 800B, 5K, 10M, 1G. Default (0) to all available system memory", typeid(ByteParser), (void *) &splitMemoryLimit, "^(0|[1-9]{1}[0-9]*(B|K|M|G|T)?)$", MMseqsParameter::COMMAND_COMMON | MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_SPLIT_PIPELINE(PARAM_SPLIT_PIPELINE_ID, "--split-pipeline", "Pipeline target splits", "Build the index table of the next target split on a subset of threads while the current split is searched. Requires memory for two splits", typeid(bool), (void *) &splitPipeline, "", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_DISK_SPACE_LIMIT(PARAM_DISK_SPACE_LIMIT_ID, "--disk-space-limit", "Disk space limit", "Set max disk space to use for reverse profile searches. E.g. 800B, 5K, 10M, 1G. Default (0) to all available disk space in the temp folder", typeid(ByteParser), (void *) &diskSpaceLimit, "^(0|[1-9]{1}[0-9]*(B|K|M|G|T)?)$", MMseqsParameter::COMMAND_COMMON | MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_SPLIT_AMINOACID(PARAM_SPLIT_AMINOACID_ID, "--split-aa", "Split by amino acid", "Try to find the best split boundaries by entry lengths", typeid(bool), (void *) &splitAA, "$", MMseqsParameter::COMMAND_EXPERT),
         PARAM_SUB_MAT(PARAM_SUB_MAT_ID, "--sub-mat", "Substitution matrix", "Substitution matrix file", typeid(MultiParam<char*>), (void *) &scoringMatrixFile, "", MMseqsParameter::COMMAND_COMMON | MMseqsParameter::COMMAND_EXPERT),
@@ -53,8 +57,14 @@ Parameters::Parameters():
         PARAM_REMOVE_TMP_FILES(PARAM_REMOVE_TMP_FILES_ID, "--remove-tmp-files", "Remove temporary files", "Delete temporary files", typeid(bool), (void *) &removeTmpFiles, "", MMseqsParameter::COMMAND_COMMON | MMseqsParameter::COMMAND_EXPERT),
         PARAM_INCLUDE_IDENTITY(PARAM_INCLUDE_IDENTITY_ID, "--add-self-matches", "Include identical seq. id.", "Artificially add entries of queries with themselves (for clustering)", typeid(bool), (void *) &includeIdentity, "", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_EXPERT),
         PARAM_PRELOAD_MODE(PARAM_PRELOAD_MODE_ID, "--db-load-mode", "Preload mode", "Database preload mode 0: auto, 1: fread, 2: mmap, 3: mmap+touch", typeid(int), (void *) &preloadMode, "[0-3]{1}", MMseqsParameter::COMMAND_COMMON | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_HUGE_PAGES(PARAM_HUGE_PAGES_ID, "--huge-pages", "Huge pages", "Back the prefilter index tables with huge pages 0: off, 1: transparent, 2: explicit 2 MB, 3: explicit 1 GB", typeid(int), (void *) &hugePages, "^[0-3]{1}$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_NUMA_MODE(PARAM_NUMA_MODE_ID, "--numa-mode", "NUMA mode", "Placement of the prefilter index tables on NUMA nodes 0: local to the allocating thread, 1: interleaved over all nodes, 2: replicated on each node with node pinned threads", typeid(int), (void *) &numaMode, "^[0-2]{1}$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_QUERY_BATCH_SIZE(PARAM_QUERY_BATCH_SIZE_ID, "--query-batch-size", "Query batch size", "Collect the k-mers of this many queries and read their index table lists in one sweep in k-mer order (0: off). Useful at high sensitivity or if the index is read from disk", typeid(int), (void *) &queryBatchSize, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_QUERY_CACHE_LIMIT(PARAM_QUERY_CACHE_LIMIT_ID, "--query-cache-limit", "Query cache limit", "Set max memory for keeping the composition bias and profile scores of the queries between target splits. E.g. 800B, 5K, 10M, 1G. 0: off", typeid(ByteParser), (void *) &queryCacheLimit, "^(0|[1-9]{1}[0-9]*(B|K|M|G|T)?)$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_SPACED_KMER_PATTERN(PARAM_SPACED_KMER_PATTERN_ID, "--spaced-kmer-pattern", "Spaced k-mer pattern", "User-specified spaced k-mer pattern", typeid(std::string), (void *) &spacedKmerPattern, "^1[01]*1$", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
         PARAM_LOCAL_TMP(PARAM_LOCAL_TMP_ID, "--local-tmp", "Local temporary path", "Path where some of the temporary files will be created", typeid(std::string), (void *) &localTmp, "", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_MPI_DYNAMIC(PARAM_MPI_DYNAMIC_ID, "--mpi-dynamic", "Dynamic MPI scheduling", "MPI ranks request chunks of the query database from the master on demand instead of a static split by residue count", typeid(bool), (void *) &mpiDynamic, "", MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_METRICS_FILE(PARAM_METRICS_FILE_ID, "--metrics-file", "Metrics file", "Append wall/CPU time per phase, counters, memory and I/O of each module as one JSON object per line to this file", typeid(std::string), (void *) &metricsFile, "", MMseqsParameter::COMMAND_MISC | MMseqsParameter::COMMAND_EXPERT),
         // alignment
         PARAM_ALIGNMENT_MODE(PARAM_ALIGNMENT_MODE_ID, "--alignment-mode", "Alignment mode", "How to compute the alignment:\n0: automatic\n1: only score and end_pos\n2: also start_pos and cov\n3: also seq.id\n4: only ungapped alignment", typeid(int), (void *) &alignmentMode, "^[0-4]{1}$", MMseqsParameter::COMMAND_ALIGN),
         PARAM_E(PARAM_E_ID, "-e", "E-value threshold", "List matches below this E-value (range 0.0-inf)", typeid(float), (void *) &evalThr, "^([-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?)|[0-9]*(\\.[0-9]+)?$", MMseqsParameter::COMMAND_ALIGN),
@@ -69,6 +79,7 @@ Parameters::Parameters():
         PARAM_MIN_ALN_LEN(PARAM_MIN_ALN_LEN_ID, "--min-aln-len", "Min alignment length", "Minimum alignment length (range 0-INT_MAX)", typeid(int), (void *) &alnLenThr, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN),
         PARAM_SCORE_BIAS(PARAM_SCORE_BIAS_ID, "--score-bias", "Score bias", "Score bias when computing SW alignment (in bits)", typeid(float), (void *) &scoreBias, "^-?[0-9]*(\\.[0-9]+)?$", MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_EXPERT),
         PARAM_ALT_ALIGNMENT(PARAM_ALT_ALIGNMENT_ID, "--alt-ali", "Alternative alignments", "Show up to this many alternative alignments", typeid(int), (void *) &altAlignment, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN),
+        PARAM_TARGET_SWEEP_BATCH(PARAM_TARGET_SWEEP_BATCH_ID, "--target-sweep-batch", "Target sweep batch", "Read the target sequences of this many queries in one sweep in database order before aligning them (0: off). Useful if the target database does not fit into memory", typeid(int), (void *) &targetSweepBatch, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_EXPERT),
         PARAM_GAP_OPEN(PARAM_GAP_OPEN_ID, "--gap-open", "Gap open cost", "Gap open cost", typeid(MultiParam<int>), (void *) &gapOpen, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_EXPERT),
         PARAM_GAP_EXTEND(PARAM_GAP_EXTEND_ID, "--gap-extend", "Gap extension cost", "Gap extension cost", typeid(MultiParam<int>), (void *) &gapExtend, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_EXPERT),
         PARAM_ZDROP(PARAM_ZDROP_ID, "--zdrop", "Zdrop", "Maximal allowed difference between score values before alignment is truncated  (nucleotide alignment only)", typeid(int), (void*) &zdrop, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_EXPERT),
@@ -77,6 +88,7 @@ Parameters::Parameters():
         PARAM_CLUSTER_STEPS(PARAM_CLUSTER_STEPS_ID, "--cluster-steps", "Cascaded clustering steps", "Cascaded clustering steps from 1 to -s", typeid(int), (void *) &clusterSteps, "^[1-9]{1}$", MMseqsParameter::COMMAND_CLUST | MMseqsParameter::COMMAND_EXPERT),
         PARAM_CASCADED(PARAM_CASCADED_ID, "--single-step-clustering", "Single step clustering", "Switch from cascaded to simple clustering workflow", typeid(bool), (void *) &singleStepClustering, "", MMseqsParameter::COMMAND_CLUST),
         PARAM_CLUSTER_REASSIGN(PARAM_CLUSTER_REASSIGN_ID, "--cluster-reassign", "Cluster reassign", "Cascaded clustering can cluster sequence that do not fulfill the clustering criteria.\nCluster reassignment corrects these errors", typeid(bool), (void *) &clusterReassignment, "", MMseqsParameter::COMMAND_CLUST),
+        PARAM_MINIMIZER_SKETCH_SIZE(PARAM_MINIMIZER_SKETCH_SIZE_ID, "--minimizer-sketch", "Minimizer sketch size", "Group near-identical sequences of different lengths by this many lowest minimizers per sequence (0: whole sequence hashes)", typeid(int), (void *) &minimizerSketchSize, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_CLUST | MMseqsParameter::COMMAND_EXPERT),
         // affinity clustering
         PARAM_MAXITERATIONS(PARAM_MAXITERATIONS_ID, "--max-iterations", "Max connected component depth", "Maximum depth of breadth first search in connected component clustering", typeid(int), (void *) &maxIteration, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_CLUST | MMseqsParameter::COMMAND_EXPERT),
         PARAM_SIMILARITYSCORE(PARAM_SIMILARITYSCORE_ID, "--similarity-type", "Similarity type", "Type of score used for clustering. 1: alignment score 2: sequence identity", typeid(int), (void *) &similarityScoreType, "^[1-2]{1}$", MMseqsParameter::COMMAND_CLUST | MMseqsParameter::COMMAND_EXPERT),
@@ -113,6 +125,7 @@ Parameters::Parameters():
         PARAM_FILTER_COV(PARAM_FILTER_COV_ID, "--cov", "Minimum coverage", "Filter output MSAs using min. fraction of query residues covered by matched sequences [0.0,1.0]", typeid(float), (void *) &covMSAThr, "^0(\\.[0-9]+)?|1(\\.0+)?$", MMseqsParameter::COMMAND_PROFILE | MMseqsParameter::COMMAND_EXPERT),
         PARAM_FILTER_NDIFF(PARAM_FILTER_NDIFF_ID, "--diff", "Select N most diverse seqs", "Filter MSAs by selecting most diverse set of sequences, keeping at least this many seqs in each MSA block of length 50", typeid(int), (void *) &Ndiff, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PROFILE | MMseqsParameter::COMMAND_EXPERT),
         PARAM_WG(PARAM_WG_ID, "--wg", "Global sequence weighting", "Use global sequence weighting for profile calculation", typeid(bool), (void *) &wg, "", MMseqsParameter::COMMAND_PROFILE | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_STREAM_MSA(PARAM_STREAM_MSA_ID, "--stream-msa", "Stream MSA", "Process MSA members one by one with memory bounded by the query length. Only --cov, --qid and --qsc filters are applied, profiles use global sequence weighting", typeid(bool), (void *) &streamMsa, "", MMseqsParameter::COMMAND_PROFILE | MMseqsParameter::COMMAND_EXPERT),
         PARAM_PCA(PARAM_PCA_ID, "--pca", "Pseudo count a", "Pseudo count admixture strength", typeid(float), (void *) &pca, "^[0-9]*(\\.[0-9]+)?$", MMseqsParameter::COMMAND_PROFILE | MMseqsParameter::COMMAND_EXPERT),
         PARAM_PCB(PARAM_PCB_ID, "--pcb", "Pseudo count b", "Pseudo counts: Neff at half of maximum admixture (range 0.0-inf)", typeid(float), (void *) &pcb, "^[0-9]*(\\.[0-9]+)?$", MMseqsParameter::COMMAND_PROFILE | MMseqsParameter::COMMAND_EXPERT),
         // sequence2profile
@@ -141,6 +154,7 @@ Parameters::Parameters():
         PARAM_REUSELATEST(PARAM_REUSELATEST_ID, "--force-reuse", "Force restart with latest tmp", "Reuse tmp filse in tmp/latest folder ignoring parameters and version changes", typeid(bool), (void *) &reuseLatest, "", MMseqsParameter::COMMAND_COMMON | MMseqsParameter::COMMAND_EXPERT),
         // search workflow
         PARAM_NUM_ITERATIONS(PARAM_NUM_ITERATIONS_ID, "--num-iterations", "Search iterations", "Number of iterative profile search iterations", typeid(int), (void *) &numIterations, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PROFILE),
+        PARAM_REUSE_ITERATION_HITS(PARAM_REUSE_ITERATION_HITS_ID, "--reuse-iteration-hits", "Reuse iteration hits", "Rescore the hits of the previous iteration with the updated profile and prefilter only queries that gained new hits", typeid(bool), (void *) &reuseIterationHits, "", MMseqsParameter::COMMAND_PROFILE | MMseqsParameter::COMMAND_EXPERT),
         PARAM_START_SENS(PARAM_START_SENS_ID, "--start-sens", "Start sensitivity", "Start sensitivity", typeid(float), (void *) &startSens, "^[0-9]*(\\.[0-9]+)?$"),
         PARAM_SENS_STEPS(PARAM_SENS_STEPS_ID, "--sens-steps", "Search steps", "Number of search steps performed from --start-sens to -s", typeid(int), (void *) &sensSteps, "^[1-9]{1}$"),
         PARAM_SLICE_SEARCH(PARAM_SLICE_SEARCH_ID, "--slice-search", "Slice search mode", "For bigger profile DB, run iteratively the search by greedily swapping the search results", typeid(bool), (void *) &sliceSearch, "", MMseqsParameter::COMMAND_PROFILE | MMseqsParameter::COMMAND_EXPERT),
@@ -215,6 +229,8 @@ Parameters::Parameters():
         PARAM_OUTPUT_DBTYPE(PARAM_OUTPUT_DBTYPE_ID, "--output-dbtype", "Output database type", "Set database type for resulting database: Amino acid sequences 0, Nucl. seq. 1, Profiles 2, Alignment result 5, Clustering result 6, Prefiltering result 7, Taxonomy result 8, Indexed database 9, cA3M MSAs 10, FASTA or A3M MSAs 11, Generic database 12, Omit dbtype file 13, Bi-directional prefiltering result 14, Offsetted headers 15", typeid(int), (void *) &outputDbType, "^(0|[1-9]{1}[0-9]*)$"),
         //diff
         PARAM_USESEQID(PARAM_USESEQID_ID, "--use-seq-id", "Match sequences by their ID", "Sequence ID (Uniprot, GenBank, ...) is used for identifying matches between the old and the new DB", typeid(bool), (void *) &useSequenceId, ""),
+        // apply
+        PARAM_PERSISTENT_WORKERS(PARAM_PERSISTENT_WORKERS_ID, "--persistent-workers", "Persistent workers", "Start the program once per thread and send it all entries as length-prefixed records instead of starting it for each entry", typeid(bool), (void *) &persistentWorkers, ""),
         // prefixid
         PARAM_PREFIX(PARAM_PREFIX_ID, "--prefix", "Prefix", "Use this prefix for all entries", typeid(std::string), (void *) &prefix, ""),
         PARAM_TSV(PARAM_TSV_ID, "--tsv", "Tsv", "Return output in TSV format", typeid(bool), (void *) &tsvOut, ""),
@@ -279,6 +295,11 @@ Parameters::Parameters():
     onlythreads.push_back(&PARAM_THREADS);
     onlythreads.push_back(&PARAM_V);
 
+    // compress
+    compress.push_back(&PARAM_THREADS);
+    compress.push_back(&PARAM_COMPRESSION_DICT);
+    compress.push_back(&PARAM_V);
+
     // threadsandcompression
     threadsandcompression.push_back(&PARAM_THREADS);
     threadsandcompression.push_back(&PARAM_COMPRESSED);
@@ -323,6 +344,7 @@ Parameters::Parameters():
     align.push_back(&PARAM_MIN_ALN_LEN);
     align.push_back(&PARAM_SEQ_ID_MODE);
     align.push_back(&PARAM_ALT_ALIGNMENT);
+    align.push_back(&PARAM_TARGET_SWEEP_BATCH);
     align.push_back(&PARAM_C);
     align.push_back(&PARAM_COV_MODE);
     align.push_back(&PARAM_MAX_SEQ_LEN);
@@ -338,8 +360,10 @@ Parameters::Parameters():
     align.push_back(&PARAM_GAP_OPEN);
     align.push_back(&PARAM_GAP_EXTEND);
     align.push_back(&PARAM_ZDROP);
+    align.push_back(&PARAM_MPI_DYNAMIC);
     align.push_back(&PARAM_THREADS);
     align.push_back(&PARAM_COMPRESSED);
+    align.push_back(&PARAM_METRICS_FILE);
     align.push_back(&PARAM_V);
 
     // prefilter
@@ -354,6 +378,7 @@ Parameters::Parameters():
     prefilter.push_back(&PARAM_SPLIT);
     prefilter.push_back(&PARAM_SPLIT_MODE);
     prefilter.push_back(&PARAM_SPLIT_MEMORY_LIMIT);
+    prefilter.push_back(&PARAM_SPLIT_PIPELINE);
     prefilter.push_back(&PARAM_C);
     prefilter.push_back(&PARAM_COV_MODE);
     prefilter.push_back(&PARAM_NO_COMP_BIAS_CORR);
@@ -369,8 +394,14 @@ Parameters::Parameters():
     prefilter.push_back(&PARAM_PCB);
     prefilter.push_back(&PARAM_SPACED_KMER_PATTERN);
     prefilter.push_back(&PARAM_LOCAL_TMP);
+    prefilter.push_back(&PARAM_MPI_DYNAMIC);
+    prefilter.push_back(&PARAM_HUGE_PAGES);
+    prefilter.push_back(&PARAM_NUMA_MODE);
+    prefilter.push_back(&PARAM_QUERY_BATCH_SIZE);
+    prefilter.push_back(&PARAM_QUERY_CACHE_LIMIT);
     prefilter.push_back(&PARAM_THREADS);
     prefilter.push_back(&PARAM_COMPRESSED);
+    prefilter.push_back(&PARAM_METRICS_FILE);
     prefilter.push_back(&PARAM_V);
 
     // ungappedprefilter
@@ -383,6 +414,7 @@ Parameters::Parameters():
     ungappedprefilter.push_back(&PARAM_MAX_SEQS);
     ungappedprefilter.push_back(&PARAM_THREADS);
     ungappedprefilter.push_back(&PARAM_COMPRESSED);
+    ungappedprefilter.push_back(&PARAM_METRICS_FILE);
     ungappedprefilter.push_back(&PARAM_V);
 
     // clustering
@@ -391,6 +423,7 @@ Parameters::Parameters():
     clust.push_back(&PARAM_SIMILARITYSCORE);
     clust.push_back(&PARAM_THREADS);
     clust.push_back(&PARAM_COMPRESSED);
+    clust.push_back(&PARAM_METRICS_FILE);
     clust.push_back(&PARAM_V);
 
     // rescorediagonal
@@ -410,6 +443,7 @@ Parameters::Parameters():
     rescorediagonal.push_back(&PARAM_PRELOAD_MODE);
     rescorediagonal.push_back(&PARAM_THREADS);
     rescorediagonal.push_back(&PARAM_COMPRESSED);
+    rescorediagonal.push_back(&PARAM_METRICS_FILE);
     rescorediagonal.push_back(&PARAM_V);
 
     // alignbykmer
@@ -458,6 +492,7 @@ Parameters::Parameters():
     result2profile.push_back(&PARAM_E_PROFILE);
     result2profile.push_back(&PARAM_NO_COMP_BIAS_CORR);
     result2profile.push_back(&PARAM_WG);
+    result2profile.push_back(&PARAM_STREAM_MSA);
     result2profile.push_back(&PARAM_ALLOW_DELETION);
     result2profile.push_back(&PARAM_FILTER_MSA);
     result2profile.push_back(&PARAM_FILTER_MAX_SEQ_ID);
@@ -524,6 +559,7 @@ Parameters::Parameters():
     result2msa.push_back(&PARAM_FILTER_QSC);
     result2msa.push_back(&PARAM_FILTER_COV);
     result2msa.push_back(&PARAM_FILTER_NDIFF);
+    result2msa.push_back(&PARAM_STREAM_MSA);
     result2msa.push_back(&PARAM_THREADS);
     result2msa.push_back(&PARAM_COMPRESS_MSA);
     result2msa.push_back(&PARAM_SUMMARIZE_HEADER);
@@ -554,6 +590,7 @@ Parameters::Parameters():
     filterresult.push_back(&PARAM_FILTER_QSC);
     filterresult.push_back(&PARAM_FILTER_COV);
     filterresult.push_back(&PARAM_FILTER_NDIFF);
+    filterresult.push_back(&PARAM_STREAM_MSA);
     filterresult.push_back(&PARAM_THREADS);
     filterresult.push_back(&PARAM_COMPRESSED);
     filterresult.push_back(&PARAM_V);
@@ -655,6 +692,14 @@ Parameters::Parameters():
     splitsequence.push_back(&PARAM_COMPRESSED);
     splitsequence.push_back(&PARAM_V);
 
+    // createmaskdb
+    createmaskdb.push_back(&PARAM_SUB_MAT);
+    createmaskdb.push_back(&PARAM_SEED_SUB_MAT);
+    createmaskdb.push_back(&PARAM_ALPH_SIZE);
+    createmaskdb.push_back(&PARAM_MASK_DB_MODE);
+    createmaskdb.push_back(&PARAM_THREADS);
+    createmaskdb.push_back(&PARAM_V);
+
     // splitdb
     splitdb.push_back(&PARAM_SPLIT);
     splitdb.push_back(&PARAM_SPLIT_AMINOACID);
@@ -679,6 +724,8 @@ Parameters::Parameters():
     indexdb.push_back(&PARAM_SPLIT);
     indexdb.push_back(&PARAM_SPLIT_MEMORY_LIMIT);
     indexdb.push_back(&PARAM_V);
+    indexdb.push_back(&PARAM_HUGE_PAGES);
+    indexdb.push_back(&PARAM_NUMA_MODE);
     indexdb.push_back(&PARAM_THREADS);
 
     // create kmer index
@@ -709,6 +756,7 @@ Parameters::Parameters():
     createdb.push_back(&PARAM_WRITE_LOOKUP);
     createdb.push_back(&PARAM_ID_OFFSET);
     createdb.push_back(&PARAM_COMPRESSED);
+    createdb.push_back(&PARAM_COMPRESSION_DICT);
     createdb.push_back(&PARAM_V);
 
     // convert2fasta
@@ -717,6 +765,7 @@ Parameters::Parameters():
 
     // result2flat
     result2flat.push_back(&PARAM_USE_HEADER);
+    result2flat.push_back(&PARAM_THREADS);
     result2flat.push_back(&PARAM_V);
 
     // result2repseq
@@ -804,6 +853,7 @@ Parameters::Parameters():
     tsv2db.push_back(&PARAM_INCLUDE_IDENTITY);
     tsv2db.push_back(&PARAM_OUTPUT_DBTYPE);
     tsv2db.push_back(&PARAM_COMPRESSED);
+    tsv2db.push_back(&PARAM_THREADS);
     tsv2db.push_back(&PARAM_V);
 
     // swap results
@@ -835,6 +885,7 @@ Parameters::Parameters():
     clusthash.push_back(&PARAM_ALPH_SIZE);
     clusthash.push_back(&PARAM_MIN_SEQ_ID);
     clusthash.push_back(&PARAM_MAX_SEQ_LEN);
+    clusthash.push_back(&PARAM_MINIMIZER_SKETCH_SIZE);
     clusthash.push_back(&PARAM_PRELOAD_MODE);
     clusthash.push_back(&PARAM_THREADS);
     clusthash.push_back(&PARAM_COMPRESSED);
@@ -861,6 +912,7 @@ Parameters::Parameters():
     kmermatcher.push_back(&PARAM_IGNORE_MULTI_KMER);
     kmermatcher.push_back(&PARAM_THREADS);
     kmermatcher.push_back(&PARAM_COMPRESSED);
+    kmermatcher.push_back(&PARAM_METRICS_FILE);
     kmermatcher.push_back(&PARAM_V);
 
     // kmermatcher
@@ -904,6 +956,12 @@ Parameters::Parameters():
     diff.push_back(&PARAM_COMPRESSED);
     diff.push_back(&PARAM_V);
 
+    // apply
+    apply.push_back(&PARAM_PERSISTENT_WORKERS);
+    apply.push_back(&PARAM_THREADS);
+    apply.push_back(&PARAM_COMPRESSED);
+    apply.push_back(&PARAM_V);
+
     // prefixid
     prefixid.push_back(&PARAM_PREFIX);
     prefixid.push_back(&PARAM_MAPPING_FILE);
@@ -1085,6 +1143,7 @@ Parameters::Parameters():
     // needed for slice search, however all its parameters are already present in searchworkflow
     // searchworkflow = combineList(searchworkflow, sortresult);
     searchworkflow.push_back(&PARAM_NUM_ITERATIONS);
+    searchworkflow.push_back(&PARAM_REUSE_ITERATION_HITS);
     searchworkflow.push_back(&PARAM_START_SENS);
     searchworkflow.push_back(&PARAM_SENS_STEPS);
     searchworkflow.push_back(&PARAM_SLICE_SEARCH);
@@ -1618,6 +1677,7 @@ void Parameters::parseParameters(int argc, const char *pargv[], const Command &c
     if (MMseqsMPI::isMaster()) {
         Debug::setDebugLevel(verbosity);
     }
+    PageAllocator::configure(hugePages, numaMode);
 
 #ifdef OPENMP
     omp_set_num_threads(threads);
@@ -1981,13 +2041,17 @@ void Parameters::setDefaults() {
     split = AUTO_SPLIT_DETECTION;
     splitMode = DETECT_BEST_DB_SPLIT;
     splitMemoryLimit = 0;
+    splitPipeline = false;
     diskSpaceLimit = 0;
     splitAA = false;
     spacedKmerPattern = "";
     localTmp = "";
+    mpiDynamic = false;
+    metricsFile = "";
 
     // search workflow
     numIterations = 1;
+    reuseIterationHits = false;
     startSens = 4;
     sensSteps = 1;
     sliceSearch = false;
@@ -1998,6 +2062,7 @@ void Parameters::setDefaults() {
 
     threads = 1;
     compressed = WRITER_ASCII_MODE;
+    compressionDict = true;
 #ifdef OPENMP
     char * threadEnv = getenv("MMSEQS_NUM_THREADS");
     if (threadEnv != NULL) {
@@ -2017,6 +2082,7 @@ void Parameters::setDefaults() {
     exactKmerMatching = 0;
     maskMode = 1;
     maskLowerCaseMode = 0;
+    maskDbMode = MASK_DB_PREFILTER;
     minDiagScoreThr = 15;
     spacedKmer = true;
     includeIdentity = false;
@@ -2030,6 +2096,7 @@ void Parameters::setDefaults() {
     seqIdThr = 0.0;
     alnLenThr = 0;
     altAlignment = 0;
+    targetSweepBatch = 0;
     gapOpen = MultiParam<int>(11, 5);
     gapExtend = MultiParam<int>(1, 2);
     zdrop = 40;
@@ -2038,8 +2105,13 @@ void Parameters::setDefaults() {
     clusteringMode = SET_COVER;
     singleStepClustering = false;
     clusterReassignment = 0;
+    minimizerSketchSize = 0;
     clusterSteps = 3;
     preloadMode = 0;
+    hugePages = PageAllocator::HUGE_PAGES_OFF;
+    numaMode = PageAllocator::NUMA_MODE_LOCAL;
+    queryBatchSize = 0;
+    queryCacheLimit = 1024 * 1024 * 1024;
     scoreBias = 0.0;
 
     // affinity clustering
@@ -2097,6 +2169,7 @@ void Parameters::setDefaults() {
     covMSAThr = 0.0;           // default for minimum coverage threshold
     Ndiff = 1000;        // pick Ndiff most different sequences from alignment
     wg = false;
+    streamMsa = false;
     pca = 1.0;
     pcb = 1.5;
 
@@ -2178,6 +2251,9 @@ void Parameters::setDefaults() {
     // diff
     useSequenceId = false;
 
+    // apply
+    persistentWorkers = false;
+
     // prefixid
     prefix = "";
     tsvOut = false;
@@ -227,6 +227,10 @@ public:
 
     static const int CLUST_HASH_DEFAULT_ALPH_SIZE = 3;
     static const int CLUST_HASH_DEFAULT_MIN_SEQ_ID = 99;
+    // k-mer length and window of the minimizer sketches of clusthash
+    static const int CLUST_HASH_SKETCH_AA_KMER_SIZE = 12;
+    static const int CLUST_HASH_SKETCH_NUCL_KMER_SIZE = 24;
+    static const int CLUST_HASH_SKETCH_WINDOW = 10;
     static const int CLUST_LINEAR_DEFAULT_ALPH_SIZE = 13;
     static const int CLUST_LINEAR_DEFAULT_K = 0;
     static const int CLUST_LINEAR_KMER_PER_SEQ = 0;
@@ -244,6 +248,11 @@ public:
     static const int SEQ_ID_SHORT = 1;
     static const int SEQ_ID_LONG = 2;
 
+    // createmaskdb
+    static const int MASK_DB_PREFILTER = 0;
+    static const int MASK_DB_MASKSEQUENCE = 1;
+    static const int MASK_DB_KMERMATCHER = 2;
+
     // seq. split mode
     static const int SEQUENCE_SPLIT_MODE_HARD = 0;
     static const int SEQUENCE_SPLIT_MODE_SOFT = 1;
@@ -340,6 +349,7 @@ public:
     int    verbosity;                    // log level
     int    threads;                      // Amounts of threads
     int    compressed;                   // compressed writer
+    bool   compressionDict;              // train a zstd dictionary for compressed databases
     bool   removeTmpFiles;               // Do not delete temp files
     bool   includeIdentity;              // include identical ids as hit
 
@@ -353,18 +363,26 @@ public:
     int    exactKmerMatching;            // only exact k-mer matching
     int    maskMode;                     // mask low complex areas
     int    maskLowerCaseMode;            // mask lowercase letters in prefilter and kmermatchers
+    int    maskDbMode;                   // module whose masking settings createmaskdb uses
 
     int    minDiagScoreThr;              // min diagonal score
     int    spacedKmer;                   // Spaced Kmers
     int    split;                        // Split database in n equal chunks
     int    splitMode;                    // Split by query or target DB
     size_t splitMemoryLimit;             // Maximum memory in bytes a split can use
+    bool splitPipeline;                  // Build the next target split index while searching the current one
     size_t diskSpaceLimit;               // Maximum disk space in bytes for sliced reverse profile search
     bool   splitAA;                      // Split database by amino acid count instead
     int    preloadMode;                  // Preload mode of database
+    int    hugePages;                    // Back the prefilter index tables with huge pages
+    int    numaMode;                     // NUMA placement of the prefilter index tables
+    int    queryBatchSize;               // Match the k-mers of this many queries in one index table sweep
+    size_t queryCacheLimit;              // Maximum memory in bytes for the queries kept between target splits
     float  scoreBias;                    // Add this bias to the score when computing the alignements
     std::string spacedKmerPattern;       // User-specified kmer pattern
     std::string localTmp;                // Local temporary path
+    bool mpiDynamic;                     // Hand out query chunks to MPI ranks on demand
+    std::string metricsFile;             // Append per module performance metrics as JSON
 
     // ALIGNMENT
     int alignmentMode;                   // alignment mode 0=fastest on parameters,
@@ -377,6 +395,7 @@ public:
     int    maxRejected;                  // after n sequences that are above eval stop
     int    maxAccept;                    // after n accepted sequences stop
     int    altAlignment;                 // show up to this many alternative alignments
+    int    targetSweepBatch;             // read the targets of this many queries in one sweep before aligning
     float  seqIdThr;                     // sequence identity threshold for acceptance
     int    alnLenThr;                    // min. alignment length
     bool   addBacktrace;                 // store backtrace string (M=Match, D=deletion, I=insertion)
@@ -394,9 +413,11 @@ public:
     int    clusterSteps;
     bool   singleStepClustering;
     int    clusterReassignment;
+    int    minimizerSketchSize;
 
     // SEARCH WORKFLOW
     int numIterations;
+    bool reuseIterationHits;
     float startSens;
     int sensSteps;
     bool sliceSearch;
@@ -461,6 +482,7 @@ public:
     float covMSAThr;
     int Ndiff;
     bool wg;
+    bool streamMsa;
     float pca;
     float pcb;
 
@@ -570,6 +592,9 @@ public:
     // diff
     bool useSequenceId;
 
+    // apply
+    bool persistentWorkers;
+
     // prefixid
     std::string prefix;
     bool tsvOut;
@@ -650,12 +675,14 @@ public:
     PARAMETER(PARAM_K)
     PARAMETER(PARAM_THREADS)
     PARAMETER(PARAM_COMPRESSED)
+    PARAMETER(PARAM_COMPRESSION_DICT)
     PARAMETER(PARAM_ALPH_SIZE)
     PARAMETER(PARAM_MAX_SEQ_LEN)
     PARAMETER(PARAM_DIAGONAL_SCORING)
     PARAMETER(PARAM_EXACT_KMER_MATCHING)
     PARAMETER(PARAM_MASK_RESIDUES)
     PARAMETER(PARAM_MASK_LOWER_CASE)
+    PARAMETER(PARAM_MASK_DB_MODE)
 
     PARAMETER(PARAM_MIN_DIAG_SCORE)
     PARAMETER(PARAM_K_SCORE)
@@ -663,6 +690,7 @@ public:
     PARAMETER(PARAM_SPLIT)
     PARAMETER(PARAM_SPLIT_MODE)
     PARAMETER(PARAM_SPLIT_MEMORY_LIMIT)
+    PARAMETER(PARAM_SPLIT_PIPELINE)
     PARAMETER(PARAM_DISK_SPACE_LIMIT)
     PARAMETER(PARAM_SPLIT_AMINOACID)
     PARAMETER(PARAM_SUB_MAT)
@@ -672,8 +700,14 @@ public:
     PARAMETER(PARAM_REMOVE_TMP_FILES)
     PARAMETER(PARAM_INCLUDE_IDENTITY)
     PARAMETER(PARAM_PRELOAD_MODE)
+    PARAMETER(PARAM_HUGE_PAGES)
+    PARAMETER(PARAM_NUMA_MODE)
+    PARAMETER(PARAM_QUERY_BATCH_SIZE)
+    PARAMETER(PARAM_QUERY_CACHE_LIMIT)
     PARAMETER(PARAM_SPACED_KMER_PATTERN)
     PARAMETER(PARAM_LOCAL_TMP)
+    PARAMETER(PARAM_MPI_DYNAMIC)
+    PARAMETER(PARAM_METRICS_FILE)
     std::vector<MMseqsParameter*> prefilter;
     std::vector<MMseqsParameter*> ungappedprefilter;
 
@@ -691,6 +725,7 @@ public:
     PARAMETER(PARAM_MIN_ALN_LEN)
     PARAMETER(PARAM_SCORE_BIAS)
     PARAMETER(PARAM_ALT_ALIGNMENT)
+    PARAMETER(PARAM_TARGET_SWEEP_BATCH)
     PARAMETER(PARAM_GAP_OPEN)
     PARAMETER(PARAM_GAP_EXTEND)
     PARAMETER(PARAM_ZDROP)
@@ -700,6 +735,7 @@ public:
     PARAMETER(PARAM_CLUSTER_STEPS)
     PARAMETER(PARAM_CASCADED)
     PARAMETER(PARAM_CLUSTER_REASSIGN)
+    PARAMETER(PARAM_MINIMIZER_SKETCH_SIZE)
 
     // affinity clustering
     PARAMETER(PARAM_MAXITERATIONS)
@@ -745,6 +781,7 @@ public:
     PARAMETER(PARAM_FILTER_COV)
     PARAMETER(PARAM_FILTER_NDIFF)
     PARAMETER(PARAM_WG)
+    PARAMETER(PARAM_STREAM_MSA)
     PARAMETER(PARAM_PCA)
     PARAMETER(PARAM_PCB)
 
@@ -776,6 +813,7 @@ public:
 
     // search workflow
     PARAMETER(PARAM_NUM_ITERATIONS)
+    PARAMETER(PARAM_REUSE_ITERATION_HITS)
     PARAMETER(PARAM_START_SENS)
     PARAMETER(PARAM_SENS_STEPS)
     PARAMETER(PARAM_SLICE_SEARCH)
@@ -867,6 +905,9 @@ public:
     // diff
     PARAMETER(PARAM_USESEQID)
 
+    // apply
+    PARAMETER(PARAM_PERSISTENT_WORKERS)
+
     // prefixid
     PARAMETER(PARAM_PREFIX)
     PARAMETER(PARAM_TSV)
@@ -939,6 +980,7 @@ public:
     std::vector<MMseqsParameter*> view;
     std::vector<MMseqsParameter*> verbandcompression;
     std::vector<MMseqsParameter*> onlythreads;
+    std::vector<MMseqsParameter*> compress;
     std::vector<MMseqsParameter*> threadsandcompression;
 
     std::vector<MMseqsParameter*> alignall;
@@ -963,6 +1005,7 @@ public:
     std::vector<MMseqsParameter*> reverseseq;
     std::vector<MMseqsParameter*> splitdb;
     std::vector<MMseqsParameter*> splitsequence;
+    std::vector<MMseqsParameter*> createmaskdb;
     std::vector<MMseqsParameter*> indexdb;
     std::vector<MMseqsParameter*> kmerindexdb;
     std::vector<MMseqsParameter*> createindex;
@@ -999,6 +1042,7 @@ public:
     std::vector<MMseqsParameter*> proteinaln2nucl;
     std::vector<MMseqsParameter*> subtractdbs;
     std::vector<MMseqsParameter*> diff;
+    std::vector<MMseqsParameter*> apply;
     std::vector<MMseqsParameter*> concatdbs;
     std::vector<MMseqsParameter*> mergedbs;
     std::vector<MMseqsParameter*> summarizeheaders;
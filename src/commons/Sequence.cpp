@@ -367,6 +367,43 @@ void Sequence::mapProfile(const char * profileData, bool mapScores, unsigned int
 //    printProfile();
 }
 
+size_t Sequence::getMappedProfileSize() const {
+    return static_cast<size_t>(L) * (sizeof(unsigned char) + PROFILE_AA_SIZE * (sizeof(short) + sizeof(unsigned int) + sizeof(int8_t)));
+}
+
+void Sequence::storeMappedProfile(char *data) const {
+    memcpy(data, numSequence, L * sizeof(unsigned char));
+    data += L * sizeof(unsigned char);
+    // only the first PROFILE_AA_SIZE entries of a row are written by mapProfile
+    for (int i = 0; i < L; i++) {
+        memcpy(data, &profile_score[i * PROFILE_ROW_SIZE], PROFILE_AA_SIZE * sizeof(short));
+        data += PROFILE_AA_SIZE * sizeof(short);
+    }
+    for (int i = 0; i < L; i++) {
+        memcpy(data, &profile_index[i * PROFILE_ROW_SIZE], PROFILE_AA_SIZE * sizeof(unsigned int));
+        data += PROFILE_AA_SIZE * sizeof(unsigned int);
+    }
+    memcpy(data, profile_for_alignment, PROFILE_AA_SIZE * L * sizeof(int8_t));
+}
+
+void Sequence::restoreMappedProfile(size_t id, unsigned int dbKey, const char *data, unsigned int seqLen) {
+    this->id = id;
+    this->dbKey = dbKey;
+    this->seqData = NULL;
+    this->L = seqLen;
+    memcpy(numSequence, data, L * sizeof(unsigned char));
+    data += L * sizeof(unsigned char);
+    for (int i = 0; i < L; i++) {
+        memcpy(&profile_score[i * PROFILE_ROW_SIZE], data, PROFILE_AA_SIZE * sizeof(short));
+        data += PROFILE_AA_SIZE * sizeof(short);
+    }
+    for (int i = 0; i < L; i++) {
+        memcpy(&profile_index[i * PROFILE_ROW_SIZE], data, PROFILE_AA_SIZE * sizeof(unsigned int));
+        data += PROFILE_AA_SIZE * sizeof(unsigned int);
+    }
+    memcpy(profile_for_alignment, data, PROFILE_AA_SIZE * L * sizeof(int8_t));
+    currItPos = -1;
+}
 
 template <int T>
 void Sequence::mapProfileState(const char * profileState, unsigned int seqLen){
@@ -94,6 +94,13 @@ public:
     // map the profile state sequence
     void mapProfileStateSequence(const char *profileStateSeq, unsigned int seqLen);
 
+    // size of the mapped scores of a profile HMM (query residues, k-mer scores and alignment profile)
+    size_t getMappedProfileSize() const;
+
+    // copy the mapped scores of a profile HMM to data, restoring them skips the pseudo-count and score computation
+    void storeMappedProfile(char *data) const;
+    void restoreMappedProfile(size_t id, unsigned int dbKey, const char *data, unsigned int seqLen);
+
     // checks if there is still a k-mer left
     bool hasNextKmer() {
         return (((currItPos + 1) + this->spacedPatternSize) <= this->L);
@@ -0,0 +1,99 @@
+#include "SequenceMasks.h"
+#include "FileUtil.h"
+#include "Debug.h"
+#include "Util.h"
+
+#include <cstring>
+#include <fstream>
+
+SequenceMasks::SequenceMasks(const std::string &sequenceDb, int threads)
+        : reader(getMaskDbName(sequenceDb).c_str(), (getMaskDbName(sequenceDb) + ".index").c_str(), threads,
+                 DBReader<unsigned int>::USE_DATA | DBReader<unsigned int>::USE_INDEX) {
+    reader.open(DBReader<unsigned int>::NOSORT);
+    Debug(Debug::INFO) << "Using precomputed masks of " << getMaskDbName(sequenceDb) << "\n";
+}
+
+SequenceMasks::~SequenceMasks() {
+    reader.close();
+}
+
+bool SequenceMasks::hasMaskDb(const std::string &sequenceDb) {
+    return FileUtil::fileExists((getMaskDbName(sequenceDb) + ".dbtype").c_str());
+}
+
+std::string SequenceMasks::getSettings(DBReader<unsigned int> &sequenceDbr, const BaseMatrix &subMat,
+                                       double repeatOffsetProbDecay, double minMaskProb) {
+    // reduced matrices have no name, their probabilities still tell them apart
+    size_t probHash = 0;
+    for (int i = 0; i < subMat.alphabetSize; i++) {
+        probHash = probHash * 31 + Util::hash(reinterpret_cast<const unsigned char *>(subMat.probMatrix[i]), subMat.alphabetSize * sizeof(double));
+    }
+    return "matrix=" + subMat.matrixName + " alphabetSize=" + SSTR(subMat.alphabetSize) + " probabilities=" + SSTR(probHash)
+           + " repeatOffsetProbDecay=" + SSTR(repeatOffsetProbDecay) + " minMaskProb=" + SSTR(minMaskProb)
+           + " entries=" + SSTR(sequenceDbr.getSize()) + " dataSize=" + SSTR(sequenceDbr.getDataSize());
+}
+
+void SequenceMasks::writeSettings(const std::string &sequenceDb, const std::string &settings) {
+    FILE *file = FileUtil::openAndDelete(getSettingsFileName(sequenceDb).c_str(), "w");
+    if (fprintf(file, "%s\n", settings.c_str()) < 0) {
+        Debug(Debug::ERROR) << "Cannot write " << getSettingsFileName(sequenceDb) << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (fclose(file) != 0) {
+        Debug(Debug::ERROR) << "Cannot close " << getSettingsFileName(sequenceDb) << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
+SequenceMasks *SequenceMasks::openIfExists(const std::string &sequenceDb, const std::string &settings, int threads) {
+    if (hasMaskDb(sequenceDb) == false) {
+        return NULL;
+    }
+    std::string maskSettings;
+    std::ifstream settingsFile(getSettingsFileName(sequenceDb).c_str());
+    if (settingsFile.good() == false || std::getline(settingsFile, maskSettings).fail() || maskSettings != settings) {
+        Debug(Debug::INFO) << "Precomputed masks of " << getMaskDbName(sequenceDb) << " do not match the masking settings, recomputing them\n";
+        return NULL;
+    }
+    return new SequenceMasks(sequenceDb, threads);
+}
+
+void SequenceMasks::encodeRuns(const char *sequence, const char *maskedSequence, size_t length, std::vector<unsigned int> &runs) {
+    runs.push_back(static_cast<unsigned int>(length));
+    size_t pos = 0;
+    while (pos < length) {
+        if (sequence[pos] == maskedSequence[pos]) {
+            pos++;
+            continue;
+        }
+        size_t start = pos;
+        while (pos < length && sequence[pos] != maskedSequence[pos]) {
+            pos++;
+        }
+        runs.push_back(static_cast<unsigned int>(start));
+        runs.push_back(static_cast<unsigned int>(pos - start));
+    }
+}
+
+bool SequenceMasks::applyMask(unsigned int key, unsigned char *sequence, size_t length, unsigned char maskLetter,
+                              unsigned int thread_idx, size_t &maskedResidues) {
+    size_t id = reader.getId(key);
+    if (id == UINT_MAX || reader.getEntryLen(id) < sizeof(unsigned int) + 1) {
+        return false;
+    }
+    const char *data = reader.getData(id, thread_idx);
+    unsigned int maskLength;
+    memcpy(&maskLength, data, sizeof(unsigned int));
+    if (maskLength != length) {
+        return false;
+    }
+    data += sizeof(unsigned int);
+    const size_t runCount = (reader.getEntryLen(id) - 1 - sizeof(unsigned int)) / (2 * sizeof(unsigned int));
+    for (size_t i = 0; i < runCount; i++) {
+        unsigned int run[2];
+        memcpy(run, data + i * sizeof(run), sizeof(run));
+        memset(sequence + run[0], maskLetter, run[1]);
+        maskedResidues += run[1];
+    }
+    return true;
+}
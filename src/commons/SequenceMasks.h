@@ -0,0 +1,55 @@
+#ifndef MMSEQS_SEQUENCEMASKS_H
+#define MMSEQS_SEQUENCEMASKS_H
+
+// Low complexity masks precomputed by createmaskdb. They are stored in the sidecar database
+// <sequenceDB>_mask, keyed like the sequence database. Each entry starts with the masked sequence length
+// as unsigned int followed by a run-length encoded list of (start, length) unsigned int pairs of masked
+// residues. The tantan settings of the masks and the size of the sequence database are stored in
+// <sequenceDB>_mask.settings. Modules that mask with tantan use these runs instead of recomputing the masks
+// if the sidecar exists and was computed with their settings, see --mask-db-mode of createmaskdb.
+
+#include "DBReader.h"
+#include "BaseMatrix.h"
+
+#include <string>
+#include <vector>
+
+class SequenceMasks {
+public:
+    SequenceMasks(const std::string &sequenceDb, int threads);
+    ~SequenceMasks();
+
+    static std::string getMaskDbName(const std::string &sequenceDb) {
+        return sequenceDb + "_mask";
+    }
+
+    static std::string getSettingsFileName(const std::string &sequenceDb) {
+        return getMaskDbName(sequenceDb) + ".settings";
+    }
+
+    static bool hasMaskDb(const std::string &sequenceDb);
+
+    // the probabilities of the matrix and the tantan options determine the masks
+    // the entry count and data size of the sequence database catch sidecars of a rewritten database
+    static std::string getSettings(DBReader<unsigned int> &sequenceDbr, const BaseMatrix &subMat,
+                                   double repeatOffsetProbDecay, double minMaskProb);
+
+    static void writeSettings(const std::string &sequenceDb, const std::string &settings);
+
+    // returns NULL if there is no sidecar for sequenceDb or if it was computed with other settings
+    static SequenceMasks *openIfExists(const std::string &sequenceDb, const std::string &settings, int threads);
+
+    // appends the sequence length and the runs of positions that differ between the sequence and its masked version
+    static void encodeRuns(const char *sequence, const char *maskedSequence, size_t length, std::vector<unsigned int> &runs);
+
+    // sets all masked residues of the entry with the given key to maskLetter and adds their number to maskedResidues
+    // returns false without changing the sequence if the entry is missing or was computed for another length,
+    // the caller has to mask the sequence itself then
+    bool applyMask(unsigned int key, unsigned char *sequence, size_t length, unsigned char maskLetter,
+                   unsigned int thread_idx, size_t &maskedResidues);
+
+private:
+    DBReader<unsigned int> reader;
+};
+
+#endif
@@ -59,6 +59,12 @@ template<> std::string SSTR(float);
 #define UNLIKELY(x) (x)
 #endif
 
+#if defined(__GNUC__) || __has_builtin(__builtin_prefetch)
+#define PREFETCH(x) __builtin_prefetch((x))
+#else
+#define PREFETCH(x)
+#endif
+
 #ifndef __has_attribute
 #define __has_attribute(x) 0
 #endif
@@ -18,6 +18,7 @@ private:
     size_t * entryOffsets;
     size_t prevKmerStartRange;
     long long iteratorPos;
+    long long iteratorEnd;
     size_t entryOffsetPos;
     size_t writingPosition;
     // total entries count
@@ -73,7 +74,7 @@ public:
 
 
     bool hasNextEntry(){
-        return (iteratorPos + 1 < static_cast<long long>(entryCount));
+        return (iteratorPos + 1 < iteratorEnd);
     }
 
     template <int TYPE>
@@ -173,14 +174,15 @@ public:
         return entryCount;
     }
 
-    KmerIndex(int alphabetSize, int kmerSize, char *entriesData, char *entriesOffetData,
+    // the grid size is taken from the stored offsets, the writer might have used a different alphabet size
+    KmerIndex(int alphabetSize, int kmerSize, char *entriesData, char *entriesOffetData, size_t entriesOffsetsSize,
               size_t entryCount, size_t gridResolution) {
         this->alphabetSize = alphabetSize;
         this->kmerSize = kmerSize;
         this->isMmaped = true;
         this->entries =  (KmerEntryRelative * )entriesData;
         this->entryCount = entryCount;
-        this->indexGridSize = MathUtil::ceilIntDivision( MathUtil::ipow<size_t>(alphabetSize, kmerSize), gridResolution );
+        this->indexGridSize = std::min(MathUtil::ceilIntDivision( MathUtil::ipow<size_t>(alphabetSize, kmerSize), gridResolution ), entriesOffsetsSize);
         this->entryOffsets = (size_t *) entriesOffetData;
 #if HAVE_POSIX_MADVISE
         if (posix_madvise (entriesData, entryCount* sizeof(KmerEntryRelative), POSIX_MADV_SEQUENTIAL) != 0){
@@ -190,6 +192,7 @@ public:
 
         this->prevKmerStartRange = 0;
         this->iteratorPos = -1;
+        this->iteratorEnd = entryCount;
         this->entryOffsetPos = 0;
     }
 
@@ -232,8 +235,22 @@ public:
 
     void reset() {
         this->iteratorPos = -1;
+        this->iteratorEnd = entryCount;
         this->entryOffsetPos = 0;
     }
+
+    // start of the entries of a grid cell, the stored offsets do not contain the end of the last cell
+    size_t getGridOffset(size_t gridPos) {
+        return (gridPos < indexGridSize) ? entryOffsets[gridPos] : entryCount;
+    }
+
+    // restrict the iterator to the entries of the grid cells [gridFrom, gridTo)
+    // copies of a mmaped index share the data, so each thread can iterate its own range
+    void setGridRange(size_t gridFrom, size_t gridTo) {
+        this->iteratorPos = static_cast<long long>(getGridOffset(gridFrom)) - 1;
+        this->iteratorEnd = static_cast<long long>(getGridOffset(gridTo));
+        this->entryOffsetPos = gridFrom;
+    }
 };
 
 #endif //MMSEQS_KMERINDEX_H
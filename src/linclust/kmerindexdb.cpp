@@ -243,10 +243,15 @@ int kmerindexdb(int argc, const char **argv, const Command &command) {
         dbw.writeEnd( PrefilteringIndexReader::DBR1DATA, 0);
         dbw.alignToPageSize();
         free(data);
+        size_t offsetDict = dbw.getOffset(0);
+        size_t dictSize = PrefilteringIndexReader::writeDictionary(dbw, &dbr1, PrefilteringIndexReader::DBR1DICT, "DBR1DICT");
 
         if (sameDB == true) {
             dbw.writeIndexEntry(PrefilteringIndexReader::DBR2INDEX, offsetIndex, DBReader<unsigned int>::indexMemorySize(dbr1)+1, 0);
             dbw.writeIndexEntry(PrefilteringIndexReader::DBR2DATA,  offsetData,  dbr1.getTotalDataSize()+1, 0);
+            if (dictSize > 0) {
+                dbw.writeIndexEntry(PrefilteringIndexReader::DBR2DICT, offsetDict, dictSize, 0);
+            }
             dbr1.close();
         }else{
             dbr1.close();
@@ -264,6 +269,7 @@ int kmerindexdb(int argc, const char **argv, const Command &command) {
             dbw.writeEnd(PrefilteringIndexReader::DBR2DATA, 0);
             dbw.alignToPageSize();
             free(data);
+            PrefilteringIndexReader::writeDictionary(dbw, &dbr2, PrefilteringIndexReader::DBR2DICT, "DBR2DICT");
             dbr2.close();
         }
 
@@ -285,9 +291,14 @@ int kmerindexdb(int argc, const char **argv, const Command &command) {
             dbw.writeEnd(PrefilteringIndexReader::HDR1DATA, 0);
             dbw.alignToPageSize();
             free(data);
+            size_t offsetDict = dbw.getOffset(0);
+            size_t dictSize = PrefilteringIndexReader::writeDictionary(dbw, &hdbr1, PrefilteringIndexReader::HDR1DICT, "HDR1DICT");
             if (sameDB == true) {
                 dbw.writeIndexEntry(PrefilteringIndexReader::HDR2INDEX, offsetIndex, DBReader<unsigned int>::indexMemorySize(hdbr1)+1, 0);
                 dbw.writeIndexEntry(PrefilteringIndexReader::HDR2DATA,  offsetData, hdbr1.getTotalDataSize()+1, 0);
+                if (dictSize > 0) {
+                    dbw.writeIndexEntry(PrefilteringIndexReader::HDR2DICT, offsetDict, dictSize, 0);
+                }
                 hdbr1.close();
             }else{
                 hdbr1.close();
@@ -304,6 +315,7 @@ int kmerindexdb(int argc, const char **argv, const Command &command) {
                 }
                 dbw.writeEnd(PrefilteringIndexReader::HDR2DATA, 0);
                 dbw.alignToPageSize();
+                PrefilteringIndexReader::writeDictionary(dbw, &hdbr2, PrefilteringIndexReader::HDR2DICT, "HDR2DICT");
                 hdbr2.close();
                 free(data);
             }
@@ -37,24 +37,64 @@
 #define SIZE_T_MAX ((size_t) -1)
 #endif
 
-template <typename T>
-KmerPosition<T> *initKmerPositionMemory(size_t size) {
-    KmerPosition<T> * hashSeqPair = new(std::nothrow) KmerPosition<T>[size + 1];
+SequenceRanks::SequenceRanks(DBReader<unsigned int> &reader) : reader(reader), ranks(reader.getSize()), ids(reader.getSize()) {
+    for (size_t i = 0; i < ids.size(); i++) {
+        ids[i] = i;
+    }
+    SORT_PARALLEL(ids.begin(), ids.end(), [&reader](unsigned int first, unsigned int second) {
+        const size_t firstLen = reader.getSeqLen(first);
+        const size_t secondLen = reader.getSeqLen(second);
+        if (firstLen != secondLen) {
+            return firstLen > secondLen;
+        }
+        return reader.getDbKey(first) < reader.getDbKey(second);
+    });
+    for (size_t rank = 0; rank < ids.size(); rank++) {
+        ranks[ids[rank]] = rank;
+    }
+}
+
+unsigned int computeKmerBits(Parameters &par, int seqType) {
+    double valueBits;
+    if (Parameters::isEqualDbtype(seqType, Parameters::DBTYPE_NUCLEOTIDES)) {
+        const int longestKmer = (par.adjustKmerLength) ? std::min(par.kmerSize + 5, 23) : par.kmerSize;
+        valueBits = 2.0 * longestKmer;
+    } else {
+        // the k-mer index is computed without the X letter
+        valueBits = par.kmerSize * log2(static_cast<double>(par.alphabetSize.aminoacids - 1));
+    }
+    // the highest bit stores the strand, the next one tags the sequence hashes and all bits set mark the end of the entries
+    const unsigned int neededBits = static_cast<unsigned int>(ceil(valueBits - 0.0001)) + 2;
+    if (neededBits <= 48) {
+        return 48;
+    } else if (neededBits <= 56) {
+        return 56;
+    }
+    return 64;
+}
+
+template <typename T, unsigned int KmerBits>
+typename KmerPositionType<T, KmerBits>::type *initKmerPositionMemory(size_t size) {
+    typedef typename KmerPositionType<T, KmerBits>::type KmerPos;
+    KmerPos * hashSeqPair = new(std::nothrow) KmerPos[size + 1];
     Util::checkAllocation(hashSeqPair, "Can not allocate memory");
-    size_t pageSize = Util::getPageSize()/sizeof(KmerPosition<T>);
+    size_t pageSize = Util::getPageSize()/sizeof(KmerPos);
 #pragma omp parallel
     {
 #pragma omp for schedule(static)
         for (size_t page = 0; page < size+1; page += pageSize) {
             size_t readUntil = std::min(size+1, page + pageSize) - page;
-            memset(hashSeqPair+page, 0xFF, sizeof(KmerPosition<T>)* readUntil);
+            memset(hashSeqPair+page, 0xFF, sizeof(KmerPos)* readUntil);
         }
     }
     return hashSeqPair;
 }
 
-void maskSequence(int maskMode, int maskLowerCase, Sequence &seq, int maskLetter, ProbabilityMatrix * probMatrix){
-    if (maskMode == 1) {
+void maskSequence(int maskMode, int maskLowerCase, Sequence &seq, int maskLetter, ProbabilityMatrix * probMatrix,
+                  SequenceMasks * sequenceMasks, unsigned int thread_idx){
+    size_t maskedResidues = 0;
+    if (maskMode == 1 && (sequenceMasks == NULL
+                          || sequenceMasks->applyMask(seq.getDbKey(), seq.numSequence, seq.L, maskLetter, thread_idx, maskedResidues) == false)) {
         tantan::maskSequences((char*)seq.numSequence,
                               (char*)(seq.numSequence + seq.L),
                               50 /*options.maxCycleLength*/,
@@ -74,15 +114,19 @@ void maskSequence(int maskMode, int maskLowerCase, Sequence &seq, int maskLetter
     }
 }
 
-template <int TYPE, typename T>
-std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * kmerArray, size_t kmerArraySize, DBReader<unsigned int> &seqDbr,
+template <int TYPE, typename T, unsigned int KmerBits>
+std::pair<size_t, size_t> fillKmerPositionArray(typename KmerPositionType<T, KmerBits>::type * kmerArray, size_t kmerArraySize, DBReader<unsigned int> &seqDbr,
                                                 Parameters & par, BaseMatrix * subMat, bool hashWholeSequence,
-                                                size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution){
+                                                size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution,
+                                                const SequenceRanks *ranks){
+    typedef typename KmerPositionType<T, KmerBits>::type KmerPos;
     size_t offset = 0;
     int querySeqType  =  seqDbr.getDbtype();
     size_t longestKmer = par.kmerSize;
     ProbabilityMatrix *probMatrix = NULL;
+    SequenceMasks *sequenceMasks = NULL;
     if (par.maskMode == 1) {
+        sequenceMasks = SequenceMasks::openIfExists(seqDbr.getDataFileName(), SequenceMasks::getSettings(seqDbr, *subMat, 0.5, 0.9), par.threads);
         probMatrix = new ProbabilityMatrix(*subMat);
     }
 
@@ -113,7 +157,7 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * kmerArray, siz
         Indexer idxer(subMat->alphabetSize - 1,  par.kmerSize);
         const unsigned int BUFFER_SIZE = 1048576;
         size_t bufferPos = 0;
-        KmerPosition<T> * threadKmerBuffer = new KmerPosition<T>[BUFFER_SIZE];
+        KmerPos * threadKmerBuffer = new KmerPos[BUFFER_SIZE];
         SequencePosition * kmers = (SequencePosition *) malloc((par.pickNbest * (par.maxSeqLen + 1) + 1) * sizeof(SequencePosition));
         size_t kmersArraySize = par.maxSeqLen;
         const size_t flushSize = 100000000;
@@ -137,10 +181,11 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * kmerArray, siz
                     seqHash = XXH64(&seqHash, sizeof(size_t), par.hashShift);
                 }
 
-                maskSequence(par.maskMode, par.maskLowerCaseMode, seq, subMat->aa2num[static_cast<int>('X')], probMatrix);
+                maskSequence(par.maskMode, par.maskLowerCaseMode, seq, subMat->aa2num[static_cast<int>('X')], probMatrix, sequenceMasks, thread_idx);
 
                 size_t seqKmerCount = 0;
                 unsigned int seqId = seq.getDbKey();
+                unsigned int seqRank = (ranks != NULL) ? ranks->getRank(id) : 0;
                 while (seq.hasNextKmer()) {
                     unsigned char *kmer = (unsigned char*) seq.nextKmer();
                     if(seq.kmerContainsX()){
@@ -239,10 +284,9 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * kmerArray, siz
 
                 // add k-mer to represent the identity
                 if (static_cast<unsigned short>(seqHash) >= hashStartRange && static_cast<unsigned short>(seqHash) <= hashEndRange) {
-                    threadKmerBuffer[bufferPos].kmer = seqHash;
-                    threadKmerBuffer[bufferPos].id = seqId;
+                    threadKmerBuffer[bufferPos].setSequenceHash(seqHash);
+                    threadKmerBuffer[bufferPos].setSequence(seqId, seqRank, seq.L);
                     threadKmerBuffer[bufferPos].pos = 0;
-                    threadKmerBuffer[bufferPos].seqLen = seq.L;
                     if(hashDistribution != NULL){
                         __sync_fetch_and_add(&hashDistribution[static_cast<unsigned short>(seqHash)], 1);
                     }
@@ -251,7 +295,7 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * kmerArray, siz
                         size_t writeOffset = __sync_fetch_and_add(&offset, bufferPos);
                         if(writeOffset + bufferPos < kmerArraySize){
                             if(kmerArray!=NULL){
-                                memcpy(kmerArray + writeOffset, threadKmerBuffer, sizeof(KmerPosition<T>) * bufferPos);
+                                memcpy(kmerArray + writeOffset, threadKmerBuffer, sizeof(KmerPos) * bufferPos);
                             }
                         } else{
                             Debug(Debug::ERROR) << "Kmer array overflow. currKmerArrayOffset="<< writeOffset
@@ -306,10 +350,9 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * kmerArray, siz
 //                                tmpKmerIdx=BIT_CLEAR(tmpKmerIdx, 63);
 //                                std::cout << seqId << "\t" << (kmers + kmerIdx)->score << "\t" << tmpKmerIdx << std::endl;
 //                            }
-                            threadKmerBuffer[bufferPos].kmer = (kmers + kmerIdx)->kmer;
-                            threadKmerBuffer[bufferPos].id = seqId;
+                            threadKmerBuffer[bufferPos].setKmer((kmers + kmerIdx)->kmer);
+                            threadKmerBuffer[bufferPos].setSequence(seqId, seqRank, seq.L);
                             threadKmerBuffer[bufferPos].pos = (kmers + kmerIdx)->pos;
-                            threadKmerBuffer[bufferPos].seqLen = seq.L;
                             bufferPos++;
                             if(hashDistribution != NULL){
                                 __sync_fetch_and_add(&hashDistribution[(kmers + kmerIdx)->score], 1);
@@ -320,7 +363,7 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * kmerArray, siz
                                 if(writeOffset + bufferPos < kmerArraySize){
                                     if(kmerArray!=NULL) {
                                         memcpy(kmerArray + writeOffset, threadKmerBuffer,
-                                               sizeof(KmerPosition<T>) * bufferPos);
+                                               sizeof(KmerPos) * bufferPos);
                                     }
                                 } else{
                                     Debug(Debug::ERROR) << "Kmer array overflow. currKmerArrayOffset="<< writeOffset
@@ -351,7 +394,7 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * kmerArray, siz
         if(bufferPos > 0){
             size_t writeOffset = __sync_fetch_and_add(&offset, bufferPos);
             if(kmerArray != NULL){
-                memcpy(kmerArray+writeOffset, threadKmerBuffer, sizeof(KmerPosition<T>) * bufferPos);
+                memcpy(kmerArray+writeOffset, threadKmerBuffer, sizeof(KmerPos) * bufferPos);
             }
         }
         free(kmers);
@@ -371,22 +414,26 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * kmerArray, siz
     if (probMatrix != NULL) {
         delete probMatrix;
     }
+    if (sequenceMasks != NULL) {
+        delete sequenceMasks;
+    }
     return std::make_pair(offset, longestKmer);
 }
 
-template <typename T>
-KmerPosition<T> * doComputation(size_t totalKmers, size_t hashStartRange, size_t hashEndRange, std::string splitFile,
-                                DBReader<unsigned int> & seqDbr, Parameters & par, BaseMatrix  * subMat) {
-
-    KmerPosition<T> * hashSeqPair = initKmerPositionMemory<T>(totalKmers);
+template <typename T, unsigned int KmerBits>
+typename KmerPositionType<T, KmerBits>::type * doComputation(size_t totalKmers, size_t hashStartRange, size_t hashEndRange, std::string splitFile,
+                                                             DBReader<unsigned int> & seqDbr, Parameters & par, BaseMatrix  * subMat,
+                                                             const SequenceRanks *ranks) {
+    typedef typename KmerPositionType<T, KmerBits>::type KmerPos;
+    KmerPos * hashSeqPair = initKmerPositionMemory<T, KmerBits>(totalKmers);
     size_t elementsToSort;
     if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
-        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_NUCLEOTIDES, T>(hashSeqPair, totalKmers, seqDbr, par, subMat, true, hashStartRange, hashEndRange, NULL);
+        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_NUCLEOTIDES, T, KmerBits>(hashSeqPair, totalKmers, seqDbr, par, subMat, true, hashStartRange, hashEndRange, NULL, ranks);
         elementsToSort = ret.first;
         par.kmerSize = ret.second;
         Debug(Debug::INFO) << "\nAdjusted k-mer length " << par.kmerSize << "\n";
     }else{
-        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_AMINO_ACIDS, T>(hashSeqPair, totalKmers, seqDbr, par, subMat, true, hashStartRange, hashEndRange, NULL);
+        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_AMINO_ACIDS, T, KmerBits>(hashSeqPair, totalKmers, seqDbr, par, subMat, true, hashStartRange, hashEndRange, NULL, ranks);
         elementsToSort = ret.first;
     }
     if(hashEndRange == SIZE_T_MAX){
@@ -396,9 +443,9 @@ KmerPosition<T> * doComputation(size_t totalKmers, size_t hashStartRange, size_t
     Debug(Debug::INFO) << "Sort kmer ";
     Timer timer;
     if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) {
-        SORT_PARALLEL(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition<T>::compareRepSequenceAndIdAndPosReverse);
+        SORT_PARALLEL(hashSeqPair, hashSeqPair + elementsToSort, KmerPos::compareRepSequenceAndIdAndPosReverse);
     }else{
-        SORT_PARALLEL(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition<T>::compareRepSequenceAndIdAndPos);
+        SORT_PARALLEL(hashSeqPair, hashSeqPair + elementsToSort, KmerPos::compareRepSequenceAndIdAndPos);
     }
     Debug(Debug::INFO) << timer.lap() << "\n";
 
@@ -406,18 +453,18 @@ KmerPosition<T> * doComputation(size_t totalKmers, size_t hashStartRange, size_t
     // The longest sequence is the first since we sorted by kmer, seq.Len and id
     size_t writePos;
     if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
-        writePos = assignGroup<Parameters::DBTYPE_NUCLEOTIDES, T>(hashSeqPair, totalKmers, par.includeOnlyExtendable, par.covMode, par.covThr);
+        writePos = assignGroup<Parameters::DBTYPE_NUCLEOTIDES, T, KmerBits>(hashSeqPair, totalKmers, par.includeOnlyExtendable, par.covMode, par.covThr, ranks);
     }else{
-        writePos = assignGroup<Parameters::DBTYPE_AMINO_ACIDS, T>(hashSeqPair, totalKmers, par.includeOnlyExtendable, par.covMode, par.covThr);
+        writePos = assignGroup<Parameters::DBTYPE_AMINO_ACIDS, T, KmerBits>(hashSeqPair, totalKmers, par.includeOnlyExtendable, par.covMode, par.covThr, ranks);
     }
 
     // sort by rep. sequence (stored in kmer) and sequence id
     Debug(Debug::INFO) << "Sort by rep. sequence ";
     timer.reset();
     if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
-        SORT_PARALLEL(hashSeqPair, hashSeqPair + writePos, KmerPosition<T>::compareRepSequenceAndIdAndDiagReverse);
+        SORT_PARALLEL(hashSeqPair, hashSeqPair + writePos, KmerPos::compareRepSequenceAndIdAndDiagReverse);
     }else{
-        SORT_PARALLEL(hashSeqPair, hashSeqPair + writePos, KmerPosition<T>::compareRepSequenceAndIdAndDiag);
+        SORT_PARALLEL(hashSeqPair, hashSeqPair + writePos, KmerPos::compareRepSequenceAndIdAndDiag);
     }
     //kx::radix_sort(hashSeqPair, hashSeqPair + elementsToSort, SequenceComparision());
 //    for(size_t i = 0; i < writePos; i++){
@@ -427,9 +474,9 @@ KmerPosition<T> * doComputation(size_t totalKmers, size_t hashStartRange, size_t
 
     if(hashEndRange != SIZE_T_MAX){
         if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
-            writeKmersToDisk<Parameters::DBTYPE_NUCLEOTIDES, KmerEntryRev, T>(splitFile, hashSeqPair, writePos + 1);
+            writeKmersToDisk<Parameters::DBTYPE_NUCLEOTIDES, KmerEntryRev, T, KmerBits>(splitFile, hashSeqPair, writePos + 1);
         }else{
-            writeKmersToDisk<Parameters::DBTYPE_AMINO_ACIDS, KmerEntry, T>(splitFile, hashSeqPair, writePos + 1);
+            writeKmersToDisk<Parameters::DBTYPE_AMINO_ACIDS, KmerEntry, T, KmerBits>(splitFile, hashSeqPair, writePos + 1);
         }
         delete [] hashSeqPair;
         hashSeqPair = NULL;
@@ -437,35 +484,41 @@ KmerPosition<T> * doComputation(size_t totalKmers, size_t hashStartRange, size_t
     return hashSeqPair;
 }
 
-template <int TYPE, typename T>
-size_t assignGroup(KmerPosition<T> *hashSeqPair, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr) {
+template <int TYPE, typename T, unsigned int KmerBits>
+size_t assignGroup(typename KmerPositionType<T, KmerBits>::type *hashSeqPair, size_t splitKmerCount, bool includeOnlyExtendable,
+                   int covMode, float covThr, const SequenceRanks *ranks) {
     size_t writePos=0;
-    size_t prevHash = hashSeqPair[0].kmer;
-    size_t repSeqId = hashSeqPair[0].id;
+    size_t prevHash = hashSeqPair[0].getKmer();
+    // compact entries store the rank of the sequence until they are rewritten below
+    const bool isEmpty = (prevHash == SIZE_T_MAX);
+    size_t repSeqId = isEmpty ? UINT_MAX : hashSeqPair[0].getKey(ranks);
     if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-        bool isReverse = (BIT_CHECK(hashSeqPair[0].kmer, 63) == false);
+        bool isReverse = (BIT_CHECK(prevHash, 63) == false);
         repSeqId = (isReverse) ? BIT_CLEAR(repSeqId, 63) : BIT_SET(repSeqId, 63);
         prevHash = BIT_SET(prevHash, 63);
     }
     size_t prevHashStart = 0;
     size_t prevSetSize = 0;
-    T queryLen=hashSeqPair[0].seqLen;
+    T queryLen = isEmpty ? 0 : hashSeqPair[0].getSeqLen(ranks);
     bool repIsReverse = false;
     T repSeq_i_pos = hashSeqPair[0].pos;
     for (size_t elementIdx = 0; elementIdx < splitKmerCount+1; elementIdx++) {
-        size_t currKmer = hashSeqPair[elementIdx].kmer;
+        const size_t elementKmer = hashSeqPair[elementIdx].getKmer();
+        size_t currKmer = elementKmer;
         if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
             currKmer = BIT_SET(currKmer, 63);
         }
         if (prevHash != currKmer) {
             for (size_t i = prevHashStart; i < elementIdx; i++) {
-                size_t kmer = hashSeqPair[i].kmer;
+                const size_t targetKmer = hashSeqPair[i].getKmer();
+                size_t kmer = targetKmer;
                 if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
-                    kmer = BIT_SET(hashSeqPair[i].kmer, 63);
+                    kmer = BIT_SET(targetKmer, 63);
                 }
                 size_t rId = (kmer != SIZE_T_MAX) ? ((prevSetSize == 1) ? SIZE_T_MAX : repSeqId) : SIZE_T_MAX;
                 // remove singletones from set
                 if(rId != SIZE_T_MAX){
+                    const T targetLen = hashSeqPair[i].getSeqLen(ranks);
                     int diagonal = repSeq_i_pos - hashSeqPair[i].pos;
                     if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
                         //  00 No problem here both are forward
@@ -473,7 +526,7 @@ size_t assignGroup(KmerPosition<T> *hashSeqPair, size_t splitKmerCount, bool inc
                         //  10 Same here, we can revert query to match the not inverted target
                         //  11 Both are reverted so no problem!
                         //  So we need just 1 bit of information to encode all four states
-                        bool targetIsReverse = (BIT_CHECK(hashSeqPair[i].kmer, 63) == false);
+                        bool targetIsReverse = (BIT_CHECK(targetKmer, 63) == false);
                         bool queryNeedsToBeRev = false;
                         // we now need 2 byte of information (00),(01),(10),(11)
                         // we need to flip the coordinates of the query
@@ -490,13 +543,13 @@ size_t assignGroup(KmerPosition<T> *hashSeqPair, size_t splitKmerCount, bool inc
                             // we just need to offset the position to the forward strand
                         }else if (repIsReverse == true && targetIsReverse == true){
                             queryPos = (queryLen - 1) - repSeq_i_pos;
-                            targetPos = (hashSeqPair[i].seqLen - 1) - hashSeqPair[i].pos;
+                            targetPos = (targetLen - 1) - hashSeqPair[i].pos;
                             queryNeedsToBeRev = false;
                             // query is not revers but target k-mer is reverse
                             // instead of reverting the target, we revert the query and offset the the query/target position
                         }else if (repIsReverse == false && targetIsReverse == true){
                             queryPos = (queryLen - 1) - repSeq_i_pos;
-                            targetPos = (hashSeqPair[i].seqLen - 1) - hashSeqPair[i].pos;
+                            targetPos = (targetLen - 1) - hashSeqPair[i].pos;
                             queryNeedsToBeRev = true;
                             // both are forward, everything is good here
                         }else{
@@ -510,36 +563,40 @@ size_t assignGroup(KmerPosition<T> *hashSeqPair, size_t splitKmerCount, bool inc
 //                    std::cout << diagonal << "\t" << repSeq_i_pos << "\t" << hashSeqPair[i].pos << std::endl;
 
 
-                    bool canBeExtended = diagonal < 0 || (diagonal > (queryLen - hashSeqPair[i].seqLen));
+                    bool canBeExtended = diagonal < 0 || (diagonal > (queryLen - targetLen));
                     bool canBecovered = Util::canBeCovered(covThr, covMode,
                                                            static_cast<float>(queryLen),
-                                                           static_cast<float>(hashSeqPair[i].seqLen));
+                                                           static_cast<float>(targetLen));
                     if((includeOnlyExtendable == false && canBecovered) || (canBeExtended && includeOnlyExtendable ==true )){
-                        hashSeqPair[writePos].kmer = rId;
+                        const unsigned int targetKey = hashSeqPair[i].getKey(ranks);
+                        hashSeqPair[writePos].setKmer(rId);
                         hashSeqPair[writePos].pos = diagonal;
-                        hashSeqPair[writePos].seqLen = hashSeqPair[i].seqLen;
-                        hashSeqPair[writePos].id = hashSeqPair[i].id;
+                        hashSeqPair[writePos].id = targetKey;
                         writePos++;
                     }
                 }
-//                hashSeqPair[i].kmer = SIZE_T_MAX;
-                hashSeqPair[i].kmer = (i != writePos - 1) ? SIZE_T_MAX : hashSeqPair[i].kmer;
+                if (i != writePos - 1) {
+                    hashSeqPair[i].setKmer(SIZE_T_MAX);
+                }
+            }
+            if (elementKmer == SIZE_T_MAX) {
+                break;
             }
             prevSetSize = 0;
             prevHashStart = elementIdx;
-            repSeqId = hashSeqPair[elementIdx].id;
+            repSeqId = hashSeqPair[elementIdx].getKey(ranks);
             if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-                repIsReverse = (BIT_CHECK(hashSeqPair[elementIdx].kmer, 63) == 0);
+                repIsReverse = (BIT_CHECK(elementKmer, 63) == 0);
                 repSeqId = (repIsReverse) ? repSeqId : BIT_SET(repSeqId, 63);
             }
-            queryLen = hashSeqPair[elementIdx].seqLen;
+            queryLen = hashSeqPair[elementIdx].getSeqLen(ranks);
             repSeq_i_pos = hashSeqPair[elementIdx].pos;
         }
-        if (hashSeqPair[elementIdx].kmer == SIZE_T_MAX) {
+        if (elementKmer == SIZE_T_MAX) {
             break;
         }
         prevSetSize++;
-        prevHash = hashSeqPair[elementIdx].kmer;
+        prevHash = elementKmer;
         if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
             prevHash = BIT_SET(prevHash, 63);
         }
@@ -548,10 +605,10 @@ size_t assignGroup(KmerPosition<T> *hashSeqPair, size_t splitKmerCount, bool inc
     return writePos;
 }
 
-template size_t assignGroup<0, short>(KmerPosition<short> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr);
-template size_t assignGroup<0, int>(KmerPosition<int> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr);
-template size_t assignGroup<1, short>(KmerPosition<short> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr);
-template size_t assignGroup<1, int>(KmerPosition<int> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr);
+template size_t assignGroup<0, short>(KmerPosition<short> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr, const SequenceRanks *ranks);
+template size_t assignGroup<0, int>(KmerPosition<int> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr, const SequenceRanks *ranks);
+template size_t assignGroup<1, short>(KmerPosition<short> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr, const SequenceRanks *ranks);
+template size_t assignGroup<1, int>(KmerPosition<int> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr, const SequenceRanks *ranks);
 
 void setLinearFilterDefault(Parameters *p) {
     p->covThr = 0.8;
@@ -574,14 +631,15 @@ size_t computeKmerCount(DBReader<unsigned int> &reader, size_t KMER_SIZE, size_t
     return totalKmers;
 }
 
-template <typename T>
+template <typename T, unsigned int KmerBits>
 size_t computeMemoryNeededLinearfilter(size_t totalKmer) {
-    return sizeof(KmerPosition<T>) * totalKmer;
+    return sizeof(typename KmerPositionType<T, KmerBits>::type) * totalKmer;
 }
 
 
-template <typename T>
+template <typename T, unsigned int KmerBits>
 int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
+    typedef typename KmerPositionType<T, KmerBits>::type KmerPos;
 
     int querySeqType = seqDbr.getDbtype();
     BaseMatrix *subMat;
@@ -601,22 +659,29 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
     // memoryLimit in bytes
     size_t memoryLimit=Util::computeMemory(par.splitMemoryLimit);
 
+    SequenceRanks *ranks = NULL;
+    if (KmerBits < 64) {
+        ranks = new SequenceRanks(seqDbr);
+        memoryLimit -= std::min(memoryLimit / 2, ranks->getMemorySize());
+    }
+    Debug(Debug::INFO) << "K-mer entry size: " << sizeof(KmerPos) << " bytes\n";
+
     Debug(Debug::INFO) << "\n";
     float kmersPerSequenceScale = (Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_NUCLEOTIDES)) ?
                                         par.kmersPerSequenceScale.nucleotides : par.kmersPerSequenceScale.aminoacids;
     size_t totalKmers = computeKmerCount(seqDbr, par.kmerSize, par.kmersPerSequence, kmersPerSequenceScale);
-    size_t totalSizeNeeded = computeMemoryNeededLinearfilter<T>(totalKmers);
+    size_t totalSizeNeeded = computeMemoryNeededLinearfilter<T, KmerBits>(totalKmers);
     // compute splits
     size_t splits = static_cast<size_t>(std::ceil(static_cast<float>(totalSizeNeeded) / memoryLimit));
     size_t totalKmersPerSplit = std::max(static_cast<size_t>(1024+1),
-                                         static_cast<size_t>(std::min(totalSizeNeeded, memoryLimit)/sizeof(KmerPosition<T>))+1);
+                                         static_cast<size_t>(std::min(totalSizeNeeded, memoryLimit)/sizeof(KmerPos))+1);
 
-    std::vector<std::pair<size_t, size_t>> hashRanges = setupKmerSplits<T>(par, subMat, seqDbr, totalKmersPerSplit, splits);
+    std::vector<std::pair<size_t, size_t>> hashRanges = setupKmerSplits<T, KmerBits>(par, subMat, seqDbr, totalKmersPerSplit, splits);
     if(splits > 1){
         Debug(Debug::INFO) << "Process file into " << hashRanges.size() << " parts\n";
     }
     std::vector<std::string> splitFiles;
-    KmerPosition<T> *hashSeqPair = NULL;
+    KmerPos *hashSeqPair = NULL;
 
     size_t mpiRank = 0;
 #ifdef HAVE_MPI
@@ -639,7 +704,7 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
 
     for(size_t split = fromSplit; split < fromSplit+splitCount; split++) {
         std::string splitFileName = par.db2 + "_split_" +SSTR(split);
-        hashSeqPair = doComputation<T>(totalKmers, hashRanges[split].first, hashRanges[split].second, splitFileName, seqDbr, par, subMat);
+        hashSeqPair = doComputation<T, KmerBits>(totalKmers, hashRanges[split].first, hashRanges[split].second, splitFileName, seqDbr, par, subMat, ranks);
     }
     MPI_Barrier(MPI_COMM_WORLD);
     if(mpiRank == 0){
@@ -655,7 +720,7 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
 
         std::string splitFileNameDone = splitFileName + ".done";
         if(FileUtil::fileExists(splitFileNameDone.c_str()) == false){
-            hashSeqPair = doComputation<T>(totalKmersPerSplit, hashRanges[split].first, hashRanges[split].second, splitFileName, seqDbr, par, subMat);
+            hashSeqPair = doComputation<T, KmerBits>(totalKmersPerSplit, hashRanges[split].first, hashRanges[split].second, splitFileName, seqDbr, par, subMat, ranks);
         }
 
         splitFiles.push_back(splitFileName);
@@ -665,7 +730,7 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
         std::vector<char> repSequence(seqDbr.getLastKey()+1);
         std::fill(repSequence.begin(), repSequence.end(), false);
         // write result
-        DBWriter dbw(par.db2.c_str(), par.db2Index.c_str(), 1, par.compressed,
+        DBWriter dbw(par.db2.c_str(), par.db2Index.c_str(), static_cast<unsigned int>(par.threads), par.compressed,
                      (Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) ? Parameters::DBTYPE_PREFILTER_REV_RES : Parameters::DBTYPE_PREFILTER_RES );
         dbw.open();
 
@@ -684,15 +749,15 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
             }
         } else {
             if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) {
-                writeKmerMatcherResult<Parameters::DBTYPE_NUCLEOTIDES>(dbw, hashSeqPair, totalKmersPerSplit, repSequence, 1);
+                writeKmerMatcherResult<Parameters::DBTYPE_NUCLEOTIDES, T, KmerBits>(dbw, hashSeqPair, totalKmersPerSplit, repSequence, 1);
             }else{
-                writeKmerMatcherResult<Parameters::DBTYPE_AMINO_ACIDS>(dbw, hashSeqPair, totalKmersPerSplit, repSequence, 1);
+                writeKmerMatcherResult<Parameters::DBTYPE_AMINO_ACIDS, T, KmerBits>(dbw, hashSeqPair, totalKmersPerSplit, repSequence, 1);
             }
         }
         Debug(Debug::INFO) << "Time for fill: " << timer.lap() << "\n";
         // add missing entries to the result (needed for clustering)
 
-#pragma omp parallel num_threads(1)
+#pragma omp parallel
         {
             unsigned int thread_idx = 0;
 #ifdef OPENMP
@@ -719,11 +784,14 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
     if(hashSeqPair){
         delete [] hashSeqPair;
     }
+    if (ranks != NULL) {
+        delete ranks;
+    }
 
     return EXIT_SUCCESS;
 }
 
-template <typename T>
+template <typename T, unsigned int KmerBits>
 std::vector<std::pair<size_t, size_t>> setupKmerSplits(Parameters &par, BaseMatrix * subMat, DBReader<unsigned int> &seqDbr, size_t totalKmers, size_t splits){
     std::vector<std::pair<size_t, size_t>> hashRanges;
     if (splits > 1) {
@@ -732,9 +800,9 @@ std::vector<std::pair<size_t, size_t>> setupKmerSplits(Parameters &par, BaseMatr
         size_t * hashDist = new size_t[USHRT_MAX+1];
         memset(hashDist, 0 , sizeof(size_t) * (USHRT_MAX+1));
         if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
-            fillKmerPositionArray<Parameters::DBTYPE_NUCLEOTIDES, T>(NULL, SIZE_T_MAX, seqDbr, par, subMat, true, 0, SIZE_T_MAX, hashDist);
+            fillKmerPositionArray<Parameters::DBTYPE_NUCLEOTIDES, T, KmerBits>(NULL, SIZE_T_MAX, seqDbr, par, subMat, true, 0, SIZE_T_MAX, hashDist);
         }else{
-            fillKmerPositionArray<Parameters::DBTYPE_AMINO_ACIDS, T>(NULL, SIZE_T_MAX, seqDbr, par, subMat, true, 0, SIZE_T_MAX, hashDist);
+            fillKmerPositionArray<Parameters::DBTYPE_AMINO_ACIDS, T, KmerBits>(NULL, SIZE_T_MAX, seqDbr, par, subMat, true, 0, SIZE_T_MAX, hashDist);
         }
         seqDbr.remapData();
         // figure out if machine has enough memory to run this job
@@ -745,7 +813,7 @@ std::vector<std::pair<size_t, size_t>> setupKmerSplits(Parameters &par, BaseMatr
             }
         }
         if(maxBucketSize > totalKmers){
-            Debug(Debug::INFO) << "Not enough memory to run the kmermatcher. Minimum is at least " << maxBucketSize* sizeof(KmerPosition<T>) << " bytes\n";
+            Debug(Debug::INFO) << "Not enough memory to run the kmermatcher. Minimum is at least " << maxBucketSize* sizeof(typename KmerPositionType<T, KmerBits>::type) << " bytes\n";
             EXIT(EXIT_FAILURE);
         }
         // define splits
@@ -784,11 +852,25 @@ int kmermatcher(int argc, const char **argv, const Command &command) {
     par.printParameters(command.cmd, argc, argv, *params);
     Debug(Debug::INFO) << "Database size: " << seqDbr.getSize() << " type: " << seqDbr.getDbTypeName() << "\n";
 
+    // k-mers that fit into 48 or 56 bits are stored in compact entries
+    const unsigned int kmerBits = computeKmerBits(par, querySeqType);
     if (seqDbr.getMaxSeqLen() < SHRT_MAX) {
-        kmermatcherInner<short>(par, seqDbr);
+        if (kmerBits == 48) {
+            kmermatcherInner<short, 48>(par, seqDbr);
+        } else if (kmerBits == 56) {
+            kmermatcherInner<short, 56>(par, seqDbr);
+        } else {
+            kmermatcherInner<short, 64>(par, seqDbr);
+        }
     }
     else {
-        kmermatcherInner<int>(par, seqDbr);
+        if (kmerBits == 48) {
+            kmermatcherInner<int, 48>(par, seqDbr);
+        } else if (kmerBits == 56) {
+            kmermatcherInner<int, 56>(par, seqDbr);
+        } else {
+            kmermatcherInner<int, 64>(par, seqDbr);
+        }
     }
 
     seqDbr.close();
@@ -796,20 +878,20 @@ int kmermatcher(int argc, const char **argv, const Command &command) {
     return EXIT_SUCCESS;
 }
 
-template <int TYPE, typename T>
+template <int TYPE, typename T, unsigned int KmerBits>
 void writeKmerMatcherResult(DBWriter & dbw,
-                            KmerPosition<T> *hashSeqPair, size_t totalKmers,
+                            typename KmerPositionType<T, KmerBits>::type *hashSeqPair, size_t totalKmers,
                             std::vector<char> &repSequence, size_t threads) {
     std::vector<size_t> threadOffsets;
     size_t splitSize = totalKmers/threads;
     threadOffsets.push_back(0);
     for(size_t thread = 1; thread < threads; thread++){
-        size_t kmer = hashSeqPair[thread*splitSize].kmer;
+        size_t kmer = hashSeqPair[thread*splitSize].getKmer();
         size_t repSeqId = static_cast<size_t>(kmer);
         repSeqId=BIT_SET(repSeqId, 63);
         bool wasSet = false;
         for(size_t pos = thread*splitSize; pos < totalKmers; pos++){
-            size_t currSeqId = hashSeqPair[pos].kmer;
+            size_t currSeqId = hashSeqPair[pos].getKmer();
             currSeqId=BIT_SET(currSeqId, 63);
             if(repSeqId != currSeqId){
                 wasSet = true;
@@ -831,8 +913,8 @@ void writeKmerMatcherResult(DBWriter & dbw,
         unsigned int writeSets = 0;
         size_t kmerPos=0;
         size_t repSeqId = SIZE_T_MAX;
-        for(kmerPos = threadOffsets[thread]; kmerPos < threadOffsets[thread+1] && hashSeqPair[kmerPos].kmer != SIZE_T_MAX; kmerPos++){
-            size_t currKmer = hashSeqPair[kmerPos].kmer;
+        for(kmerPos = threadOffsets[thread]; kmerPos < threadOffsets[thread+1] && hashSeqPair[kmerPos].getKmer() != SIZE_T_MAX; kmerPos++){
+            size_t currKmer = hashSeqPair[kmerPos].getKmer();
             int reverMask = 0;
             if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
                 reverMask  = BIT_CHECK(currKmer, 63)==false;
@@ -879,7 +961,7 @@ void writeKmerMatcherResult(DBWriter & dbw,
                     diagonal = hashSeqPair[kmerPos+kmerOffset].pos;
                     maxDiagonal = diagonalCnt;
                     if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-                        bestReverMask = BIT_CHECK(hashSeqPair[kmerPos+kmerOffset].kmer, 63) == false;
+                        bestReverMask = BIT_CHECK(hashSeqPair[kmerPos+kmerOffset].getKmer(), 63) == false;
                     }
                 }
                 prevDiagonal = hashSeqPair[kmerPos+kmerOffset].pos;
@@ -933,6 +1015,37 @@ size_t queueNextEntry(KmerPositionQueue &queue, int file, size_t offsetPos, T *e
     return offsetPos+pos;
 }
 
+// The split files hold the groups of the rep. sequences in increasing order, each group ends with an UINT_MAX entry.
+// Returns the start of the first group that begins at or after pos.
+template <typename T>
+static size_t nextGroupStart(const T *entries, size_t entrySize, size_t pos) {
+    if (pos == 0) {
+        return 0;
+    }
+    size_t i = pos - 1;
+    while (i < entrySize && entries[i].seqId != UINT_MAX) {
+        i++;
+    }
+    return std::min(i + 1, entrySize);
+}
+
+// returns the start of the first group with a rep. sequence of at least repSeqId
+template <typename T>
+static size_t findGroupStart(const T *entries, size_t entrySize, unsigned int repSeqId) {
+    size_t low = 0;
+    size_t high = entrySize;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        const size_t group = nextGroupStart(entries, entrySize, mid);
+        if (group < entrySize && entries[group].seqId < repSeqId) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return nextGroupStart(entries, entrySize, low);
+}
+
 template <int TYPE, typename T>
 void mergeKmerFilesAndOutput(DBWriter & dbw,
                              std::vector<std::string> tmpFiles,
@@ -943,7 +1056,6 @@ void mergeKmerFilesAndOutput(DBWriter & dbw,
     FILE ** files       = new FILE*[fileCnt];
     T **entries = new T*[fileCnt];
     size_t * entrySizes = new size_t[fileCnt];
-    size_t * offsetPos  = new size_t[fileCnt];
     size_t * dataSizes  = new size_t[fileCnt];
     // init structures
     for(size_t file = 0; file < tmpFiles.size(); file++){
@@ -959,66 +1071,70 @@ void mergeKmerFilesAndOutput(DBWriter & dbw,
             }
 #endif
         }else{
+            entries[file] = NULL;
             dataSize = 0;
         }
 
         dataSizes[file]  = dataSize;
         entrySizes[file] = dataSize/sizeof(T);
     }
-    KmerPositionQueue queue;
-    // read one entry for each file
-    for(int file = 0; file < fileCnt; file++ ){
-        offsetPos[file] = queueNextEntry<TYPE,T>(queue, file, 0, entries[file], entrySizes[file]);
+
+    // partition the rep. sequences into ranges of about the same size in the largest split file,
+    // each range is merged independently and written by its own writer thread
+    int largestFile = 0;
+    for (int file = 1; file < fileCnt; file++) {
+        if (entrySizes[file] > entrySizes[largestFile]) {
+            largestFile = file;
+        }
     }
-    std::string prefResultsOutString;
-    prefResultsOutString.reserve(100000000);
-    char buffer[100];
-    FileKmerPosition res;
-    bool hasRepSeq =  repSequence.size()>0;
-    unsigned int currRepSeq = UINT_MAX;
-    if(queue.empty() == false){
-        res = queue.top();
-        currRepSeq = res.repSeq;
-        if(hasRepSeq) {
-            hit_t h;
-            h.seqId = res.repSeq;
-            h.prefScore = 0;
-            h.diagonal = 0;
-            int len = QueryMatcher::prefilterHitToBuffer(buffer, h);
-            prefResultsOutString.append(buffer, len);
+    const size_t partitionCnt = (dbw.getThreads() > 1) ? static_cast<size_t>(dbw.getThreads()) * 4 : 1;
+    std::vector<unsigned int> bounds(1, 0);
+    for (size_t part = 1; part < partitionCnt; part++) {
+        const size_t group = nextGroupStart(entries[largestFile], entrySizes[largestFile], (entrySizes[largestFile] / partitionCnt) * part);
+        if (group < entrySizes[largestFile] && entries[largestFile][group].seqId > bounds.back()) {
+            bounds.push_back(entries[largestFile][group].seqId);
+        }
+    }
+    // first group start of every range in every file, the end is the start of the next range
+    const size_t rangeCnt = bounds.size();
+    std::vector<size_t> rangeStarts((rangeCnt + 1) * fileCnt);
+    for (int file = 0; file < fileCnt; file++) {
+        for (size_t range = 0; range < rangeCnt; range++) {
+            rangeStarts[range * fileCnt + file] = findGroupStart(entries[file], entrySizes[file], bounds[range]);
         }
+        rangeStarts[rangeCnt * fileCnt + file] = entrySizes[file];
     }
 
-//    while(queue.empty() == false) {
-//        res = queue.top();
-//        std::cout << (int)res.repSeq << "\t" << (int)res.id << "\t" <<(int) res.pos << "\t" << (int) res.reverse << std::endl;
-//        queue.pop();
-//        offsetPos[res.file] = queueNextEntry<TYPE,T>(queue, res.file, offsetPos[res.file],
-//                                                     entries[res.file], entrySizes[res.file]);
-//    }
-    while(queue.empty() == false) {
-        res = queue.top();
-        queue.pop();
-        if(res.id == UINT_MAX) {
-            offsetPos[res.file] = queueNextEntry<TYPE,T>(queue, res.file, offsetPos[res.file],
-                                                         entries[res.file], entrySizes[res.file]);
-            dbw.writeData(prefResultsOutString.c_str(), prefResultsOutString.length(), res.repSeq, 0);
-            if(hasRepSeq){
-                repSequence[res.repSeq]=true;
-            }
-            prefResultsOutString.clear();
-            // skipe UINT MAX entries
-            while(queue.empty() == false && queue.top().id==UINT_MAX) {
-                res = queue.top();
-                queue.pop();
-                offsetPos[res.file] = queueNextEntry<TYPE,T>(queue, res.file, offsetPos[res.file],
-                                                             entries[res.file], entrySizes[res.file]);
+#pragma omp parallel num_threads(dbw.getThreads())
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        std::vector<T *> partEntries(fileCnt);
+        std::vector<size_t> partSizes(fileCnt);
+        std::vector<size_t> partOffsets(fileCnt);
+
+#pragma omp for schedule(dynamic, 1)
+        for (size_t range = 0; range < rangeCnt; range++) {
+            KmerPositionQueue queue;
+            // read one entry for each file
+            for (int file = 0; file < fileCnt; file++) {
+                const size_t rangeStart = rangeStarts[range * fileCnt + file];
+                partEntries[file] = (entrySizes[file] > 0) ? entries[file] + rangeStart : NULL;
+                partSizes[file] = rangeStarts[(range + 1) * fileCnt + file] - rangeStart;
+                partOffsets[file] = queueNextEntry<TYPE,T>(queue, file, 0, partEntries[file], partSizes[file]);
             }
-            if(queue.empty() == false) {
+            std::string prefResultsOutString;
+            prefResultsOutString.reserve(1024 * 1024);
+            char buffer[100];
+            FileKmerPosition res;
+            bool hasRepSeq =  repSequence.size()>0;
+            unsigned int currRepSeq = UINT_MAX;
+            if(queue.empty() == false){
                 res = queue.top();
                 currRepSeq = res.repSeq;
-                queue.pop();
-                if(hasRepSeq){
+                if(hasRepSeq) {
                     hit_t h;
                     h.seqId = res.repSeq;
                     h.prefScore = 0;
@@ -1027,52 +1143,86 @@ void mergeKmerFilesAndOutput(DBWriter & dbw,
                     prefResultsOutString.append(buffer, len);
                 }
             }
-        }
 
-        bool hitIsRepSeq = (currRepSeq == res.id);
-        // skip rep. seq. if set does not have rep. sequences
-        if(hitIsRepSeq){
-            continue;
-        }
-        // if its not a duplicate
-        // find maximal diagonal and top score
-        int bestDiagonalCnt = 0;
-        int bestRevertMask = 0;
-        short bestDiagonal = res.pos;
-        int topScore = 0;
-        unsigned int hitId;
-        unsigned int prevHitId;
-        int diagonalScore = 0;
-        short prevDiagonal = res.pos;
-        do {
-            prevHitId = res.id;
-            diagonalScore = (diagonalScore == 0 || prevDiagonal!=res.pos) ? res.score : diagonalScore + res.score;
-            if(diagonalScore >= bestDiagonalCnt){
-                bestDiagonalCnt = diagonalScore;
-                bestDiagonal = res.pos;
-                bestRevertMask = res.reverse;
-            }
-            prevDiagonal = res.pos;
-            topScore += res.score;
-            if(queue.empty() == false) {
+            while(queue.empty() == false) {
                 res = queue.top();
                 queue.pop();
-                hitId = res.id;
-                if(hitId != prevHitId){
-                    queue.push(res);
+                if(res.id == UINT_MAX) {
+                    partOffsets[res.file] = queueNextEntry<TYPE,T>(queue, res.file, partOffsets[res.file],
+                                                                 partEntries[res.file], partSizes[res.file]);
+                    dbw.writeData(prefResultsOutString.c_str(), prefResultsOutString.length(), res.repSeq, thread_idx);
+                    if(hasRepSeq){
+                        repSequence[res.repSeq]=true;
+                    }
+                    prefResultsOutString.clear();
+                    // skipe UINT MAX entries
+                    while(queue.empty() == false && queue.top().id==UINT_MAX) {
+                        res = queue.top();
+                        queue.pop();
+                        partOffsets[res.file] = queueNextEntry<TYPE,T>(queue, res.file, partOffsets[res.file],
+                                                                     partEntries[res.file], partSizes[res.file]);
+                    }
+                    if(queue.empty() == false) {
+                        res = queue.top();
+                        currRepSeq = res.repSeq;
+                        queue.pop();
+                        if(hasRepSeq){
+                            hit_t h;
+                            h.seqId = res.repSeq;
+                            h.prefScore = 0;
+                            h.diagonal = 0;
+                            int len = QueryMatcher::prefilterHitToBuffer(buffer, h);
+                            prefResultsOutString.append(buffer, len);
+                        }
+                    }
                 }
-            }else{
-                hitId = UINT_MAX;
-            }
 
-        } while(hitId == prevHitId && res.repSeq == currRepSeq && hitId != UINT_MAX);
+                bool hitIsRepSeq = (currRepSeq == res.id);
+                // skip rep. seq. if set does not have rep. sequences
+                if(hitIsRepSeq){
+                    continue;
+                }
+                // if its not a duplicate
+                // find maximal diagonal and top score
+                int bestDiagonalCnt = 0;
+                int bestRevertMask = 0;
+                short bestDiagonal = res.pos;
+                int topScore = 0;
+                unsigned int hitId;
+                unsigned int prevHitId;
+                int diagonalScore = 0;
+                short prevDiagonal = res.pos;
+                do {
+                    prevHitId = res.id;
+                    diagonalScore = (diagonalScore == 0 || prevDiagonal!=res.pos) ? res.score : diagonalScore + res.score;
+                    if(diagonalScore >= bestDiagonalCnt){
+                        bestDiagonalCnt = diagonalScore;
+                        bestDiagonal = res.pos;
+                        bestRevertMask = res.reverse;
+                    }
+                    prevDiagonal = res.pos;
+                    topScore += res.score;
+                    if(queue.empty() == false) {
+                        res = queue.top();
+                        queue.pop();
+                        hitId = res.id;
+                        if(hitId != prevHitId){
+                            queue.push(res);
+                        }
+                    }else{
+                        hitId = UINT_MAX;
+                    }
+
+                } while(hitId == prevHitId && res.repSeq == currRepSeq && hitId != UINT_MAX);
 
-        hit_t h;
-        h.seqId = prevHitId;
-        h.prefScore =  (bestRevertMask) ? -topScore : topScore;
-        h.diagonal =  bestDiagonal;
-        int len = QueryMatcher::prefilterHitToBuffer(buffer, h);
-        prefResultsOutString.append(buffer, len);
+                hit_t h;
+                h.seqId = prevHitId;
+                h.prefScore =  (bestRevertMask) ? -topScore : topScore;
+                h.diagonal =  bestDiagonal;
+                int len = QueryMatcher::prefilterHitToBuffer(buffer, h);
+                prefResultsOutString.append(buffer, len);
+            }
+        }
     }
     for(size_t file = 0; file < tmpFiles.size(); file++) {
         if (fclose(files[file]) != 0) {
@@ -1087,15 +1237,14 @@ void mergeKmerFilesAndOutput(DBWriter & dbw,
 
 
     delete [] dataSizes;
-    delete [] offsetPos;
     delete [] entries;
     delete [] entrySizes;
     delete [] files;
 }
 
 
-template <int TYPE, typename T, typename seqLenType>
-void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *hashSeqPair, size_t totalKmers) {
+template <int TYPE, typename T, typename seqLenType, unsigned int KmerBits>
+void writeKmersToDisk(std::string tmpFile, typename KmerPositionType<seqLenType, KmerBits>::type *hashSeqPair, size_t totalKmers) {
     size_t repSeqId = SIZE_T_MAX;
     size_t lastTargetId = SIZE_T_MAX;
     seqLenType lastDiagonal=0;
@@ -1110,8 +1259,8 @@ void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *hashSeqPair
     T nullEntry;
     nullEntry.seqId=UINT_MAX;
     nullEntry.diagonal=0;
-    for(size_t kmerPos = 0; kmerPos < totalKmers && hashSeqPair[kmerPos].kmer != SIZE_T_MAX; kmerPos++){
-        size_t currKmer=hashSeqPair[kmerPos].kmer;
+    for(size_t kmerPos = 0; kmerPos < totalKmers && hashSeqPair[kmerPos].getKmer() != SIZE_T_MAX; kmerPos++){
+        size_t currKmer=hashSeqPair[kmerPos].getKmer();
         if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
             currKmer = BIT_CLEAR(currKmer, 63);
         }
@@ -1130,7 +1279,7 @@ void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *hashSeqPair
             writeBuffer[bufferPos].score = 0;
             writeBuffer[bufferPos].diagonal = 0;
             if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-                bool isReverse = BIT_CHECK(hashSeqPair[kmerPos].kmer, 63)==false;
+                bool isReverse = BIT_CHECK(hashSeqPair[kmerPos].getKmer(), 63)==false;
                 writeBuffer[bufferPos].setReverse(isReverse);
             }
             bufferPos++;
@@ -1146,12 +1295,12 @@ void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *hashSeqPair
             lastTargetId = hashSeqPair[kmerPos].id;
             lastDiagonal = hashSeqPair[kmerPos].pos;
             if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-                bool isReverse  = BIT_CHECK(hashSeqPair[kmerPos].kmer, 63)==false;
+                bool isReverse  = BIT_CHECK(hashSeqPair[kmerPos].getKmer(), 63)==false;
                 forward += isReverse == false;
                 reverse += isReverse == true;
             }
             kmerPos++;
-        }while(targetId == hashSeqPair[kmerPos].id && hashSeqPair[kmerPos].pos == diagonal && kmerPos < totalKmers && hashSeqPair[kmerPos].kmer != SIZE_T_MAX);
+        }while(targetId == hashSeqPair[kmerPos].id && hashSeqPair[kmerPos].pos == diagonal && kmerPos < totalKmers && hashSeqPair[kmerPos].getKmer() != SIZE_T_MAX);
         kmerPos--;
 
         elemenetCnt++;
@@ -1171,8 +1320,10 @@ void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *hashSeqPair
         lastTargetId = targetId;
         writeSets++;
     }
-    if (writeSets > 0 && elemenetCnt > 0 && bufferPos > 0) {
-        fwrite(writeBuffer, sizeof(T), bufferPos, filePtr);
+    if (writeSets > 0 && elemenetCnt > 0) {
+        if (bufferPos > 0) {
+            fwrite(writeBuffer, sizeof(T), bufferPos, filePtr);
+        }
         fwrite(&nullEntry,  sizeof(T), 1, filePtr);
     }
     if (fclose(filePtr) != 0) {
@@ -1217,20 +1368,20 @@ void setKmerLengthAndAlphabet(Parameters &parameters, size_t aaDbSize, int seqTy
 }
 
 template std::pair<size_t, size_t>  fillKmerPositionArray<0, short>(KmerPosition<short> * kmerArray, size_t kmerArraySize, DBReader<unsigned int> &seqDbr,
-                                                                    Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution);
+                                                                    Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution, const SequenceRanks *ranks);
 template std::pair<size_t, size_t>  fillKmerPositionArray<1, short>(KmerPosition<short> * kmerArray, size_t kmerArraySize, DBReader<unsigned int> &seqDbr,
-                                                                    Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution);
+                                                                    Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution, const SequenceRanks *ranks);
 template std::pair<size_t, size_t>  fillKmerPositionArray<2, short>(KmerPosition<short> * kmerArray, size_t kmerArraySize, DBReader<unsigned int> &seqDbr,
-                                                                    Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution);
+                                                                    Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution, const SequenceRanks *ranks);
 template std::pair<size_t, size_t>  fillKmerPositionArray<0, int>(KmerPosition<int> * kmerArray, size_t kmerArraySize, DBReader<unsigned int> &seqDbr,
-                                                                  Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution);
+                                                                  Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution, const SequenceRanks *ranks);
 template std::pair<size_t, size_t>  fillKmerPositionArray<1, int>(KmerPosition <int>* kmerArray, size_t kmerArraySize, DBReader<unsigned int> &seqDbr,
-                                                                  Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution);
+                                                                  Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution, const SequenceRanks *ranks);
 template std::pair<size_t, size_t>  fillKmerPositionArray<2, int>(KmerPosition< int> * kmerArray, size_t kmerArraySize, DBReader<unsigned int> &seqDbr,
-                                                                  Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution);
+                                                                  Parameters & par, BaseMatrix * subMat, bool hashWholeSequence, size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution, const SequenceRanks *ranks);
 
-template KmerPosition<short> *initKmerPositionMemory(size_t size);
-template KmerPosition<int> *initKmerPositionMemory(size_t size);
+template KmerPosition<short> *initKmerPositionMemory<short>(size_t size);
+template KmerPosition<int> *initKmerPositionMemory<int>(size_t size);
 
 template size_t computeMemoryNeededLinearfilter<short>(size_t totalKmer);
 template size_t computeMemoryNeededLinearfilter<int>(size_t totalKmer);
@@ -6,6 +6,7 @@
 #include "DBReader.h"
 #include "Parameters.h"
 #include "BaseMatrix.h"
+#include "SequenceMasks.h"
 
 
 struct SequencePosition{
@@ -47,6 +48,31 @@ struct SequencePosition{
     }
 };
 
+// Orders the sequences by decreasing length and increasing key. Compact k-mer entries store the rank of their
+// sequence instead of its key and length, sorting them by rank equals sorting by decreasing length and key.
+class SequenceRanks {
+public:
+    explicit SequenceRanks(DBReader<unsigned int> &reader);
+
+    unsigned int getRank(size_t id) const {
+        return ranks[id];
+    }
+    unsigned int getKey(unsigned int rank) const {
+        return reader.getDbKey(ids[rank]);
+    }
+    unsigned int getLength(unsigned int rank) const {
+        return reader.getSeqLen(ids[rank]);
+    }
+    size_t getMemorySize() const {
+        return (ranks.size() + ids.size()) * sizeof(unsigned int);
+    }
+
+private:
+    DBReader<unsigned int> &reader;
+    std::vector<unsigned int> ranks;
+    std::vector<unsigned int> ids;
+};
+
 template <typename T>
 struct __attribute__((__packed__))KmerPosition {
     size_t kmer;
@@ -54,6 +80,26 @@ struct __attribute__((__packed__))KmerPosition {
     T seqLen;
     T pos;
 
+    size_t getKmer() const {
+        return kmer;
+    }
+    void setKmer(size_t value) {
+        kmer = value;
+    }
+    void setSequenceHash(size_t value) {
+        kmer = value;
+    }
+    void setSequence(unsigned int key, unsigned int, T length) {
+        id = key;
+        seqLen = length;
+    }
+    unsigned int getKey(const SequenceRanks *) const {
+        return id;
+    }
+    T getSeqLen(const SequenceRanks *) const {
+        return seqLen;
+    }
+
     static bool compareRepSequenceAndIdAndPos(const KmerPosition<T> &first, const KmerPosition<T> &second){
         if(first.kmer < second.kmer )
             return true;
@@ -133,6 +179,98 @@ struct __attribute__((__packed__))KmerPosition {
 
 
 
+// Compact k-mer entry of the linclust k-mer matcher (12 to 15 instead of 16 or 20 bytes). The k-mer is stored
+// in KmerBits bits, the strand flag moves from bit 63 to the highest of these bits and the sequence hashes are
+// truncated below the next bit, which tags them apart from the k-mer indices. The sequence length is looked up through the rank in id, assignGroup replaces the rank with the key.
+template <typename T, unsigned int KmerBits>
+struct __attribute__((__packed__)) KmerPositionCompact {
+    size_t kmer : KmerBits;
+    unsigned int id;
+    T pos;
+
+    static const size_t EMPTY_KMER = (1ULL << KmerBits) - 1;
+    static const unsigned int FLAG_BIT = KmerBits - 1;
+    static const unsigned int SEQUENCE_HASH_BIT = KmerBits - 2;
+
+    size_t getKmer() const {
+        const size_t value = kmer;
+        if (value == EMPTY_KMER) {
+            return SIZE_MAX;
+        }
+        return BIT_CHECK(value, FLAG_BIT) ? BIT_SET(BIT_CLEAR(value, FLAG_BIT), 63) : value;
+    }
+    void setKmer(size_t value) {
+        if (value == SIZE_MAX) {
+            kmer = EMPTY_KMER;
+            return;
+        }
+        size_t packed = (value & (EMPTY_KMER >> 1)) | (BIT_CHECK(value, 63) ? (1ULL << FLAG_BIT) : 0);
+        // a truncated sequence hash must not mark the end of the entries
+        kmer = (packed == EMPTY_KMER) ? packed - 1 : packed;
+    }
+    void setSequenceHash(size_t value) {
+        // bit 62 is truncated anyway, clearing it keeps the hash apart from SIZE_MAX
+        setKmer(BIT_SET(BIT_CLEAR(value, 62), SEQUENCE_HASH_BIT));
+    }
+    void setSequence(unsigned int, unsigned int rank, T) {
+        id = rank;
+    }
+    unsigned int getKey(const SequenceRanks *ranks) const {
+        return ranks->getKey(id);
+    }
+    T getSeqLen(const SequenceRanks *ranks) const {
+        return static_cast<T>(ranks->getLength(id));
+    }
+
+    // the packed k-mers keep the order of the full k-mers, ranks order by length and key
+    static bool compareRepSequenceAndIdAndPos(const KmerPositionCompact &first, const KmerPositionCompact &second) {
+        const size_t firstKmer = first.kmer;
+        const size_t secondKmer = second.kmer;
+        if (firstKmer != secondKmer) {
+            return firstKmer < secondKmer;
+        }
+        if (first.id != second.id) {
+            return first.id < second.id;
+        }
+        return first.pos < second.pos;
+    }
+
+    static bool compareRepSequenceAndIdAndPosReverse(const KmerPositionCompact &first, const KmerPositionCompact &second) {
+        const size_t firstKmer = BIT_SET(static_cast<size_t>(first.kmer), FLAG_BIT);
+        const size_t secondKmer = BIT_SET(static_cast<size_t>(second.kmer), FLAG_BIT);
+        if (firstKmer != secondKmer) {
+            return firstKmer < secondKmer;
+        }
+        if (first.id != second.id) {
+            return first.id < second.id;
+        }
+        return first.pos < second.pos;
+    }
+
+    // after assignGroup the k-mer holds the rep. sequence and id the key
+    static bool compareRepSequenceAndIdAndDiag(const KmerPositionCompact &first, const KmerPositionCompact &second) {
+        return compareRepSequenceAndIdAndPos(first, second);
+    }
+
+    static bool compareRepSequenceAndIdAndDiagReverse(const KmerPositionCompact &first, const KmerPositionCompact &second) {
+        return compareRepSequenceAndIdAndPosReverse(first, second);
+    }
+};
+
+// KmerBits 64 selects the full entry, the only one that can store arbitrary k-mers
+template <typename T, unsigned int KmerBits>
+struct KmerPositionType {
+    typedef KmerPositionCompact<T, KmerBits> type;
+};
+
+template <typename T>
+struct KmerPositionType<T, 64> {
+    typedef KmerPosition<T> type;
+};
+
+// returns the smallest supported k-mer width for the k-mers of the linclust k-mer matcher
+unsigned int computeKmerBits(Parameters &par, int seqType);
+
 struct __attribute__((__packed__)) KmerEntry {
     unsigned int seqId;
     short diagonal;
@@ -193,8 +331,9 @@ public:
 };
 
 
-template  <int TYPE, typename T>
-size_t assignGroup(KmerPosition<T> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr);
+template  <int TYPE, typename T, unsigned int KmerBits = 64>
+size_t assignGroup(typename KmerPositionType<T, KmerBits>::type *kmers, size_t splitKmerCount, bool includeOnlyExtendable,
+                   int covMode, float covThr, const SequenceRanks *ranks);
 
 template <int TYPE, typename T>
 void mergeKmerFilesAndOutput(DBWriter & dbw, std::vector<std::string> tmpFiles, std::vector<char> &repSequence);
@@ -206,11 +345,11 @@ size_t queueNextEntry(KmerPositionQueue &queue, int file, size_t offsetPos, T *e
 
 void setKmerLengthAndAlphabet(Parameters &parameters, size_t aaDbSize, int seqType);
 
-template <int TYPE, typename T, typename seqLenType>
-void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *kmers, size_t totalKmers);
+template <int TYPE, typename T, typename seqLenType, unsigned int KmerBits = 64>
+void writeKmersToDisk(std::string tmpFile, typename KmerPositionType<seqLenType, KmerBits>::type *kmers, size_t totalKmers);
 
-template <int TYPE, typename T>
-void writeKmerMatcherResult(DBWriter & dbw, KmerPosition<T> *hashSeqPair, size_t totalKmers,
+template <int TYPE, typename T, unsigned int KmerBits = 64>
+void writeKmerMatcherResult(DBWriter & dbw, typename KmerPositionType<T, KmerBits>::type *hashSeqPair, size_t totalKmers,
                             std::vector<char> &repSequence, size_t threads);
 
 
@@ -218,22 +357,24 @@ template <typename T>
 KmerPosition<T> * doComputation(size_t totalKmers, size_t split, size_t splits, std::string splitFile,
                                 DBReader<unsigned int> & seqDbr, Parameters & par, BaseMatrix  * subMat,
                                 size_t KMER_SIZE, size_t chooseTopKmer, float chooseTopKmerScale = 0.0);
-template <typename T>
-KmerPosition<T> *initKmerPositionMemory(size_t size);
+template <typename T, unsigned int KmerBits = 64>
+typename KmerPositionType<T, KmerBits>::type *initKmerPositionMemory(size_t size);
 
-template <int TYPE, typename T>
-std::pair<size_t, size_t>  fillKmerPositionArray(KmerPosition<T> * kmerArray, size_t kmerArraySize, DBReader<unsigned int> &seqDbr,
+template <int TYPE, typename T, unsigned int KmerBits = 64>
+std::pair<size_t, size_t>  fillKmerPositionArray(typename KmerPositionType<T, KmerBits>::type * kmerArray, size_t kmerArraySize, DBReader<unsigned int> &seqDbr,
                                                  Parameters & par, BaseMatrix * subMat, bool hashWholeSequence,
-                                                 size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution);
+                                                 size_t hashStartRange, size_t hashEndRange, size_t * hashDistribution,
+                                                 const SequenceRanks *ranks = NULL);
 
 
 void maskSequence(int maskMode, int maskLowerCase,
-                  Sequence &seq, int maskLetter, ProbabilityMatrix * probMatrix);
+                  Sequence &seq, int maskLetter, ProbabilityMatrix * probMatrix,
+                  SequenceMasks * sequenceMasks, unsigned int thread_idx);
 
-template <typename T>
+template <typename T, unsigned int KmerBits = 64>
 size_t computeMemoryNeededLinearfilter(size_t totalKmer);
 
-template <typename T>
+template <typename T, unsigned int KmerBits = 64>
 std::vector<std::pair<size_t, size_t>> setupKmerSplits(Parameters &par, BaseMatrix * subMat, DBReader<unsigned int> &seqDbr, size_t totalKmers, size_t splits);
 
 size_t computeKmerCount(DBReader<unsigned int> &reader, size_t KMER_SIZE, size_t chooseTopKmer,
@@ -16,6 +16,10 @@
 #include "FileUtil.h"
 #include "FastSort.h"
 
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
 #ifndef SIZE_T_MAX
 #define SIZE_T_MAX ((size_t) -1)
 #endif
@@ -59,13 +63,18 @@ KmerSearch::ExtractKmerAndSortResult KmerSearch::extractKmerAndSort(size_t total
 }
 
 template <int TYPE>
-void KmerSearch::writeResult(DBWriter & dbw, KmerPosition<short> *kmers, size_t kmerCount) {
+static inline size_t getRepSeqId(const KmerPosition<short> &kmer) {
+    return (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? BIT_CLEAR(kmer.kmer, 63) : kmer.kmer;
+}
+
+template <int TYPE>
+static void writeResultRange(DBWriter & dbw, KmerPosition<short> *kmers, size_t kmerFrom, size_t kmerTo, unsigned int thread_idx) {
     size_t repSeqId = SIZE_T_MAX;
     unsigned int prevHitId;
     char buffer[100];
     std::string prefResultsOutString;
-    prefResultsOutString.reserve(100000000);
-    for(size_t i = 0; i < kmerCount; i++) {
+    prefResultsOutString.reserve(1024 * 1024);
+    for(size_t i = kmerFrom; i < kmerTo; i++) {
         size_t currId = kmers[i].kmer;
         int reverMask = 0;
         if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
@@ -74,7 +83,7 @@ void KmerSearch::writeResult(DBWriter & dbw, KmerPosition<short> *kmers, size_t
         }
         if (repSeqId != currId) {
             if(repSeqId != SIZE_T_MAX){
-                dbw.writeData(prefResultsOutString.c_str(), prefResultsOutString.length(), static_cast<unsigned int>(repSeqId), 0);
+                dbw.writeData(prefResultsOutString.c_str(), prefResultsOutString.length(), static_cast<unsigned int>(repSeqId), thread_idx);
             }
             repSeqId = currId;
             prefResultsOutString.clear();
@@ -109,7 +118,7 @@ void KmerSearch::writeResult(DBWriter & dbw, KmerPosition<short> *kmers, size_t
                 tmpCurrId = BIT_CLEAR(tmpCurrId, 63);
 
             }
-        } while(hitId == prevHitId && currId == tmpCurrId && i < kmerCount);
+        } while(hitId == prevHitId && currId == tmpCurrId && i < kmerTo);
         i--;
 
         hit_t h;
@@ -123,11 +132,34 @@ void KmerSearch::writeResult(DBWriter & dbw, KmerPosition<short> *kmers, size_t
     // last element
     if(prefResultsOutString.size()>0){
         if(repSeqId != SIZE_T_MAX){
-            dbw.writeData(prefResultsOutString.c_str(), prefResultsOutString.length(), static_cast<unsigned int>(repSeqId), 0);
+            dbw.writeData(prefResultsOutString.c_str(), prefResultsOutString.length(), static_cast<unsigned int>(repSeqId), thread_idx);
         }
     }
 }
 
+template <int TYPE>
+void KmerSearch::writeResult(DBWriter & dbw, KmerPosition<short> *kmers, size_t kmerCount) {
+    // each thread writes a chunk of the sorted results, chunks start at the first hit of a representative sequence
+    const size_t threads = dbw.getThreads();
+    std::vector<size_t> chunkStart(threads + 1, kmerCount);
+    chunkStart[0] = 0;
+    for (size_t chunk = 1; chunk < threads; chunk++) {
+        size_t start = std::max(chunkStart[chunk - 1], (kmerCount * chunk) / threads);
+        while (start > 0 && start < kmerCount && getRepSeqId<TYPE>(kmers[start]) == getRepSeqId<TYPE>(kmers[start - 1])) {
+            start++;
+        }
+        chunkStart[chunk] = start;
+    }
+#pragma omp parallel for schedule(static, 1) num_threads(threads)
+    for (size_t chunk = 0; chunk < threads; chunk++) {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        writeResultRange<TYPE>(dbw, kmers, chunkStart[chunk], chunkStart[chunk + 1], thread_idx);
+    }
+}
+
 template void KmerSearch::writeResult<0>(DBWriter & dbw, KmerPosition<short> *kmers, size_t kmerCount);
 template void KmerSearch::writeResult<1>(DBWriter & dbw, KmerPosition<short> *kmers, size_t kmerCount);
 
@@ -222,11 +254,14 @@ int kmersearch(int argc, const char **argv, const Command &command) {
     for (size_t split = 0; split < hashRanges.size(); split++) {
         tidxdbr.remapData();
         char *entriesData = tidxdbr.getDataUncompressed(tidxdbr.getId(PrefilteringIndexReader::ENTRIES));
-        char *entriesOffsetsData = tidxdbr.getDataUncompressed(tidxdbr.getId(PrefilteringIndexReader::ENTRIESOFFSETS));
+        size_t entriesOffsetsId = tidxdbr.getId(PrefilteringIndexReader::ENTRIESOFFSETS);
+        char *entriesOffsetsData = tidxdbr.getDataUncompressed(entriesOffsetsId);
+        // the entry is terminated by a null byte
+        size_t entriesOffsetsSize = (tidxdbr.getEntryLen(entriesOffsetsId) - 1) / sizeof(size_t);
         int64_t entriesNum = *((int64_t *) tidxdbr.getDataUncompressed(tidxdbr.getId(PrefilteringIndexReader::ENTRIESNUM)));
         int64_t entriesGridSize = *((int64_t *) tidxdbr.getDataUncompressed(tidxdbr.getId(PrefilteringIndexReader::ENTRIESGRIDSIZE)));
         int alphabetSize = (Parameters::isEqualDbtype(queryDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) ? par.alphabetSize.nucleotides:par.alphabetSize.aminoacids;
-        KmerIndex kmerIndex(alphabetSize, adjustedKmerSize, entriesData, entriesOffsetsData, entriesNum, entriesGridSize);
+        KmerIndex kmerIndex(alphabetSize, adjustedKmerSize, entriesData, entriesOffsetsData, entriesOffsetsSize, entriesNum, entriesGridSize);
 //        kmerIndex.printIndex<Parameters::DBTYPE_NUCLEOTIDES>(subMat);
         std::pair<std::string, std::string> tmpFiles;
         if (splits > 1) {
@@ -253,7 +288,7 @@ int kmersearch(int argc, const char **argv, const Command &command) {
             KmerPosition<short> *kmers = result.first;
             size_t kmerCount = result.second;
             if (splits == 1) {
-                DBWriter dbw(tmpFiles.first.c_str(), tmpFiles.second.c_str(), 1, par.compressed, outDbType);
+                DBWriter dbw(tmpFiles.first.c_str(), tmpFiles.second.c_str(), static_cast<unsigned int>(par.threads), par.compressed, outDbType);
                 dbw.open();
                 if (Parameters::isEqualDbtype(queryDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) {
                     KmerSearch::writeResult<Parameters::DBTYPE_NUCLEOTIDES>(dbw, kmers, kmerCount);
@@ -276,7 +311,7 @@ int kmersearch(int argc, const char **argv, const Command &command) {
     tidxdbr.close();
     queryDbr.close();
     if(splitFiles.size()>1){
-        DBWriter writer(par.db3.c_str(), par.db3Index.c_str(), 1, par.compressed, outDbType);
+        DBWriter writer(par.db3.c_str(), par.db3Index.c_str(), static_cast<unsigned int>(par.threads), par.compressed, outDbType);
         writer.open(); // 1 GB buffer
         std::vector<char> empty;
         if(Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_NUCLEOTIDES)) {
@@ -293,26 +328,23 @@ int kmersearch(int argc, const char **argv, const Command &command) {
     }
     return EXIT_SUCCESS;
 }
+template <int TYPE>
+static inline size_t getKmerKey(size_t kmer) {
+    // the strand bit of nucleotide k-mers is not part of the k-mer
+    return (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? BIT_CLEAR(kmer, 63) : kmer;
+}
+
+// merge-join the sorted query k-mers [kmerFrom, kmerTo) with the index k-mers of the same range
+// results are written in place starting at kmerFrom, returns the number of results
 template  <int TYPE>
-std::pair<KmerPosition<short> *,size_t > KmerSearch::searchInIndex(KmerPosition<short> *kmers, size_t kmersSize, KmerIndex &kmerIndex, int resultDirection) {
-    Timer timer;
-    bool queryTargetSwitched = (resultDirection == Parameters::PARAM_RESULT_DIRECTION_TARGET);
-    kmerIndex.reset();
-    KmerIndex::KmerEntry currTargetKmer;
-    bool isDone = false;
-    if(kmerIndex.hasNextEntry()){
-        if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
-            currTargetKmer = kmerIndex.getNextEntry<Parameters::DBTYPE_NUCLEOTIDES>();
-        }else{
-            currTargetKmer = kmerIndex.getNextEntry<Parameters::DBTYPE_AMINO_ACIDS>();
-        }
-    }else{
-        isDone = true;
+static size_t joinKmerRange(KmerPosition<short> *kmers, size_t kmerFrom, size_t kmerTo, KmerIndex &kmerIndex, bool queryTargetSwitched) {
+    if (kmerFrom >= kmerTo || kmerIndex.hasNextEntry() == false) {
+        return 0;
     }
-
-    size_t kmerPos = 0;
-    size_t writePos = 0;
-    // this is IO bound, optimisation does not make much sense here.
+    KmerIndex::KmerEntry currTargetKmer = kmerIndex.getNextEntry<TYPE>();
+    bool isDone = false;
+    size_t kmerPos = kmerFrom;
+    size_t writePos = kmerFrom;
     size_t queryKmer;
     size_t targetKmer;
 
@@ -328,7 +360,7 @@ std::pair<KmerPosition<short> *,size_t > KmerSearch::searchInIndex(KmerPosition<
 
         if(queryKmer < targetKmer){
             while(queryKmer < targetKmer) {
-                if (kmerPos + 1 < kmersSize) {
+                if (kmerPos + 1 < kmerTo) {
                     kmerPos++;
                 } else {
                     isDone = true;
@@ -344,17 +376,12 @@ std::pair<KmerPosition<short> *,size_t > KmerSearch::searchInIndex(KmerPosition<
         }else if(targetKmer < queryKmer){
             while(targetKmer < queryKmer){
                 if(kmerIndex.hasNextEntry()) {
-                    if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
-                        currTargetKmer = kmerIndex.getNextEntry<Parameters::DBTYPE_NUCLEOTIDES>();
-                    }else{
-                        currTargetKmer = kmerIndex.getNextEntry<Parameters::DBTYPE_AMINO_ACIDS>();
-                    }
+                    currTargetKmer = kmerIndex.getNextEntry<TYPE>();
                     if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
                         targetKmer = BIT_SET(currTargetKmer.kmer, 63);
                     }else{
                         targetKmer = currTargetKmer.kmer;
                     }
-                    //TODO remap logic to speed things up
                 }else{
                     isDone = true;
                     break;
@@ -412,11 +439,73 @@ std::pair<KmerPosition<short> *,size_t > KmerSearch::searchInIndex(KmerPosition<
             (kmers+writePos)->seqLen = currQueryKmer->seqLen;
 
             writePos++;
-            if(kmerPos+1<kmersSize){
+            if(kmerPos + 1 < kmerTo){
                 kmerPos++;
+            }else{
+                isDone = true;
             }
         }
     }
+    return writePos - kmerFrom;
+}
+
+template  <int TYPE>
+std::pair<KmerPosition<short> *,size_t > KmerSearch::searchInIndex(KmerPosition<short> *kmers, size_t kmersSize, KmerIndex &kmerIndex, int resultDirection) {
+    Timer timer;
+    bool queryTargetSwitched = (resultDirection == Parameters::PARAM_RESULT_DIRECTION_TARGET);
+
+    // the k-mer space is partitioned along the index grid, ranges are balanced by index entries
+    // and joined independently. Each range writes its results in place into its query k-mers.
+    size_t threads = 1;
+#ifdef OPENMP
+    threads = static_cast<size_t>(omp_get_max_threads());
+#endif
+    const size_t gridSize = kmerIndex.getOffsetsSize();
+    const size_t *entryOffsets = kmerIndex.getOffsets();
+    const size_t entryCount = kmerIndex.getTableEntriesNum();
+    const size_t rangeCount = std::max(static_cast<size_t>(1), std::min(gridSize, threads * 4));
+    std::vector<size_t> gridBounds(rangeCount + 1, 0);
+    std::vector<size_t> kmerBounds(rangeCount + 1, 0);
+    std::vector<size_t> resultCount(rangeCount, 0);
+    gridBounds[rangeCount] = gridSize;
+    kmerBounds[rangeCount] = kmersSize;
+    for (size_t range = 1; range < rangeCount; range++) {
+        const size_t entryTarget = (entryCount * range) / rangeCount;
+        size_t grid = std::lower_bound(entryOffsets, entryOffsets + gridSize, entryTarget) - entryOffsets;
+        gridBounds[range] = std::max(gridBounds[range - 1], grid);
+        const size_t kmerStart = gridBounds[range] * kmerIndex.getGridResolution();
+        size_t lo = kmerBounds[range - 1];
+        size_t hi = kmersSize;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (getKmerKey<TYPE>(kmers[mid].kmer) < kmerStart) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        kmerBounds[range] = lo;
+    }
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t range = 0; range < rangeCount; range++) {
+        if (gridBounds[range] == gridBounds[range + 1] || kmerBounds[range] == kmerBounds[range + 1]) {
+            continue;
+        }
+        // the copy shares the mmaped index data, only the iterator is thread local
+        KmerIndex rangeIndex(kmerIndex);
+        rangeIndex.setGridRange(gridBounds[range], gridBounds[range + 1]);
+        resultCount[range] = joinKmerRange<TYPE>(kmers, kmerBounds[range], kmerBounds[range + 1], rangeIndex, queryTargetSwitched);
+    }
+
+    // results only move towards the front, so the ranges can be compacted in order
+    size_t writePos = 0;
+    for (size_t range = 0; range < rangeCount; range++) {
+        if (resultCount[range] > 0 && writePos != kmerBounds[range]) {
+            memmove(kmers + writePos, kmers + kmerBounds[range], resultCount[range] * sizeof(KmerPosition<short>));
+        }
+        writePos += resultCount[range];
+    }
     Debug(Debug::INFO) << "Time to find k-mers: " << timer.lap() << "\n";
     timer.reset();
     if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
@@ -1,5 +1,6 @@
 #include "IndexBuilder.h"
 #include "tantan.h"
+#include "SequenceMasks.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -62,27 +63,34 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
     size_t dbSize = dbTo - dbFrom;
     DbInfo* info = new DbInfo(dbFrom, dbTo, seq->getEffectiveKmerSize(), *dbr);
 
-    SequenceLookup *sequenceLookup;
     if (unmaskedLookup != NULL && maskedLookup == NULL) {
         *unmaskedLookup = new SequenceLookup(dbSize, info->aaDbSize);
-        sequenceLookup = *unmaskedLookup;
     } else if (unmaskedLookup == NULL && maskedLookup != NULL) {
         *maskedLookup = new SequenceLookup(dbSize, info->aaDbSize);
-        sequenceLookup = *maskedLookup;
     } else if (unmaskedLookup != NULL && maskedLookup != NULL) {
         *unmaskedLookup = new SequenceLookup(dbSize, info->aaDbSize);
         *maskedLookup = new SequenceLookup(dbSize, info->aaDbSize);
-        sequenceLookup = *maskedLookup;
     } else{
         Debug(Debug::ERROR) << "This should not happen\n";
         EXIT(EXIT_FAILURE);
     }
 
+    unsigned int threads = 1;
+#ifdef OPENMP
+    threads = static_cast<unsigned int>(omp_get_max_threads());
+#endif
+
     // need to prune low scoring k-mers through masking
+    // masks precomputed by createmaskdb are used instead of running tantan again
+    SequenceMasks *sequenceMasks = NULL;
     ProbabilityMatrix *probMatrix = NULL;
+    if (mask == true) {
+        sequenceMasks = SequenceMasks::openIfExists(dbr->getDataFileName(), SequenceMasks::getSettings(*dbr, subMat, 0.9, 0.9), threads);
+    }
     if (maskedLookup != NULL) {
         probMatrix = new ProbabilityMatrix(subMat);
     }
+    const unsigned char maskLetter = subMat.aa2num[static_cast<int>('X')];
 
     // identical scores for memory reduction code
     char *idScoreLookup = NULL;
@@ -91,6 +99,19 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
     }
     Debug::Progress progress(dbTo-dbFrom);
 
+    // sequences are processed in contiguous blocks, the unique k-mers of each block are cached in buckets
+    // of disjoint k-mer ranges. Each range is then counted and filled by a single thread walking the blocks
+    // in order, so the sequence lists end up sorted by seqId without atomics or a final sort.
+    // Profiles generate too many similar k-mers to be cached, they are counted and filled in two passes.
+    const size_t numBlocks = std::max(static_cast<size_t>(1), std::min(dbSize, static_cast<size_t>(threads) * 4));
+    const size_t blockSize = (dbSize + numBlocks - 1) / numBlocks;
+    const size_t numRanges = isProfile ? 1 : static_cast<size_t>(threads) * 4;
+    const size_t rangeSize = (indexTable->getTableSize() + numRanges - 1) / numRanges;
+    std::vector<IndexEntryLocalTmp> *buckets = NULL;
+    if (isProfile == false) {
+        buckets = new std::vector<IndexEntryLocalTmp>[numBlocks * numRanges];
+    }
+
     size_t maskedResidues = 0;
     size_t totalKmerCount = 0;
     #pragma omp parallel
@@ -109,60 +130,79 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
             generator->setDivideStrategy(s.profile_matrix);
         }
 
-        unsigned int *buffer = static_cast<unsigned int*>(malloc(seq->getMaxLen() * sizeof(unsigned int)));
-        unsigned int bufferSize = seq->getMaxLen();
-        #pragma omp for schedule(dynamic, 100) reduction(+:totalKmerCount, maskedResidues)
-        for (size_t id = dbFrom; id < dbTo; id++) {
-            progress.updateProgress();
-
-            s.resetCurrPos();
-            char *seqData = dbr->getData(id, thread_idx);
-            unsigned int qKey = dbr->getDbKey(id);
-
-            s.mapSequence(id - dbFrom, qKey, seqData, dbr->getSeqLen(id));
-            if(s.getMaxLen() >= bufferSize ){
-                buffer = static_cast<unsigned int*>(realloc(buffer, s.getMaxLen() * sizeof(unsigned int)));
-                bufferSize = seq->getMaxLen();
-            }
-            // count similar or exact k-mers based on sequence type
-            if (isProfile) {
-                // Find out if we should also mask profiles
-                totalKmerCount += indexTable->addSimilarKmerCount(&s, generator);
-                (*unmaskedLookup)->addSequence(s.numConsensusSequence, s.L, id - dbFrom, info->sequenceOffsets[id - dbFrom]);
-            } else {
-                // Do not mask if column state sequences are used
-                if (unmaskedLookup != NULL) {
-                    (*unmaskedLookup)->addSequence(s.numSequence, s.L, id - dbFrom, info->sequenceOffsets[id - dbFrom]);
-                }
-                if (mask == true) {
-                    // s.print();
-                    maskedResidues += tantan::maskSequences((char*)s.numSequence,
-                                                            (char*)(s.numSequence + s.L),
-                                                            50 /*options.maxCycleLength*/,
-                                                            probMatrix->probMatrixPointers,
-                                                            0.005 /*options.repeatProb*/,
-                                                            0.05 /*options.repeatEndProb*/,
-                                                            0.9 /*options.repeatOffsetProbDecay*/,
-                                                            0, 0,
-                                                            0.9 /*options.minMaskProb*/,
-                                                            probMatrix->hardMaskTable);
+        size_t bufferSize = seq->getMaxLen();
+        IndexEntryLocalTmp *buffer = static_cast<IndexEntryLocalTmp*>(malloc(bufferSize * sizeof(IndexEntryLocalTmp)));
+        #pragma omp for schedule(dynamic, 1) reduction(+:totalKmerCount, maskedResidues)
+        for (size_t block = 0; block < numBlocks; block++) {
+            const size_t blockFrom = dbFrom + block * blockSize;
+            const size_t blockTo = std::min(dbTo, blockFrom + blockSize);
+            for (size_t id = blockFrom; id < blockTo; id++) {
+                progress.updateProgress();
+
+                s.resetCurrPos();
+                char *seqData = dbr->getData(id, thread_idx);
+                unsigned int qKey = dbr->getDbKey(id);
+
+                s.mapSequence(id - dbFrom, qKey, seqData, dbr->getSeqLen(id));
+                if (static_cast<size_t>(s.L) >= bufferSize) {
+                    bufferSize = s.L + 1;
+                    buffer = static_cast<IndexEntryLocalTmp*>(realloc(buffer, bufferSize * sizeof(IndexEntryLocalTmp)));
+                    Util::checkAllocation(buffer, "Can not reallocate k-mer buffer in IndexBuilder::fillDatabase");
                 }
+                // count similar or exact k-mers based on sequence type
+                if (isProfile) {
+                    // Find out if we should also mask profiles
+                    totalKmerCount += indexTable->addSimilarKmerCount(&s, generator);
+                    (*unmaskedLookup)->addSequence(s.numConsensusSequence, s.L, id - dbFrom, info->sequenceOffsets[id - dbFrom]);
+                } else {
+                    // Do not mask if column state sequences are used
+                    if (unmaskedLookup != NULL) {
+                        (*unmaskedLookup)->addSequence(s.numSequence, s.L, id - dbFrom, info->sequenceOffsets[id - dbFrom]);
+                    }
+                    if (mask == true && (sequenceMasks == NULL
+                                         || sequenceMasks->applyMask(qKey, s.numSequence, s.L, maskLetter, thread_idx, maskedResidues) == false)) {
+                        // s.print();
+                        maskedResidues += tantan::maskSequences((char*)s.numSequence,
+                                                                (char*)(s.numSequence + s.L),
+                                                                50 /*options.maxCycleLength*/,
+                                                                probMatrix->probMatrixPointers,
+                                                                0.005 /*options.repeatProb*/,
+                                                                0.05 /*options.repeatEndProb*/,
+                                                                0.9 /*options.repeatOffsetProbDecay*/,
+                                                                0, 0,
+                                                                0.9 /*options.minMaskProb*/,
+                                                                probMatrix->hardMaskTable);
+                    }
 
-                if(maskLowerCaseMode == true && (Parameters::isEqualDbtype(s.getSequenceType(), Parameters::DBTYPE_AMINO_ACIDS) ||
-                                                  Parameters::isEqualDbtype(s.getSequenceType(), Parameters::DBTYPE_NUCLEOTIDES))) {
-                    const char * charSeq = s.getSeqData();
-                    unsigned char maskLetter = subMat.aa2num[static_cast<int>('X')];
-                    for (int i = 0; i < s.L; i++) {
-                        bool isLowerCase = (islower(charSeq[i]));
-                        maskedResidues += isLowerCase;
-                        s.numSequence[i] = isLowerCase ? maskLetter : s.numSequence[i];
+                    if(maskLowerCaseMode == true && (Parameters::isEqualDbtype(s.getSequenceType(), Parameters::DBTYPE_AMINO_ACIDS) ||
+                                                      Parameters::isEqualDbtype(s.getSequenceType(), Parameters::DBTYPE_NUCLEOTIDES))) {
+                        const char * charSeq = s.getSeqData();
+                        for (int i = 0; i < s.L; i++) {
+                            bool isLowerCase = (islower(charSeq[i]));
+                            maskedResidues += isLowerCase;
+                            s.numSequence[i] = isLowerCase ? maskLetter : s.numSequence[i];
+                        }
+                    }
+                    if(maskedLookup != NULL){
+                        (*maskedLookup)->addSequence(s.numSequence, s.L, id - dbFrom, info->sequenceOffsets[id - dbFrom]);
                     }
-                }
-                if(maskedLookup != NULL){
-                    (*maskedLookup)->addSequence(s.numSequence, s.L, id - dbFrom, info->sequenceOffsets[id - dbFrom]);
-                }
 
-                totalKmerCount += indexTable->addKmerCount(&s, &idxer, buffer, kmerThr, idScoreLookup);
+                    // k-mers come out sorted, so each range is a contiguous run of the buffer
+                    size_t kmerCount = indexTable->extractUniqueKmers(&s, &idxer, buffer, kmerThr, idScoreLookup);
+                    size_t pos = 0;
+                    while (pos < kmerCount) {
+                        const size_t range = buffer[pos].kmer / rangeSize;
+                        const size_t rangeEnd = (range + 1) * rangeSize;
+                        size_t end = pos + 1;
+                        while (end < kmerCount && buffer[end].kmer < rangeEnd) {
+                            end++;
+                        }
+                        std::vector<IndexEntryLocalTmp> &bucket = buckets[block * numRanges + range];
+                        bucket.insert(bucket.end(), buffer + pos, buffer + end);
+                        pos = end;
+                    }
+                    totalKmerCount += kmerCount;
+                }
             }
         }
 
@@ -176,6 +216,9 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
     if(probMatrix != NULL) {
         delete probMatrix;
     }
+    if (sequenceMasks != NULL) {
+        delete sequenceMasks;
+    }
 
     Debug(Debug::INFO) << "Index table: Masked residues: " << maskedResidues << "\n";
     if(totalKmerCount == 0) {
@@ -204,13 +247,40 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
 //    Debug(Debug::INFO) << "Index table: Remove "<< lowSelectiveResidues <<" none selective residues\n";
 //    Debug(Debug::INFO) << "Index table: init... from "<< dbFrom << " to "<< dbTo << "\n";
 
+    if (isProfile == false) {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (size_t range = 0; range < numRanges; range++) {
+            for (size_t block = 0; block < numBlocks; block++) {
+                const std::vector<IndexEntryLocalTmp> &bucket = buckets[block * numRanges + range];
+                indexTable->addKmerCount(bucket.data(), bucket.size());
+            }
+        }
+    }
+
     indexTable->initMemory(info->tableSize);
     indexTable->init();
 
     delete info;
-    Debug::Progress progress2(dbTo-dbFrom);
 
     Debug(Debug::INFO) << "Index table: fill\n";
+    if (isProfile == false) {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (size_t range = 0; range < numRanges; range++) {
+            for (size_t block = 0; block < numBlocks; block++) {
+                std::vector<IndexEntryLocalTmp> &bucket = buckets[block * numRanges + range];
+                indexTable->addKmers(bucket.data(), bucket.size());
+                std::vector<IndexEntryLocalTmp>().swap(bucket);
+            }
+        }
+        delete[] buckets;
+        if (idScoreLookup != NULL) {
+            delete[] idScoreLookup;
+        }
+        indexTable->revertPointer();
+        return;
+    }
+
+    Debug::Progress progress2(dbTo-dbFrom);
     #pragma omp parallel
     {
         unsigned int thread_idx = 0;
@@ -221,11 +291,8 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
         Indexer idxer(static_cast<unsigned int>(indexTable->getAlphabetSize()), seq->getKmerSize());
         IndexEntryLocalTmp *buffer = static_cast<IndexEntryLocalTmp *>(malloc( seq->getMaxLen() * sizeof(IndexEntryLocalTmp)));
         size_t bufferSize = seq->getMaxLen();
-        KmerGenerator *generator = NULL;
-        if (isProfile) {
-            generator = new KmerGenerator(seq->getKmerSize(), indexTable->getAlphabetSize(), kmerThr);
-            generator->setDivideStrategy(s.profile_matrix);
-        }
+        KmerGenerator *generator = new KmerGenerator(seq->getKmerSize(), indexTable->getAlphabetSize(), kmerThr);
+        generator->setDivideStrategy(s.profile_matrix);
 
         #pragma omp for schedule(dynamic, 100)
         for (size_t id = dbFrom; id < dbTo; id++) {
@@ -233,18 +300,11 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
             progress2.updateProgress();
 
             unsigned int qKey = dbr->getDbKey(id);
-            if (isProfile) {
-                s.mapSequence(id - dbFrom, qKey, dbr->getData(id, thread_idx), dbr->getSeqLen(id));
-                indexTable->addSimilarSequence(&s, generator, &buffer, bufferSize, &idxer);
-            } else {
-                s.mapSequence(id - dbFrom, qKey, sequenceLookup->getSequence(id - dbFrom));
-                indexTable->addSequence(&s, &idxer, &buffer, bufferSize, kmerThr, idScoreLookup);
-            }
+            s.mapSequence(id - dbFrom, qKey, dbr->getData(id, thread_idx), dbr->getSeqLen(id));
+            indexTable->addSimilarSequence(&s, generator, &buffer, bufferSize, &idxer);
         }
 
-        if (generator != NULL) {
-            delete generator;
-        }
+        delete generator;
 
         free(buffer);
     }
@@ -17,6 +17,7 @@
 #include "KmerGenerator.h"
 #include "Parameters.h"
 #include "FastSort.h"
+#include "PageAllocator.h"
 #include <stdlib.h>
 #include <algorithm>
 
@@ -69,7 +70,7 @@ public:
               kmerSize(kmerSize), externalData(externalData), tableEntriesNum(0), size(0),
               indexer(new Indexer(alphabetSize, kmerSize)), entries(NULL), offsets(NULL) {
         if (externalData == false) {
-            offsets = new(std::nothrow) size_t[tableSize + 1];
+            offsets = PageAllocator::allocateArray<size_t>(tableSize + 1);
             Util::checkAllocation(offsets, "Can not allocate entries memory in IndexTable");
             memset(offsets, 0, (tableSize + 1) * sizeof(size_t));
         }
@@ -83,11 +84,11 @@ public:
     void deleteEntries() {
         if (externalData == false) {
             if (entries != NULL) {
-                delete[] entries;
+                PageAllocator::free(entries);
                 entries = NULL;
             }
             if (offsets != NULL) {
-                delete[] offsets;
+                PageAllocator::free(offsets);
                 offsets = NULL;
             }
         }
@@ -126,49 +127,6 @@ public:
         return countUniqKmer;
     }
 
-    // count k-mers in the sequence, so enough memory for the sequence lists can be allocated in the end
-    size_t addKmerCount(Sequence *s, Indexer *idxer, unsigned int *seqKmerPosBuffer,
-                        int threshold, char *diagonalScore) {
-        s->resetCurrPos();
-        size_t countKmer = 0;
-        bool removeX = (Parameters::isEqualDbtype(s->getSequenceType(), Parameters::DBTYPE_NUCLEOTIDES) ||
-                        Parameters::isEqualDbtype(s->getSequenceType(), Parameters::DBTYPE_AMINO_ACIDS));
-        while(s->hasNextKmer()){
-            const unsigned char * kmer = s->nextKmer();
-            if(removeX && s->kmerContainsX()){
-                continue;
-            }
-            if(threshold > 0){
-                int score = 0;
-                for(int pos = 0; pos < kmerSize; pos++){
-                    score += diagonalScore[kmer[pos]];
-                }
-                if(score < threshold){
-                    continue;
-                }
-            }
-            unsigned int kmerIdx = idxer->int2index(kmer, 0, kmerSize);
-            seqKmerPosBuffer[countKmer] = kmerIdx;
-            countKmer++;
-        }
-        if(countKmer > 1){
-            SORT_SERIAL(seqKmerPosBuffer, seqKmerPosBuffer + countKmer);
-        }
-        size_t countUniqKmer = 0;
-        unsigned int prevKmerIdx = UINT_MAX;
-        for(size_t i = 0; i < countKmer; i++){
-            unsigned int kmerIdx = seqKmerPosBuffer[i];
-            if(prevKmerIdx != kmerIdx){
-                //table[kmerIdx] += 1;
-                // size increases by one
-                __sync_fetch_and_add(&(offsets[kmerIdx]), 1);
-                countUniqKmer++;
-            }
-            prevKmerIdx = kmerIdx;
-        }
-        return countUniqKmer;
-    }
-
     // get list of DB sequences containing this k-mer
     inline IndexEntryLocal *getDBSeqList(size_t kmer, size_t *matchedListSize) {
         const ptrdiff_t diff = offsets[kmer + 1] - offsets[kmer];
@@ -176,6 +134,16 @@ public:
         return (entries + offsets[kmer]);
     }
 
+    // start loading the list bounds of a k-mer that is looked up soon
+    inline void prefetchOffsets(size_t kmer) {
+        PREFETCH(offsets + kmer);
+    }
+
+    // start loading the first entries of a k-mer list, the offsets should already be in cache
+    inline void prefetchDBSeqList(size_t kmer) {
+        PREFETCH(entries + offsets[kmer]);
+    }
+
     void sortDBSeqLists() {
         #pragma omp parallel for
         for (size_t i = 0; i < tableSize; i++) {
@@ -209,7 +177,7 @@ public:
         this->size = dbSize; // amount of sequences added
 
         // allocate memory for the sequence id lists
-        entries = new(std::nothrow) IndexEntryLocal[tableEntriesNum];
+        entries = PageAllocator::allocateArray<IndexEntryLocal>(tableEntriesNum);
         Util::checkAllocation(entries, "Can not allocate entries memory in IndexTable::initMemory");
     }
 
@@ -238,7 +206,7 @@ public:
         this->tableEntriesNum = tableEntriesNum;
         this->size = sequenceCount;
 
-        this->entries = new(std::nothrow) IndexEntryLocal[tableEntriesNum];
+        this->entries = PageAllocator::allocateArray<IndexEntryLocal>(tableEntriesNum);
         Util::checkAllocation(entries, "Can not allocate " + SSTR(tableEntriesNum * sizeof(IndexEntryLocal)) + " bytes for entries in IndexTable::initMemory");
         memcpy(this->entries, entries, tableEntriesNum * sizeof(IndexEntryLocal));
 
@@ -337,22 +305,21 @@ public:
         }
     }
 
-    // add k-mers of the sequence to the index table
-    void addSequence (Sequence* s, Indexer * idxer,
-                      IndexEntryLocalTmp ** buffer, size_t bufferSize,
-                      int threshold, char * diagonalScore){
-        // iterate over all k-mers of the sequence and add the id of s to the sequence list of the k-mer (tableDummy)
+    // extract the k-mers of the sequence into buffer (needs space for one entry per position),
+    // each k-mer is kept once with its first position, the result is sorted by k-mer
+    size_t extractUniqueKmers(Sequence *s, Indexer *idxer, IndexEntryLocalTmp *buffer,
+                              int threshold, char *diagonalScore) {
         s->resetCurrPos();
         idxer->reset();
         size_t kmerPos = 0;
         bool removeX = (Parameters::isEqualDbtype(s->getSequenceType(), Parameters::DBTYPE_NUCLEOTIDES) ||
                         Parameters::isEqualDbtype(s->getSequenceType(), Parameters::DBTYPE_AMINO_ACIDS));
-        while (s->hasNextKmer()){
-            const unsigned char * kmer = s->nextKmer();
-            if(removeX && s->kmerContainsX()){
+        while (s->hasNextKmer()) {
+            const unsigned char *kmer = s->nextKmer();
+            if (removeX && s->kmerContainsX()) {
                 continue;
             }
-            if(threshold > 0) {
+            if (threshold > 0) {
                 int score = 0;
                 for (int pos = 0; pos < kmerSize; pos++) {
                     score += diagonalScore[kmer[pos]];
@@ -361,35 +328,43 @@ public:
                     continue;
                 }
             }
-            unsigned int kmerIdx = idxer->int2index(kmer, 0, kmerSize);
-            // if region got masked do not add kmer
-            if (offsets[kmerIdx + 1] - offsets[kmerIdx] == 0)
-                continue;
-
-            (*buffer)[kmerPos].kmer = kmerIdx;
-            (*buffer)[kmerPos].seqId      = s->getId();
-            (*buffer)[kmerPos].position_j = s->getCurrentPosition();
+            buffer[kmerPos].kmer = idxer->int2index(kmer, 0, kmerSize);
+            buffer[kmerPos].seqId = s->getId();
+            buffer[kmerPos].position_j = s->getCurrentPosition();
             kmerPos++;
-            if(kmerPos >= bufferSize){
-                *buffer = static_cast<IndexEntryLocalTmp*>(realloc(*buffer, sizeof(IndexEntryLocalTmp) * bufferSize*2));
-                bufferSize = bufferSize*2;
-            }
         }
 
-        if(kmerPos>1){
-            SORT_SERIAL(*buffer, *buffer+kmerPos, IndexEntryLocalTmp::comapreByIdAndPos);
+        if (kmerPos > 1) {
+            SORT_SERIAL(buffer, buffer + kmerPos, IndexEntryLocalTmp::comapreByIdAndPos);
         }
 
+        size_t uniqueKmers = 0;
         unsigned int prevKmer = UINT_MAX;
-        for(size_t pos = 0; pos < kmerPos; pos++){
-            unsigned int kmerIdx = (*buffer)[pos].kmer;
-            if(kmerIdx != prevKmer){
-                size_t offset = __sync_fetch_and_add(&(offsets[kmerIdx]), 1);
-                IndexEntryLocal *entry = &entries[offset];
-                entry->seqId      = (*buffer)[pos].seqId;
-                entry->position_j = (*buffer)[pos].position_j;
+        for (size_t pos = 0; pos < kmerPos; pos++) {
+            if (buffer[pos].kmer != prevKmer) {
+                buffer[uniqueKmers] = buffer[pos];
+                uniqueKmers++;
             }
-            prevKmer = kmerIdx;
+            prevKmer = buffer[pos].kmer;
+        }
+        return uniqueKmers;
+    }
+
+    // count extracted k-mers without atomics
+    // concurrent callers have to pass entries of disjoint k-mer ranges
+    void addKmerCount(const IndexEntryLocalTmp *kmers, size_t kmerCount) {
+        for (size_t i = 0; i < kmerCount; i++) {
+            offsets[kmers[i].kmer] += 1;
+        }
+    }
+
+    // add extracted k-mers to the sequence lists without atomics
+    // concurrent callers have to pass entries of disjoint k-mer ranges, each range in increasing seqId order
+    void addKmers(const IndexEntryLocalTmp *kmers, size_t kmerCount) {
+        for (size_t i = 0; i < kmerCount; i++) {
+            IndexEntryLocal *entry = &entries[offsets[kmers[i].kmer]++];
+            entry->seqId      = kmers[i].seqId;
+            entry->position_j = kmers[i].position_j;
         }
     }
 
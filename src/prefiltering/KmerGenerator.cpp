@@ -41,6 +41,12 @@ void KmerGenerator::setDivideStrategy(ScoreMatrix ** one){
     initDataStructure();
 }
 
+void KmerGenerator::updateProfileMatrix(ScoreMatrix ** one){
+    for(size_t i = 0; i < kmerSize; i++){
+        this->matrixLookup[i] = one[i];
+    }
+}
+
 void KmerGenerator::setDivideStrategy(ScoreMatrix * three, ScoreMatrix * two){
     const size_t threeDivideCount = this->kmerSize / 3;
 
@@ -101,8 +107,8 @@ void KmerGenerator::initDataStructure(){
     outputIndexArray = new size_t *[2];
 
     for(size_t i = 0 ; i < 2; i++){
-        outputScoreArray[i] = (short *)  mem_align(ALIGN_INT, MAX_KMER_RESULT_SIZE * sizeof(short));
-        outputIndexArray[i] = (size_t *) mem_align(ALIGN_INT, MAX_KMER_RESULT_SIZE * sizeof(size_t));
+        outputScoreArray[i] = (short *)  mem_align(ALIGN_INT, (MAX_KMER_RESULT_SIZE + OUTPUT_PADDING) * sizeof(short));
+        outputIndexArray[i] = (size_t *) mem_align(ALIGN_INT, (MAX_KMER_RESULT_SIZE + OUTPUT_PADDING) * sizeof(size_t));
     }
 }
 
@@ -158,7 +164,8 @@ std::pair<size_t *, size_t> KmerGenerator::generateKmerList(const unsigned char
                                                    outputIndexArray[i%2],
                                                    cutoff1,
                                                    possibleRest[i+1],
-                                                   stepMultiplicator[i+1]);
+                                                   stepMultiplicator[i+1],
+                                                   i + 2 < this->divideStepCount);
 
         inputScoreArray = this->outputScoreArray[i%2];
         inputIndexArray = this->outputIndexArray[i%2];
@@ -196,7 +203,16 @@ size_t KmerGenerator::calculateArrayProduct(const short        * __restrict scor
                                             size_t             * __restrict outputIndexArray,
                                             const short cutoff1,
                                             const short possibleRest,
-                                            const size_t pow){
+                                            const size_t pow,
+                                            const bool storeScores){
+    const size_t scoresPerVector = VECSIZE_INT * 2;
+    const size_t indicesPerVector = VECSIZE_INT / 2;
+    if (scaledIndexArray.size() < array2Size) {
+        scaledIndexArray.resize(array2Size);
+    }
+    // the k-mer index part of array 2 does not depend on i, it is scaled once for all rows
+    size_t * __restrict scaledIndex = scaledIndexArray.data();
+    size_t scaledSize = 0;
     size_t counter=0;
     for(size_t i = 0 ; i< array1Size;i++){
         const short score_i = scoreArray1[i];
@@ -204,17 +220,46 @@ size_t KmerGenerator::calculateArrayProduct(const short        * __restrict scor
         if(score_i < cutoff1 )
             break;
         const short cutoff2=this->threshold-score_i-possibleRest;
-        for(size_t j = 0; j < array2Size && (counter+1 < (int) MAX_KMER_RESULT_SIZE) && (scoreArray2[j] >= cutoff2); j++){
-            const short score_j = scoreArray2[j];
-            const size_t kmer_j = indexArray2[j];
-            outputScoreArray[counter]=score_i+score_j;
-            outputIndexArray[counter]=kmer_i+(kmer_j*pow);
-            counter++;
+
+        // array 2 is sorted, the row ends in the first vector that contains an element below cutoff2.
+        // Whole vectors are written, the elements behind the row end are overwritten by the next row
+        // or lie in the padding of the output arrays
+        short * __restrict rowScores = outputScoreArray + counter;
+        size_t * __restrict rowIndices = outputIndexArray + counter;
+        const simd_int cutoff2Vec = simdi16_set(cutoff2 - 1);
+        const simd_int scoreVec = simdi16_set(score_i);
+        const simd_int kmerVec = simdi64_set(kmer_i);
+        size_t j = 0;
+        bool rowEnded = false;
+        while (j + scoresPerVector <= array2Size && counter + j < MAX_KMER_RESULT_SIZE) {
+            for (; scaledSize < j + scoresPerVector; scaledSize++) {
+                scaledIndex[scaledSize] = static_cast<size_t>(indexArray2[scaledSize]) * pow;
+            }
+            const simd_int scores = simdi_loadu((const simd_int *) (scoreArray2 + j));
+            if (storeScores) {
+                simdi_storeu((simd_int *) (rowScores + j), simdi16_add(scoreVec, scores));
+            }
+            for (size_t k = 0; k < scoresPerVector; k += indicesPerVector) {
+                const simd_int indices = simdi_loadu((const simd_int *) (scaledIndex + j + k));
+                simdi_storeu((simd_int *) (rowIndices + j + k), simdi64_add(kmerVec, indices));
+            }
+            // two mask bits per 16 bit element
+            const unsigned int passed = __builtin_popcount(static_cast<unsigned int>(simdi8_movemask(simdi16_gt(scores, cutoff2Vec)))) / 2;
+            j += passed;
+            if (passed < scoresPerVector) {
+                rowEnded = true;
+                break;
+            }
         }
-        if(counter+1 >= (int) MAX_KMER_RESULT_SIZE){
+        for (; rowEnded == false && j < array2Size && counter + j < MAX_KMER_RESULT_SIZE && scoreArray2[j] >= cutoff2; j++) {
+            rowScores[j] = score_i + scoreArray2[j];
+            rowIndices[j] = kmer_i + static_cast<size_t>(indexArray2[j]) * pow;
+        }
+        counter += std::min(j, MAX_KMER_RESULT_SIZE - 1 - counter);
+
+        if(counter+1 >= MAX_KMER_RESULT_SIZE){
             return counter;
         }
     }
     return counter;
 }
-
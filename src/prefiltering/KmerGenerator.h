@@ -23,10 +23,15 @@ class KmerGenerator
          fill up the divide step and calls init_result_list */
         void setDivideStrategy(ScoreMatrix ** one);
 
+        /* switches to the profile matrices of another sequence without reallocating,
+         the divide strategy (1) has to be set before */
+        void updateProfileMatrix(ScoreMatrix ** one);
+
 	    void setThreshold(short threshold);
     private:
     
-        /*creates the product between two arrays and write it to the output array */
+        /*creates the product between two arrays and write it to the output array,
+         the scores of the last product are not needed (storeScores) */
         size_t calculateArrayProduct(const short        * __restrict scoreArray1,
                                   const size_t       * __restrict indexArray1,
                                   const size_t array1Size,
@@ -37,12 +42,15 @@ class KmerGenerator
                                   size_t             * __restrict outputIndexArray,
                                   const short cutoff1,
                                   const short possibleRest,
-                                  const size_t pow);
+                                  const size_t pow,
+                                  const bool storeScores);
     
     
         /* maximum return values */
         /* 48   MB */
         const static size_t MAX_KMER_RESULT_SIZE = 262144*32;
+        /* calculateArrayProduct writes up to one vector of shorts behind the last k-mer */
+        const static size_t OUTPUT_PADDING = 64;
         /* min score  */
         short threshold;
         /* size of kmer  */
@@ -59,6 +67,8 @@ class KmerGenerator
         ScoreMatrix  ** matrixLookup;
         short        ** outputScoreArray;
         size_t       ** outputIndexArray;
+        /* k-mer index part of the second array of calculateArrayProduct */
+        std::vector<size_t> scaledIndexArray;
 
 
         /* init the output vectors for the kmer calculation*/
@@ -13,7 +13,11 @@
 #include "Parameters.h"
 #include "MemoryMapped.h"
 #include "FastSort.h"
+#include "Metrics.h"
+#include "PageAllocator.h"
 #include <sys/mman.h>
+#include <unistd.h>
+#include <functional>
 
 #ifdef OPENMP
 #include <omp.h>
@@ -50,8 +54,13 @@ Prefiltering::Prefiltering(const std::string &queryDB,
         aaBiasCorrection(par.compBiasCorrection != 0),
         covThr(par.covThr), covMode(par.covMode), includeIdentical(par.includeIdentity),
         preloadMode(par.preloadMode),
-        threads(static_cast<unsigned int>(par.threads)), compressed(par.compressed) {
+        threads(static_cast<unsigned int>(par.threads)), compressed(par.compressed),
+        splitPipeline(par.splitPipeline), mpiDynamic(par.mpiDynamic),
+        queryBatchSize(static_cast<unsigned int>(par.queryBatchSize)), queryCacheLimit(par.queryCacheLimit) {
     sameQTDB = isSameQTDB();
+    nextIndexTable = NULL;
+    nextSequenceLookup = NULL;
+    profileCache = NULL;
 
     // init the substitution matrices
     switch (querySeqType & 0x7FFFFFFF) {
@@ -193,6 +202,42 @@ Prefiltering::Prefiltering(const std::string &queryDB,
                threads, templateDBIsIndex, memoryLimit, qdbr->getSize(),
                maxResListLen, kmerSize, splits, splitMode);
 
+#ifdef HAVE_MPI
+    // more query splits than ranks give the dynamic scheduling room to balance the ranks
+    if (mpiDynamic && splitMode == Parameters::QUERY_DB_SPLIT && par.split == 0) {
+        splits = static_cast<int>(std::min(qdbr->getSize(), static_cast<size_t>(std::max(MMseqsMPI::numProc, 1)) * MMseqsMPI::CHUNKS_PER_RANK));
+    }
+#endif
+
+    if (splitPipeline) {
+        if (splitMode != Parameters::TARGET_DB_SPLIT || splits < 2 || templateDBIsIndex == true || threads < 2) {
+            splitPipeline = false;
+        } else {
+            // the index table of the current and the next split are in memory at the same time
+            size_t memoryNeededPerSplit = estimateMemoryConsumption(splits, tdbr->getSize(), tdbr->getAminoAcidDBSize(), maxResListLen,
+                                                                    alphabetSize - 1, kmerSize, querySeqType, threads,
+                                                                    usesKmerBuckets(targetSeqType, templateDBIsIndex));
+            if (2 * memoryNeededPerSplit > 0.9 * memoryLimit) {
+                Debug(Debug::WARNING) << "Not enough memory to keep two target splits in memory. Increase --split to pipeline the splits.\n";
+                splitPipeline = false;
+            }
+        }
+    }
+
+    // the query cache only gets the memory that is left over by the index tables of the target splits
+    if (splitMode == Parameters::TARGET_DB_SPLIT && splits > 1 && queryCacheLimit > 0) {
+        size_t memoryNeededPerSplit = estimateMemoryConsumption(splits, tdbr->getSize(), tdbr->getAminoAcidDBSize(), maxResListLen,
+                                                                alphabetSize - 1, kmerSize, querySeqType, threads,
+                                                                usesKmerBuckets(targetSeqType, templateDBIsIndex));
+        const size_t memoryNeeded = (splitPipeline ? 2 : 1) * memoryNeededPerSplit;
+        const size_t memoryAvailable = static_cast<size_t>(0.9 * memoryLimit);
+        queryCacheLimit = std::min(queryCacheLimit, (memoryAvailable > memoryNeeded) ? memoryAvailable - memoryNeeded : 0);
+        // the entry pointers are allocated for all queries, they should only take a small part of the cache
+        if (QueryProfileCache::getIndexSize(qdbr->getSize()) > queryCacheLimit / 4) {
+            queryCacheLimit = 0;
+        }
+    }
+
     if(Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_NUCLEOTIDES) == false){
         const bool isProfileSearch = Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_HMM_PROFILE) ||
                                      Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_HMM_PROFILE);
@@ -236,6 +281,18 @@ Prefiltering::~Prefiltering() {
         delete sequenceLookup;
     }
 
+    if (nextIndexTable != NULL) {
+        delete nextIndexTable;
+    }
+
+    if (nextSequenceLookup != NULL) {
+        delete nextSequenceLookup;
+    }
+
+    if (profileCache != NULL) {
+        delete profileCache;
+    }
+
     tdbr->close();
     delete tdbr;
 
@@ -258,9 +315,11 @@ Prefiltering::~Prefiltering() {
 void Prefiltering::setupSplit(DBReader<unsigned int>& tdbr, const int alphabetSize, const unsigned int querySeqTyp, const int threads,
                               const bool templateDBIsIndex, const size_t memoryLimit, const size_t qDbSize,
                               size_t &maxResListLen, int &kmerSize, int &split, int &splitMode) {
+    const bool kmerBuckets = usesKmerBuckets(tdbr.getDbtype(), templateDBIsIndex);
     size_t memoryNeeded = estimateMemoryConsumption(1, tdbr.getSize(), tdbr.getAminoAcidDBSize(), maxResListLen, alphabetSize,
                                                     kmerSize == 0 ? // if auto detect kmerSize
-                                                    IndexTable::computeKmerSize(tdbr.getAminoAcidDBSize()) : kmerSize, querySeqTyp, threads);
+                                                    IndexTable::computeKmerSize(tdbr.getAminoAcidDBSize()) : kmerSize, querySeqTyp, threads,
+                                                    kmerBuckets);
 
     int optimalSplitMode = Parameters::TARGET_DB_SPLIT;
     if (memoryNeeded > 0.9 * memoryLimit) {
@@ -293,7 +352,7 @@ void Prefiltering::setupSplit(DBReader<unsigned int>& tdbr, const int alphabetSi
     if (memoryNeeded > 0.9 * memoryLimit) {
         // memory is not enough to compute everything at once
         //TODO add PROFILE_STATE (just 6-mers)
-        std::pair<int, int> splitSettings = Prefiltering::optimizeSplit(memoryLimit, &tdbr, alphabetSize, kmerSize, querySeqTyp, threads);
+        std::pair<int, int> splitSettings = Prefiltering::optimizeSplit(memoryLimit, &tdbr, alphabetSize, kmerSize, querySeqTyp, threads, kmerBuckets);
         if (splitSettings.second == -1) {
             Debug(Debug::ERROR) << "Cannot fit databases into " << ByteParser::format(memoryLimit) << ". Please use a computer with more main memory.\n";
             EXIT(EXIT_FAILURE);
@@ -350,7 +409,8 @@ void Prefiltering::setupSplit(DBReader<unsigned int>& tdbr, const int alphabetSi
     }
 
     size_t memoryNeededPerSplit = estimateMemoryConsumption((splitMode == Parameters::TARGET_DB_SPLIT) ? split : 1, tdbr.getSize(),
-                                                            tdbr.getAminoAcidDBSize(), maxResListLen, alphabetSize, kmerSize, querySeqTyp, threads);
+                                                            tdbr.getAminoAcidDBSize(), maxResListLen, alphabetSize, kmerSize, querySeqTyp, threads,
+                                                            kmerBuckets);
     Debug(Debug::INFO) << "Estimated memory consumption: " << ByteParser::format(memoryNeededPerSplit) << "\n";
     if (memoryNeededPerSplit > 0.9 * memoryLimit) {
         Debug(Debug::WARNING) << "Process needs more than " << ByteParser::format(memoryLimit) << " main memory.\n" <<
@@ -496,44 +556,108 @@ ScoreMatrix Prefiltering::getScoreMatrix(const BaseMatrix& matrix, const size_t
 
 }
 
+void Prefiltering::replicateIndexTable() {
+    std::vector<int> nodes = PageAllocator::getNumaNodes();
+    if (nodes.size() < 2 || indexTable == NULL) {
+        return;
+    }
+
+    size_t replicaSize = indexTable->getTableEntriesNum() * sizeof(IndexEntryLocal) + (indexTable->getTableSize() + 1) * sizeof(size_t);
+    if (sequenceLookup != NULL) {
+        replicaSize += sequenceLookup->getDataSize() + 1 + (sequenceLookup->getSequenceCount() + 1) * sizeof(size_t);
+    }
+    size_t freeMemory = SIZE_MAX;
+#ifdef _SC_AVPHYS_PAGES
+    freeMemory = static_cast<size_t>(sysconf(_SC_AVPHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    // keep some room for the result lists of the threads
+    if (replicaSize * nodes.size() > freeMemory * 0.9) {
+        Debug(Debug::WARNING) << "Not enough free memory to replicate the index table on " << nodes.size() << " NUMA nodes. "
+                              << "Using the interleaved index table instead\n";
+        return;
+    }
+
+    Debug(Debug::INFO) << "Replicate index table on " << nodes.size() << " NUMA nodes\n";
+    Timer timer;
+    replicaNodes = nodes;
+    indexReplicas.resize(nodes.size(), NULL);
+    lookupReplicas.resize(nodes.size(), NULL);
+#pragma omp parallel for schedule(static, 1) num_threads(nodes.size())
+    for (size_t i = 0; i < nodes.size(); i++) {
+        PageAllocator::setThreadNode(nodes[i]);
+        IndexTable *table = new IndexTable(indexTable->getAlphabetSize(), indexTable->getKmerSize(), false);
+        table->initTableByExternalDataCopy(indexTable->getSize(), indexTable->getTableEntriesNum(),
+                                           indexTable->getEntries(), indexTable->getOffsets());
+        indexReplicas[i] = table;
+        if (sequenceLookup != NULL) {
+            SequenceLookup *lookup = new SequenceLookup(sequenceLookup->getSequenceCount(), sequenceLookup->getDataSize());
+            lookup->initLookupByExternalDataCopy(const_cast<char *>(sequenceLookup->getData()), sequenceLookup->getOffsets());
+            lookupReplicas[i] = lookup;
+        }
+        PageAllocator::setThreadNode(-1);
+    }
+    Debug(Debug::INFO) << "Time for index table replication: " << timer.lap() << "\n";
+}
+
+void Prefiltering::deleteIndexReplicas() {
+    for (size_t i = 0; i < indexReplicas.size(); i++) {
+        delete indexReplicas[i];
+        if (lookupReplicas[i] != NULL) {
+            delete lookupReplicas[i];
+        }
+    }
+    indexReplicas.clear();
+    lookupReplicas.clear();
+    replicaNodes.clear();
+}
+
 void Prefiltering::getIndexTable(int split, size_t dbFrom, size_t dbSize) {
     if (templateDBIsIndex == true) {
+        Metrics::startPhase("index_load");
         indexTable = PrefilteringIndexReader::getIndexTable(split, tidxdbr, preloadMode);
         // only the ungapped alignment needs the sequence lookup, we can save quite some memory here
         if (diagonalScoring) {
             sequenceLookup = PrefilteringIndexReader::getSequenceLookup(split, tidxdbr, preloadMode);
         }
+        Metrics::stopPhase("index_load");
     } else {
-        Timer timer;
-
-        Sequence tseq(maxSeqLen, targetSeqType, kmerSubMat, kmerSize, spacedKmer, aaBiasCorrection, true, spacedKmerPattern);
-        int localKmerThr = (Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_HMM_PROFILE) ||
-                            Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_PROFILE_STATE_PROFILE) ||
-                            Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_NUCLEOTIDES) ||
-                            (Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_HMM_PROFILE) == false && takeOnlyBestKmer == true) ) ? 0 : kmerThr;
-
-        // remove X or N for seeding
-        int adjustAlphabetSize = (Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_NUCLEOTIDES) ||
-                                  Parameters::isEqualDbtype(targetSeqType,Parameters::DBTYPE_AMINO_ACIDS))
-                                 ? alphabetSize -1 : alphabetSize;
-        indexTable = new IndexTable(adjustAlphabetSize, kmerSize, false);
-        SequenceLookup **maskedLookup   = maskMode == 1 || maskLowerCaseMode == 1 ? &sequenceLookup : NULL;
-        SequenceLookup **unmaskedLookup = maskMode == 0 ? &sequenceLookup : NULL;
-
-        Debug(Debug::INFO) << "Index table k-mer threshold: " << localKmerThr << " at k-mer size " << kmerSize << " \n";
-        IndexBuilder::fillDatabase(indexTable, maskedLookup, unmaskedLookup, *kmerSubMat,  &tseq, tdbr, dbFrom, dbFrom + dbSize, localKmerThr, maskMode, maskLowerCaseMode);
-
-        // sequenceLookup has to be temporarily present to speed up masking
-        // afterwards its not needed anymore without diagonal scoring
-        if (diagonalScoring == false) {
-            delete sequenceLookup;
-            sequenceLookup = NULL;
-        }
+        buildIndexTable(tdbr, dbFrom, dbSize, &indexTable, &sequenceLookup);
+    }
+}
 
-        indexTable->printStatistics(kmerSubMat->num2aa);
-        tdbr->remapData();
-        Debug(Debug::INFO) << "Time for index table init: " << timer.lap() << "\n";
+void Prefiltering::buildIndexTable(DBReader<unsigned int> *dbr, size_t dbFrom, size_t dbSize,
+                                   IndexTable **table, SequenceLookup **lookup) {
+    Timer timer;
+    Metrics::startPhase("index_build");
+
+    Sequence tseq(maxSeqLen, targetSeqType, kmerSubMat, kmerSize, spacedKmer, aaBiasCorrection, true, spacedKmerPattern);
+    int localKmerThr = (Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_HMM_PROFILE) ||
+                        Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_PROFILE_STATE_PROFILE) ||
+                        Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_NUCLEOTIDES) ||
+                        (Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_HMM_PROFILE) == false && takeOnlyBestKmer == true) ) ? 0 : kmerThr;
+
+    // remove X or N for seeding
+    int adjustAlphabetSize = (Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_NUCLEOTIDES) ||
+                              Parameters::isEqualDbtype(targetSeqType,Parameters::DBTYPE_AMINO_ACIDS))
+                             ? alphabetSize -1 : alphabetSize;
+    *table = new IndexTable(adjustAlphabetSize, kmerSize, false);
+    SequenceLookup **maskedLookup   = maskMode == 1 || maskLowerCaseMode == 1 ? lookup : NULL;
+    SequenceLookup **unmaskedLookup = maskMode == 0 ? lookup : NULL;
+
+    Debug(Debug::INFO) << "Index table k-mer threshold: " << localKmerThr << " at k-mer size " << kmerSize << " \n";
+    IndexBuilder::fillDatabase(*table, maskedLookup, unmaskedLookup, *kmerSubMat,  &tseq, dbr, dbFrom, dbFrom + dbSize, localKmerThr, maskMode, maskLowerCaseMode);
+
+    // sequenceLookup has to be temporarily present to speed up masking
+    // afterwards its not needed anymore without diagonal scoring
+    if (diagonalScoring == false) {
+        delete *lookup;
+        *lookup = NULL;
     }
+
+    (*table)->printStatistics(kmerSubMat->num2aa);
+    dbr->remapData();
+    Metrics::stopPhase("index_build");
+    Debug(Debug::INFO) << "Time for index table init: " << timer.lap() << "\n";
 }
 
 bool Prefiltering::isSameQTDB() {
@@ -563,22 +687,6 @@ void Prefiltering::runMpiSplits(const std::string &resultDB, const std::string &
             compressed = false;
     }
 
-    // if split size is great than nodes than we have to
-    // distribute all splits equally over all nodes
-    unsigned int * splitCntPerProc = new unsigned int[MMseqsMPI::numProc];
-    memset(splitCntPerProc, 0, sizeof(unsigned int) * MMseqsMPI::numProc);
-    for(int i = 0; i < splits; i++){
-        splitCntPerProc[i % MMseqsMPI::numProc] += 1;
-    }
-
-    size_t fromSplit = 0;
-    for(int i = 0; i < MMseqsMPI::rank; i++){
-        fromSplit += splitCntPerProc[i];
-    }
-
-    size_t splitCount = splitCntPerProc[MMseqsMPI::rank];
-    delete[] splitCntPerProc;
-
     // setting names in case of localTmp path
     std::string procTmpResultDB = localTmpPath;
     std::string procTmpResultDBIndex = localTmpPath;
@@ -600,9 +708,64 @@ void Prefiltering::runMpiSplits(const std::string &resultDB, const std::string &
         }
     }
 
-    std::pair<std::string, std::string> result = Util::createTmpFileNames(procTmpResultDB, procTmpResultDBIndex, MMseqsMPI::rank + runRandomId);
     bool merge = (splitMode == Parameters::QUERY_DB_SPLIT);
 
+    if (mpiDynamic) {
+        // every rank requests the next split as soon as it is done with its current one
+        std::vector<int> hasResult(splits, 0);
+        {
+            MMseqsMPI::WorkQueue queue(splits);
+            size_t split;
+            while (queue.next(&split)) {
+                std::pair<std::string, std::string> result = Util::createTmpFileNames(procTmpResultDB, procTmpResultDBIndex, split + runRandomId);
+                hasResult[split] = runSplit(result.first, result.second, split, merge, false) == true ? 1 : 0;
+                if (localTmpPath != "") {
+                    std::pair<std::string, std::string> resultShared = Util::createTmpFileNames(resultDB, resultDBIndex, split);
+                    DBReader<unsigned int>::moveDb(result.first, resultShared.first);
+                }
+            }
+        }
+
+        std::vector<int> results(splits, 0);
+        MPI_Reduce(hasResult.data(), results.data(), splits, MPI_INT, MPI_MAX, MMseqsMPI::MASTER, MPI_COMM_WORLD);
+        if (MMseqsMPI::isMaster()) {
+            std::vector<std::pair<std::string, std::string>> splitFiles;
+            for (int i = 0; i < splits; ++i) {
+                if (results[i] == 1) {
+                    splitFiles.push_back(Util::createTmpFileNames(resultDB, resultDBIndex, i));
+                }
+            }
+
+            if (splitFiles.size() > 0) {
+                Metrics::startPhase("merging");
+                mergePrefilterSplits(resultDB, resultDBIndex, splitFiles);
+                Metrics::stopPhase("merging");
+            } else {
+                Debug(Debug::ERROR) << "Aborting. No results were computed!\n";
+                EXIT(EXIT_FAILURE);
+            }
+        }
+        return;
+    }
+
+    // if split size is great than nodes than we have to
+    // distribute all splits equally over all nodes
+    unsigned int * splitCntPerProc = new unsigned int[MMseqsMPI::numProc];
+    memset(splitCntPerProc, 0, sizeof(unsigned int) * MMseqsMPI::numProc);
+    for(int i = 0; i < splits; i++){
+        splitCntPerProc[i % MMseqsMPI::numProc] += 1;
+    }
+
+    size_t fromSplit = 0;
+    for(int i = 0; i < MMseqsMPI::rank; i++){
+        fromSplit += splitCntPerProc[i];
+    }
+
+    size_t splitCount = splitCntPerProc[MMseqsMPI::rank];
+    delete[] splitCntPerProc;
+
+    std::pair<std::string, std::string> result = Util::createTmpFileNames(procTmpResultDB, procTmpResultDBIndex, MMseqsMPI::rank + runRandomId);
+
     int hasResult = runSplits(result.first, result.second, fromSplit, splitCount, merge) == true ? 1 : 0;
 
     if (localTmpPath != "") {
@@ -631,7 +794,9 @@ void Prefiltering::runMpiSplits(const std::string &resultDB, const std::string &
 
         if (splitFiles.size() > 0) {
             // merge output databases
+            Metrics::startPhase("merging");
             mergePrefilterSplits(resultDB, resultDBIndex, splitFiles);
+            Metrics::stopPhase("merging");
         } else {
             Debug(Debug::ERROR) << "Aborting. No results were computed!\n";
             EXIT(EXIT_FAILURE);
@@ -670,12 +835,14 @@ int Prefiltering::runSplits(const std::string &resultDB, const std::string &resu
         std::vector<std::pair<std::string, std::string> > splitFiles;
         for (size_t i = fromSplit; i < (fromSplit + splitProcessCount); i++) {
             std::pair<std::string, std::string> filenamePair = Util::createTmpFileNames(resultDB, resultDBIndex, i);
-            if (runSplit(filenamePair.first.c_str(), filenamePair.second.c_str(), i, merge)) {
+            const bool prepareNextSplit = splitPipeline && (i + 1) < (fromSplit + splitProcessCount);
+            if (runSplit(filenamePair.first.c_str(), filenamePair.second.c_str(), i, merge, prepareNextSplit)) {
                 splitFiles.push_back(filenamePair);
 
             }
         }
         if (splitFiles.size() > 0) {
+            Metrics::startPhase("merging");
             mergePrefilterSplits(resultDB, resultDBIndex, splitFiles);
             if (splitFiles.size() > 1) {
                 DBReader<unsigned int> resultReader(resultDB.c_str(), resultDBIndex.c_str(), threads, DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_DATA);
@@ -690,10 +857,11 @@ int Prefiltering::runSplits(const std::string &resultDB, const std::string &resu
                 DBReader<unsigned int>::removeDb(resultDB);
                 DBReader<unsigned int>::moveDb(tempDb.first, resultDB);
             }
+            Metrics::stopPhase("merging");
             hasResult = true;
         }
     } else if (splitProcessCount == 1) {
-        if (runSplit(resultDB.c_str(), resultDBIndex.c_str(), fromSplit, merge)) {
+        if (runSplit(resultDB.c_str(), resultDBIndex.c_str(), fromSplit, merge, false)) {
             hasResult = true;
         }
     }
@@ -701,7 +869,7 @@ int Prefiltering::runSplits(const std::string &resultDB, const std::string &resu
     return hasResult;
 }
 
-bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resultDBIndex, size_t split, bool merge) {
+bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resultDBIndex, size_t split, bool merge, bool prepareNextSplit) {
     Debug(Debug::INFO) << "Process prefiltering step " << (split + 1) << " of " << splits << "\n\n";
 
     size_t dbFrom = 0;
@@ -726,7 +894,14 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
             sequenceLookup = NULL;
         }
 
-        getIndexTable(split, dbFrom, dbSize);
+        if (nextIndexTable != NULL) {
+            indexTable = nextIndexTable;
+            sequenceLookup = nextSequenceLookup;
+            nextIndexTable = NULL;
+            nextSequenceLookup = NULL;
+        } else {
+            getIndexTable(split, dbFrom, dbSize);
+        }
     } else if (splitMode == Parameters::QUERY_DB_SPLIT) {
         qdbr->decomposeDomainByAminoAcid(split, splits, &queryFrom, &querySize);
         if (querySize == 0) {
@@ -734,9 +909,20 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
         }
     }
 
+    // every target split maps all queries again, keep what can be reused
+    const bool isProfileQuery = Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_HMM_PROFILE);
+    const bool isCachedQuery = isProfileQuery || (aaBiasCorrection && Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_AMINO_ACIDS));
+    if (splitMode == Parameters::TARGET_DB_SPLIT && splits > 1 && queryCacheLimit > 0 && isCachedQuery && profileCache == NULL) {
+        profileCache = new QueryProfileCache(qdbr->getSize(), queryCacheLimit);
+    }
+
     Debug(Debug::INFO) << "k-mer similarity threshold: " << kmerThr << "\n";
+    if (PageAllocator::getNumaMode() == PageAllocator::NUMA_MODE_REPLICATE) {
+        replicateIndexTable();
+    }
 
     double kmersPerPos = 0;
+    double generatedKmers = 0;
     size_t dbMatches = 0;
     size_t doubleMatches = 0;
     size_t querySeqLenSum = 0;
@@ -751,6 +937,40 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
     localThreads = std::min((unsigned int)threads, (unsigned int)querySize);
 #endif
 
+    size_t nextDbFrom = 0;
+    size_t nextDbSize = 0;
+    if (prepareNextSplit) {
+        tdbr->decomposeDomainByAminoAcid(split + 1, splits, &nextDbFrom, &nextDbSize);
+        prepareNextSplit = nextDbSize > 0 && threads > 1;
+    }
+    // a quarter of the threads builds the index table of the next split while the rest searches the current one,
+    // the thread that started the build joins the search once the index table is done
+    unsigned int buildThreads = 0;
+    DBReader<unsigned int> *buildReader = NULL;
+    if (prepareNextSplit) {
+        buildThreads = std::max(1u, threads / 4);
+        localThreads = std::min(threads - buildThreads, (unsigned int)querySize) + 1;
+        // building remaps the data of its reader, the query reader might share the target data
+        buildReader = new DBReader<unsigned int>(targetDB.c_str(), targetDBIndex.c_str(), buildThreads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+        buildReader->open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    }
+
+    // process the queries with the highest expected k-mer matching work first, so that no single
+    // long query is left running at the end of the split. The estimate is the query length in the
+    // first split and the number of database matches of the previous target split afterwards.
+    if (queryCost.empty()) {
+        queryCost.resize(qdbr->getSize());
+        for (size_t id = 0; id < qdbr->getSize(); id++) {
+            queryCost[id] = qdbr->getSeqLen(id);
+        }
+    }
+    std::vector<std::pair<size_t, size_t>> queryOrder;
+    queryOrder.reserve(querySize);
+    for (size_t id = queryFrom; id < queryFrom + querySize; id++) {
+        queryOrder.emplace_back(queryCost[id], id);
+    }
+    SORT_PARALLEL(queryOrder.begin(), queryOrder.end(), std::greater<std::pair<size_t, size_t>>());
+
     DBWriter tmpDbw(resultDB.c_str(), resultDBIndex.c_str(), localThreads, compressed, Parameters::DBTYPE_PREFILTER_RES);
     tmpDbw.open();
 
@@ -766,100 +986,184 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
     Debug(Debug::INFO) << "Starting prefiltering scores calculation (step " << (split + 1) << " of " << splits << ")\n";
     Debug(Debug::INFO) << "Query db start " << (queryFrom + 1) << " to " << queryFrom + querySize << "\n";
     Debug(Debug::INFO) << "Target db start " << (dbFrom + 1) << " to " << dbFrom + dbSize << "\n";
+    if (prepareNextSplit) {
+        Debug(Debug::INFO) << "Index table of step " << (split + 2) << " is built on " << buildThreads << " threads in parallel\n";
+    }
     Debug::Progress progress(querySize);
 
+    // the k-mer matching phase includes the ungapped diagonal scoring, both run per query in the QueryMatcher
+    Metrics::startPhase("kmer_matching");
+#ifdef OPENMP
+    const int maxActiveLevels = omp_get_max_active_levels();
+    if (prepareNextSplit) {
+        omp_set_max_active_levels(2);
+    }
+#endif
+
 #pragma omp parallel num_threads(localThreads)
     {
         unsigned int thread_idx = 0;
 #ifdef OPENMP
         thread_idx = static_cast<unsigned int>(omp_get_thread_num());
 #endif
-        Sequence seq(qdbr->getMaxSeqLen(), querySeqType, kmerSubMat, kmerSize, spacedKmer, aaBiasCorrection, true, spacedKmerPattern);
-        QueryMatcher matcher(indexTable, sequenceLookup, kmerSubMat,  ungappedSubMat,
+        // with --query-batch-size the k-mer lists of a block of queries are matched in one index table sweep
+        const size_t batchSize = std::max(queryBatchSize, 1u);
+        std::vector<Sequence *> querySeqs(batchSize);
+        for (size_t i = 0; i < batchSize; i++) {
+            querySeqs[i] = new Sequence(qdbr->getMaxSeqLen(), querySeqType, kmerSubMat, kmerSize, spacedKmer, aaBiasCorrection, true, spacedKmerPattern);
+        }
+        // with replicas each thread runs on one node and only reads the copy on that node
+        IndexTable *threadIndexTable = indexTable;
+        SequenceLookup *threadSequenceLookup = sequenceLookup;
+        size_t replica = 0;
+        if (indexReplicas.empty() == false) {
+            replica = thread_idx % replicaNodes.size();
+            threadIndexTable = indexReplicas[replica];
+            threadSequenceLookup = lookupReplicas[replica];
+        }
+        QueryMatcher matcher(threadIndexTable, threadSequenceLookup, kmerSubMat,  ungappedSubMat,
                              kmerThr, kmerSize, dbSize, std::max(tdbr->getMaxSeqLen(),qdbr->getMaxSeqLen()), maxResListLen, aaBiasCorrection,
                              diagonalScoring, minDiagScoreThr, takeOnlyBestKmer);
 
-        if (seq.profile_matrix != NULL) {
-            matcher.setProfileMatrix(seq.profile_matrix);
+        if (querySeqs[0]->profile_matrix != NULL) {
+            matcher.setProfileMatrix(querySeqs[0]->profile_matrix);
         } else if (_3merSubMatrix.isValid() && _2merSubMatrix.isValid()) {
             matcher.setSubstitutionMatrix(&_3merSubMatrix, &_2merSubMatrix);
         } else {
             matcher.setSubstitutionMatrix(NULL, NULL);
         }
+        matcher.setProfileCache(profileCache);
 
         char buffer[128];
         std::string result;
         result.reserve(1000000);
 
-#pragma omp for schedule(dynamic, 2) reduction (+: kmersPerPos, resSize, dbMatches, doubleMatches, querySeqLenSum, diagonalOverflow, trancatedCounter)
-        for (size_t id = queryFrom; id < queryFrom + querySize; id++) {
-            progress.updateProgress();
-            // get query sequence
-            char *seqData = qdbr->getData(id, thread_idx);
-            unsigned int qKey = qdbr->getDbKey(id);
-            seq.mapSequence(id, qKey, seqData, qdbr->getSeqLen(id));
-            size_t targetSeqId = UINT_MAX;
-            if (sameQTDB || includeIdentical) {
-                targetSeqId = tdbr->getId(seq.getDbKey());
-                // only the corresponding split should include the id (hack for the hack)
-                if (targetSeqId >= dbFrom && targetSeqId < (dbFrom + dbSize) && targetSeqId != UINT_MAX) {
-                    targetSeqId = targetSeqId - dbFrom;
-                    if(targetSeqId > tdbr->getSize()){
-                        Debug(Debug::ERROR) << "targetSeqId: " << targetSeqId << " > target database size: "  << tdbr->getSize() <<  "\n";
-                        EXIT(EXIT_FAILURE);
-                    }
-                }else{
-                    targetSeqId = UINT_MAX;
+        if (prepareNextSplit && thread_idx == localThreads - 1) {
+#ifdef OPENMP
+            omp_set_num_threads(buildThreads);
+#endif
+            buildIndexTable(buildReader, nextDbFrom, nextDbSize, &nextIndexTable, &nextSequenceLookup);
+        }
+        // pinned after the build, the build threads would inherit the affinity
+        if (indexReplicas.empty() == false) {
+            PageAllocator::pinThread(replicaNodes[replica]);
+        }
+
+#pragma omp for schedule(dynamic, 1) reduction (+: kmersPerPos, generatedKmers, resSize, dbMatches, doubleMatches, querySeqLenSum, diagonalOverflow, trancatedCounter)
+        for (size_t batchStart = 0; batchStart < querySize; batchStart += batchSize) {
+            const size_t batchEnd = std::min(batchStart + batchSize, querySize);
+            for (size_t i = batchStart; i < batchEnd; i++) {
+                const size_t id = queryOrder[i].second;
+                // get query sequence
+                Sequence *querySeq = querySeqs[i - batchStart];
+                if (isProfileQuery && profileCache != NULL && profileCache->mapProfile(querySeq, id, qdbr->getDbKey(id))) {
+                    continue;
+                }
+                char *seqData = qdbr->getData(id, thread_idx);
+                querySeq->mapSequence(id, qdbr->getDbKey(id), seqData, qdbr->getSeqLen(id));
+                if (isProfileQuery && profileCache != NULL) {
+                    profileCache->addProfile(querySeq);
                 }
             }
-            // calculate prefiltering results
-            std::pair<hit_t *, size_t> prefResults = matcher.matchQuery(&seq, targetSeqId);
-            size_t resultSize = prefResults.second;
-            const float queryLength = static_cast<float>(qdbr->getSeqLen(id));
-            for (size_t i = 0; i < resultSize; i++) {
-                hit_t *res = prefResults.first + i;
-                // correct the 0 indexed sequence id again to its real identifier
-                size_t targetSeqId1 = res->seqId + dbFrom;
-                // replace id with key
-                res->seqId = tdbr->getDbKey(targetSeqId1);
-                if (UNLIKELY(targetSeqId1 >= tdbr->getSize())) {
-                    Debug(Debug::WARNING) << "Wrong prefiltering result for query: " << qdbr->getDbKey(id) << " -> " << targetSeqId1 << "\t" << res->prefScore << "\n";
+            if (queryBatchSize > 0) {
+                matcher.prepareBatch(querySeqs.data(), batchEnd - batchStart);
+            }
+            for (size_t i = batchStart; i < batchEnd; i++) {
+                progress.updateProgress();
+                const size_t id = queryOrder[i].second;
+                Sequence &seq = *querySeqs[i - batchStart];
+                unsigned int qKey = seq.getDbKey();
+                size_t targetSeqId = UINT_MAX;
+                if (sameQTDB || includeIdentical) {
+                    targetSeqId = tdbr->getId(seq.getDbKey());
+                    // only the corresponding split should include the id (hack for the hack)
+                    if (targetSeqId >= dbFrom && targetSeqId < (dbFrom + dbSize) && targetSeqId != UINT_MAX) {
+                        targetSeqId = targetSeqId - dbFrom;
+                        if(targetSeqId > tdbr->getSize()){
+                            Debug(Debug::ERROR) << "targetSeqId: " << targetSeqId << " > target database size: "  << tdbr->getSize() <<  "\n";
+                            EXIT(EXIT_FAILURE);
+                        }
+                    }else{
+                        targetSeqId = UINT_MAX;
+                    }
                 }
+                // calculate prefiltering results
+                std::pair<hit_t *, size_t> prefResults = (queryBatchSize > 0) ? matcher.matchBatchQuery(i - batchStart, targetSeqId)
+                                                                              : matcher.matchQuery(&seq, targetSeqId);
+                size_t resultSize = prefResults.second;
+                queryCost[id] = seq.L + matcher.getStatistics()->dbMatches;
+                const float queryLength = static_cast<float>(qdbr->getSeqLen(id));
+                for (size_t i = 0; i < resultSize; i++) {
+                    hit_t *res = prefResults.first + i;
+                    // correct the 0 indexed sequence id again to its real identifier
+                    size_t targetSeqId1 = res->seqId + dbFrom;
+                    // replace id with key
+                    res->seqId = tdbr->getDbKey(targetSeqId1);
+                    if (UNLIKELY(targetSeqId1 >= tdbr->getSize())) {
+                        Debug(Debug::WARNING) << "Wrong prefiltering result for query: " << qdbr->getDbKey(id) << " -> " << targetSeqId1 << "\t" << res->prefScore << "\n";
+                    }
 
-                // TODO: check if this should happen when diagonalScoring == false
-                if (covThr > 0.0 && (covMode == Parameters::COV_MODE_BIDIRECTIONAL
-                                               || covMode == Parameters::COV_MODE_QUERY
-                                               || covMode == Parameters::COV_MODE_LENGTH_SHORTER )) {
-                    const float targetLength = static_cast<float>(tdbr->getSeqLen(targetSeqId1));
-                    if (Util::canBeCovered(covThr, covMode, queryLength, targetLength) == false) {
-                        continue;
+                    // TODO: check if this should happen when diagonalScoring == false
+                    if (covThr > 0.0 && (covMode == Parameters::COV_MODE_BIDIRECTIONAL
+                                                   || covMode == Parameters::COV_MODE_QUERY
+                                                   || covMode == Parameters::COV_MODE_LENGTH_SHORTER )) {
+                        const float targetLength = static_cast<float>(tdbr->getSeqLen(targetSeqId1));
+                        if (Util::canBeCovered(covThr, covMode, queryLength, targetLength) == false) {
+                            continue;
+                        }
                     }
-                }
 
-                // write prefiltering results to a string
-                int len = QueryMatcher::prefilterHitToBuffer(buffer, *res);
-                result.append(buffer, len);
-            }
-            tmpDbw.writeData(result.c_str(), result.length(), qKey, thread_idx);
-            result.clear();
+                    // write prefiltering results to a string
+                    int len = QueryMatcher::prefilterHitToBuffer(buffer, *res);
+                    result.append(buffer, len);
+                }
+                tmpDbw.writeData(result.c_str(), result.length(), qKey, thread_idx);
+                result.clear();
 
-            // update statistics counters
-            if (resultSize != 0) {
-                notEmpty[id - queryFrom] = 1;
-            }
+                // update statistics counters
+                if (resultSize != 0) {
+                    notEmpty[id - queryFrom] = 1;
+                }
 
-            if (Debug::debugLevel >= Debug::INFO) {
                 kmersPerPos += matcher.getStatistics()->kmersPerPos;
+                generatedKmers += matcher.getStatistics()->kmersPerPos * seq.L;
                 dbMatches += matcher.getStatistics()->dbMatches;
                 doubleMatches += matcher.getStatistics()->doubleMatches;
                 querySeqLenSum += seq.L;
                 diagonalOverflow += matcher.getStatistics()->diagonalOverflow;
                 trancatedCounter += matcher.getStatistics()->truncated;
                 resSize += resultSize;
-                realResSize += std::min(resultSize, maxResListLen);
-                reslens[thread_idx]->emplace_back(resultSize);
+                if (Debug::debugLevel >= Debug::INFO) {
+                    realResSize += std::min(resultSize, maxResListLen);
+                    reslens[thread_idx]->emplace_back(resultSize);
+                }
             }
         } // step end
+        PageAllocator::unpinThread();
+        for (size_t i = 0; i < batchSize; i++) {
+            delete querySeqs[i];
+        }
+    }
+    Metrics::stopPhase("kmer_matching");
+    deleteIndexReplicas();
+    // every target split visits all queries again
+    if (splitMode != Parameters::TARGET_DB_SPLIT || split == 0) {
+        Metrics::addCounter("queries", querySize);
+        Metrics::addCounter("query_residues", querySeqLenSum);
+    }
+    Metrics::addCounter("generated_kmers", generatedKmers);
+    Metrics::addCounter("db_matches", dbMatches);
+    Metrics::addCounter("double_matches", doubleMatches);
+    Metrics::addCounter("diagonal_overflows", diagonalOverflow);
+    Metrics::addCounter("truncated_queries", trancatedCounter);
+    Metrics::addCounter("prefilter_hits", resSize);
+
+#ifdef OPENMP
+    omp_set_max_active_levels(maxActiveLevels);
+#endif
+    if (buildReader != NULL) {
+        buildReader->close();
+        delete buildReader;
     }
 
     if (Debug::debugLevel >= Debug::INFO) {
@@ -877,8 +1181,12 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
         }
 
         printStatistics(stats, reslens, localThreads, empty, maxResListLen);
+        if (profileCache != NULL) {
+            Debug(Debug::INFO) << "Query cache size: " << profileCache->getMemorySize() << " bytes\n";
+        }
     }
 
+    Metrics::startPhase("writing");
     if (splitMode == Parameters::TARGET_DB_SPLIT && splits == 1) {
 #ifdef HAVE_MPI
         // if a mpi rank processed a single split, it must have it merged before all ranks can be united
@@ -915,6 +1223,7 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
         DBReader<unsigned int>::removeDb(resultDB);
         DBReader<unsigned int>::moveDb(tempDb.first, resultDB);
     }
+    Metrics::stopPhase("writing");
 
     for (unsigned int i = 0; i < localThreads; i++) {
         reslens[i]->clear();
@@ -1018,7 +1327,7 @@ int Prefiltering::getKmerThreshold(const float sensitivity, const bool isProfile
 size_t Prefiltering::estimateMemoryConsumption(int split, size_t dbSize, size_t resSize,
                                                size_t maxResListLen,
                                                int alphabetSize, int kmerSize, unsigned int querySeqType,
-                                               int threads) {
+                                               int threads, bool kmerBuckets) {
     // for each residue in the database we need 7 byte
     size_t dbSizeSplit = (dbSize) / split;
     size_t residueSize = (resSize / split * 7);
@@ -1043,8 +1352,19 @@ size_t Prefiltering::estimateMemoryConsumption(int split, size_t dbSize, size_t
     }
     // some memory needed to keep the index, ....
     size_t background = dbSize * 22;
+    // the k-mer buckets are alive while the index table is allocated, but are freed before the threads search
+    // the vectors grow by doubling, on average half of the growth is unused
+    size_t bucketSize = 0;
+    if (kmerBuckets) {
+        bucketSize = resSize / split * sizeof(IndexEntryLocalTmp) * 3 / 2;
+    }
     // return result in bytes
-    return residueSize + indexTableSize + threadSize + background + extendedMatrix + dbReaderSize;
+    return residueSize + indexTableSize + std::max(threadSize, bucketSize) + background + extendedMatrix + dbReaderSize;
+}
+
+bool Prefiltering::usesKmerBuckets(int targetSeqType, bool templateDBIsIndex) {
+    // profiles are counted and filled in two passes without buckets
+    return templateDBIsIndex == false && Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_HMM_PROFILE) == false;
 }
 
 size_t Prefiltering::estimateHDDMemoryConsumption(size_t dbSize, size_t maxResListLen) {
@@ -1054,7 +1374,8 @@ size_t Prefiltering::estimateHDDMemoryConsumption(size_t dbSize, size_t maxResLi
 }
 
 std::pair<int, int> Prefiltering::optimizeSplit(size_t totalMemoryInByte, DBReader<unsigned int> *tdbr,
-                                                int alphabetSize, int externalKmerSize, unsigned int querySeqType, unsigned int threads) {
+                                                int alphabetSize, int externalKmerSize, unsigned int querySeqType, unsigned int threads,
+                                                bool kmerBuckets) {
 
     int startKmerSize = (externalKmerSize == 0) ? 6 : externalKmerSize;
     int endKmerSize   = (externalKmerSize == 0) ? 7 : externalKmerSize;
@@ -1078,7 +1399,7 @@ std::pair<int, int> Prefiltering::optimizeSplit(size_t totalMemoryInByte, DBRead
                 size_t neededSize = estimateMemoryConsumption(optSplit, tdbr->getSize(),
                                                               tdbr->getAminoAcidDBSize(),
                                                               0, alphabetSize, optKmerSize, querySeqType,
-                                                              threads);
+                                                              threads, kmerBuckets);
                 if (neededSize < 0.9 * totalMemoryInByte) {
                     return std::make_pair(optKmerSize, optSplit);
                 }
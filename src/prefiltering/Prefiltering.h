@@ -8,10 +8,12 @@
 #include "ScoreMatrix.h"
 #include "PrefilteringIndexReader.h"
 #include "QueryMatcher.h"
+#include "QueryProfileCache.h"
 
 #include <string>
 #include <list>
 #include <utility>
+#include <vector>
 
 class Prefiltering {
 public:
@@ -65,6 +67,17 @@ private:
     ScoreMatrix _3merSubMatrix;
     IndexTable *indexTable;
     SequenceLookup *sequenceLookup;
+    // index of the next target split, built while the current split is searched
+    IndexTable *nextIndexTable;
+    SequenceLookup *nextSequenceLookup;
+    // copies of the index table and sequence lookup on each NUMA node (--numa-mode 2)
+    std::vector<int> replicaNodes;
+    std::vector<IndexTable *> indexReplicas;
+    std::vector<SequenceLookup *> lookupReplicas;
+    // estimated k-mer matching work per query, used to schedule expensive queries first
+    std::vector<size_t> queryCost;
+    // mapped queries kept between target splits (--query-cache-limit)
+    QueryProfileCache *profileCache;
 
     // parameter
     int splits;
@@ -97,18 +110,25 @@ private:
     int preloadMode;
     const unsigned int threads;
     int compressed;
+    bool splitPipeline;
+    bool mpiDynamic;
+    const unsigned int queryBatchSize;
+    size_t queryCacheLimit;
 
-    bool runSplit(const std::string &resultDB, const std::string &resultDBIndex, size_t split, bool merge);
+    bool runSplit(const std::string &resultDB, const std::string &resultDBIndex, size_t split, bool merge, bool prepareNextSplit);
 
     // compute kmer size and split size for index table
     static std::pair<int, int> optimizeSplit(size_t totalMemoryInByte, DBReader<unsigned int> *tdbr, int alphabetSize, int kmerSize,
-                                             unsigned int querySeqType, unsigned int threads);
+                                             unsigned int querySeqType, unsigned int threads, bool kmerBuckets);
 
     // estimates memory consumption while runtime
+    // kmerBuckets: the index table is built from the k-mer buckets of IndexBuilder::fillDatabase
     static size_t estimateMemoryConsumption(int split, size_t dbSize, size_t resSize,
                                             size_t maxHitsPerQuery,
                                             int alphabetSize, int kmerSize, unsigned int querySeqType,
-                                            int threads);
+                                            int threads, bool kmerBuckets);
+
+    static bool usesKmerBuckets(int targetSeqType, bool templateDBIsIndex);
 
     static size_t estimateHDDMemoryConsumption(size_t dbSize, size_t maxResListLen);
 
@@ -118,6 +138,13 @@ private:
     // needed for index lookup
     void getIndexTable(int split, size_t dbFrom, size_t dbSize);
 
+    void buildIndexTable(DBReader<unsigned int> *dbr, size_t dbFrom, size_t dbSize,
+                         IndexTable **table, SequenceLookup **lookup);
+
+    // copies the current index to every NUMA node if there is enough free memory
+    void replicateIndexTable();
+    void deleteIndexReplicas();
+
     void printStatistics(const statistics_t &stats, std::list<int> **reslens,
                          unsigned int resLensSize, size_t empty, size_t maxResults);
 
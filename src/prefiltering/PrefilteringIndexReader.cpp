@@ -5,6 +5,7 @@
 #include "FileUtil.h"
 #include "IndexBuilder.h"
 #include "Parameters.h"
+#include "MemoryMapped.h"
 
 const char*  PrefilteringIndexReader::CURRENT_VERSION = "16";
 unsigned int PrefilteringIndexReader::VERSION = 0;
@@ -30,6 +31,10 @@ unsigned int PrefilteringIndexReader::HDR2INDEX = 20;
 unsigned int PrefilteringIndexReader::HDR2DATA = 21;
 unsigned int PrefilteringIndexReader::GENERATOR = 22;
 unsigned int PrefilteringIndexReader::SPACEDPATTERN = 23;
+unsigned int PrefilteringIndexReader::DBR1DICT = 24;
+unsigned int PrefilteringIndexReader::DBR2DICT = 25;
+unsigned int PrefilteringIndexReader::HDR1DICT = 26;
+unsigned int PrefilteringIndexReader::HDR2DICT = 27;
 
 extern const char* version;
 
@@ -41,6 +46,48 @@ bool PrefilteringIndexReader::checkIfIndexFile(DBReader<unsigned int>* reader) {
     return (strncmp(version, CURRENT_VERSION, strlen(CURRENT_VERSION)) == 0 ) ? true : false;
 }
 
+size_t PrefilteringIndexReader::writeDictionary(DBWriter &writer, DBReader<unsigned int> *reader, unsigned int key, const char *keyName) {
+    if (reader->isCompressed() == false) {
+        return 0;
+    }
+    std::string dictFile = std::string(reader->getDataFileName()) + ".zdict";
+    if (FileUtil::fileExists(dictFile.c_str()) == false) {
+        return 0;
+    }
+    MemoryMapped dictData(dictFile, MemoryMapped::WholeFile, MemoryMapped::SequentialScan);
+    if (!dictData.isValid()) {
+        Debug(Debug::ERROR) << "Can not open dictionary file " << dictFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    Debug(Debug::INFO) << "Write " << keyName << " (" << key << ")\n";
+    const size_t dictSize = dictData.size();
+    writer.writeData((const char *) dictData.getData(), dictSize, key, 0);
+    writer.alignToPageSize();
+    dictData.close();
+    return dictSize + 1;
+}
+
+static unsigned int getDictionaryKey(unsigned int dataIdx) {
+    if (dataIdx == PrefilteringIndexReader::DBR1DATA) {
+        return PrefilteringIndexReader::DBR1DICT;
+    } else if (dataIdx == PrefilteringIndexReader::DBR2DATA) {
+        return PrefilteringIndexReader::DBR2DICT;
+    } else if (dataIdx == PrefilteringIndexReader::HDR1DATA) {
+        return PrefilteringIndexReader::HDR1DICT;
+    } else if (dataIdx == PrefilteringIndexReader::HDR2DATA) {
+        return PrefilteringIndexReader::HDR2DICT;
+    }
+    return UINT_MAX;
+}
+
+static void setDictionary(DBReader<unsigned int> *dbr, DBReader<unsigned int> *reader, unsigned int dataIdx) {
+    size_t id = dbr->getId(getDictionaryKey(dataIdx));
+    if (id == UINT_MAX) {
+        return;
+    }
+    reader->setDictionary(dbr->getDataUncompressed(id), dbr->getEntryLen(id) - 1);
+}
+
 std::string PrefilteringIndexReader::indexName(const std::string &outDB) {
     std::string result(outDB);
     result.append(".idx");
@@ -125,9 +172,15 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
     writer.alignToPageSize();
     free(data);
 
+    size_t offsetDict = writer.getOffset(0);
+    size_t dictSize = writeDictionary(writer, dbr1, DBR1DICT, "DBR1DICT");
+
     if (dbr2 == NULL) {
         writer.writeIndexEntry(DBR2INDEX, offsetIndex, DBReader<unsigned int>::indexMemorySize(*dbr1)+1, 0);
         writer.writeIndexEntry(DBR2DATA,  offsetData,  dbr1->getTotalDataSize()+1, 0);
+        if (dictSize > 0) {
+            writer.writeIndexEntry(DBR2DICT, offsetDict, dictSize, 0);
+        }
     } else {
         Debug(Debug::INFO) << "Write DBR2INDEX (" << DBR2INDEX << ")\n";
         data = DBReader<unsigned int>::serialize(*dbr2);
@@ -141,6 +194,7 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
         writer.writeEnd(DBR2DATA, 0);
         writer.alignToPageSize();
         free(data);
+        writeDictionary(writer, dbr2, DBR2DICT, "DBR2DICT");
     }
 
     if (hdbr1 != NULL) {
@@ -159,9 +213,14 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
         writer.writeEnd(HDR1DATA, 0);
         writer.alignToPageSize();
         free(data);
+        size_t offsetDict = writer.getOffset(0);
+        size_t dictSize = writeDictionary(writer, hdbr1, HDR1DICT, "HDR1DICT");
         if (hdbr2 == NULL) {
             writer.writeIndexEntry(HDR2INDEX, offsetIndex, DBReader<unsigned int>::indexMemorySize(*hdbr1)+1, 0);
             writer.writeIndexEntry(HDR2DATA,  offsetData, hdbr1->getTotalDataSize()+1, 0);
+            if (dictSize > 0) {
+                writer.writeIndexEntry(HDR2DICT, offsetDict, dictSize, 0);
+            }
         }
     }
     if (hdbr2 != NULL) {
@@ -177,6 +236,7 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
         writer.writeEnd(HDR2DATA, 0);
         writer.alignToPageSize();
         free(data);
+        writeDictionary(writer, hdbr2, HDR2DICT, "HDR2DICT");
     }
     Debug(Debug::INFO) << "Write GENERATOR (" << GENERATOR << ")\n";
     writer.writeData(version, strlen(version), GENERATOR, 0);
@@ -282,6 +342,7 @@ DBReader<unsigned int> *PrefilteringIndexReader::openNewHeaderReader(DBReader<un
     reader->open(DBReader<unsigned int>::NOSORT);
     reader->setData(data, dataSize);
     reader->setMode(DBReader<unsigned int>::USE_DATA);
+    setDictionary(dbr, reader, dataIdx);
     return reader;
 }
 
@@ -308,6 +369,7 @@ DBReader<unsigned int> *PrefilteringIndexReader::openNewReader(DBReader<unsigned
         size_t dataSize = nextDataOffset-currDataOffset;
         reader->setData(dbr->getDataUncompressed(id), dataSize);
         reader->setMode(DBReader<unsigned int>::USE_DATA);
+        setDictionary(dbr, reader, dataIdx);
         return reader;
     }
 
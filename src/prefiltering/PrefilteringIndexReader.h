@@ -6,6 +6,8 @@
 #include "DBReader.h"
 #include <string>
 
+class DBWriter;
+
 struct PrefilteringIndexData {
     int maxSeqLength;
     int kmerSize;
@@ -49,8 +51,16 @@ public:
     static unsigned int HDR2DATA;
     static unsigned int GENERATOR;
     static unsigned int SPACEDPATTERN;
+    static unsigned int DBR1DICT;
+    static unsigned int DBR2DICT;
+    static unsigned int HDR1DICT;
+    static unsigned int HDR2DICT;
 
     static bool checkIfIndexFile(DBReader<unsigned int> *reader);
+
+    // compressed entries are copied into the index as they are and need the zstd dictionary of their database
+    // returns the length of the written entry, 0 if there is no dictionary
+    static size_t writeDictionary(DBWriter &writer, DBReader<unsigned int> *reader, unsigned int key, const char *keyName);
     static std::string indexName(const std::string &outDB);
 
     static void createIndexFile(const std::string &outDb,
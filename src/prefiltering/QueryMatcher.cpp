@@ -64,6 +64,15 @@ QueryMatcher::QueryMatcher(IndexTable *indexTable, SequenceLookup *sequenceLooku
         ungappedAlignment = new UngappedAlignment(maxSeqLen, ungappedAlignmentSubMat, sequenceLookup);
     }
     compositionBias = new float[maxSeqLen];
+    profileCache = NULL;
+    this->maxSeqLen = maxSeqLen;
+    prefetchDistance = DEFAULT_PREFETCH_DISTANCE;
+    batchFrom = 0;
+    batchTo = 0;
+    batchBucketShift = 0;
+    while (((indexTable->getTableSize() - 1) >> batchBucketShift) >= BATCH_BUCKETS) {
+        batchBucketShift++;
+    }
 }
 
 QueryMatcher::~QueryMatcher(){
@@ -81,23 +90,170 @@ QueryMatcher::~QueryMatcher(){
     delete kmerGenerator;
 }
 
-std::pair<hit_t*, size_t> QueryMatcher::matchQuery(Sequence *querySeq, unsigned int identityId) {
-    querySeq->resetCurrPos();
-//    std::cout << "Id: " << querySeq->getId() << std::endl;
-    memset(scoreSizes, 0, SCORE_RANGE * sizeof(unsigned int));
-
+void QueryMatcher::computeCompositionBias(Sequence *querySeq, float *compositionBias) {
     // bias correction
     if(aaBiasCorrection == true){
         if(Parameters::isEqualDbtype(querySeq->getSeqType(), Parameters::DBTYPE_AMINO_ACIDS)) {
+            if (profileCache != NULL && profileCache->getCompositionBias(querySeq->getId(), compositionBias, querySeq->L)) {
+                return;
+            }
             SubstitutionMatrix::calcLocalAaBiasCorrection(kmerSubMat, querySeq->numSequence, querySeq->L, compositionBias);
+            if (profileCache != NULL) {
+                profileCache->addCompositionBias(querySeq->getId(), compositionBias, querySeq->L);
+            }
         }else{
             memset(compositionBias, 0, sizeof(float) * querySeq->L);
         }
     } else {
         memset(compositionBias, 0, sizeof(float) * querySeq->L);
     }
+}
+
+std::pair<hit_t*, size_t> QueryMatcher::matchQuery(Sequence *querySeq, unsigned int identityId) {
+    querySeq->resetCurrPos();
+//    std::cout << "Id: " << querySeq->getId() << std::endl;
+    memset(scoreSizes, 0, SCORE_RANGE * sizeof(unsigned int));
+    computeCompositionBias(querySeq, compositionBias);
 
     size_t resultSize = match(querySeq, compositionBias);
+    return scoreQuery(querySeq, compositionBias, resultSize, identityId);
+}
+
+void QueryMatcher::prepareBatch(Sequence **querySeqs, size_t count) {
+    batchSeqs.assign(querySeqs, querySeqs + count);
+    if (batchCompositionBias.size() < count * maxSeqLen) {
+        batchCompositionBias.resize(count * maxSeqLen);
+    }
+    for (size_t i = 0; i < count; i++) {
+        querySeqs[i]->resetCurrPos();
+        computeCompositionBias(querySeqs[i], &batchCompositionBias[i * maxSeqLen]);
+    }
+    collectBatch(0);
+}
+
+void QueryMatcher::collectBatch(size_t from) {
+    // generate the k-mer lists until the k-mer limit is reached, at least for one query
+    pendingKmers.clear();
+    pendingPositions.clear();
+    batchPositionStart.clear();
+    batchFrom = from;
+    size_t to = from;
+    while (to < batchSeqs.size() && (to == from || pendingKmers.size() < MAX_BATCH_KMERS)) {
+        Sequence *seq = batchSeqs[to];
+        seq->resetCurrPos();
+        if (seq->profile_matrix != NULL) {
+            kmerGenerator->updateProfileMatrix(seq->profile_matrix);
+        }
+        batchPositionStart.push_back(pendingPositions.size());
+        while (seq->hasNextKmer()) {
+            generateNextKmerList(seq, &batchCompositionBias[to * maxSeqLen]);
+        }
+        to++;
+    }
+    batchPositionStart.push_back(pendingPositions.size());
+
+    // bucket the k-mers by their leading bits with a counting sort, a comparison sort costs more than
+    // the lookups it saves, each bucket covers only a few pages of the index table
+    const size_t kmerCount = pendingKmers.size();
+    batchBuckets.assign(BATCH_BUCKETS + 1, 0);
+    for (size_t i = 0; i < kmerCount; i++) {
+        batchBuckets[(pendingKmers[i] >> batchBucketShift) + 1]++;
+    }
+    for (size_t i = 1; i <= BATCH_BUCKETS; i++) {
+        batchBuckets[i] += batchBuckets[i - 1];
+    }
+    batchKmers.resize(kmerCount);
+    for (size_t i = 0; i < kmerCount; i++) {
+        BatchKmer &batchKmer = batchKmers[batchBuckets[pendingKmers[i] >> batchBucketShift]++];
+        batchKmer.kmer = pendingKmers[i];
+        batchKmer.order = i;
+    }
+
+    // read the list sizes in k-mer order
+    batchHitOffsets.resize(kmerCount);
+    size_t seqListSize;
+    for (size_t i = 0; i < kmerCount; i++) {
+        indexTable->getDBSeqList(batchKmers[i].kmer, &seqListSize);
+        batchHitOffsets[batchKmers[i].order] = seqListSize;
+    }
+
+    // lay out the hits in generation order, as match would, until databaseHits is full
+    // the remaining queries are collected again when their results are requested
+    batchPositionHits.resize(pendingPositions.size() + 1);
+    const size_t maxHits = lastSequenceHit - databaseHits;
+    size_t offset = 0;
+    size_t matchedKmers = 0;
+    batchTo = from;
+    for (size_t i = 0; i < to - from; i++) {
+        for (size_t pos = batchPositionStart[i]; pos < batchPositionStart[i + 1]; pos++) {
+            batchPositionHits[pos] = offset;
+            for (size_t kmerPos = pendingPositions[pos].start; kmerPos < pendingPositions[pos].end; kmerPos++) {
+                const size_t listSize = batchHitOffsets[kmerPos];
+                batchHitOffsets[kmerPos] = offset;
+                offset += listSize;
+            }
+        }
+        if (offset >= maxHits) {
+            break;
+        }
+        batchPositionHits[batchPositionStart[i + 1]] = offset;
+        batchTo = from + i + 1;
+        matchedKmers = (batchPositionStart[i + 1] > 0) ? pendingPositions[batchPositionStart[i + 1] - 1].end : 0;
+    }
+
+    // copy the lists with one sweep over the index table in k-mer order
+    for (size_t i = 0; i < kmerCount; i++) {
+        if (prefetchDistance > 0) {
+            if (i + 2 * prefetchDistance < kmerCount) {
+                indexTable->prefetchOffsets(batchKmers[i + 2 * prefetchDistance].kmer);
+            }
+            if (i + prefetchDistance < kmerCount) {
+                indexTable->prefetchDBSeqList(batchKmers[i + prefetchDistance].kmer);
+            }
+        }
+        if (batchKmers[i].order >= matchedKmers) {
+            continue;
+        }
+        const IndexEntryLocal *entries = indexTable->getDBSeqList(batchKmers[i].kmer, &seqListSize);
+        memcpy(databaseHits + batchHitOffsets[batchKmers[i].order], entries, sizeof(IndexEntryLocal) * seqListSize);
+    }
+}
+
+std::pair<hit_t*, size_t> QueryMatcher::matchBatchQuery(size_t batchIdx, unsigned int identityId) {
+    if (batchIdx >= batchTo) {
+        collectBatch(batchIdx);
+    }
+    Sequence *querySeq = batchSeqs[batchIdx];
+    float *bias = &batchCompositionBias[batchIdx * maxSeqLen];
+    memset(scoreSizes, 0, SCORE_RANGE * sizeof(unsigned int));
+    size_t resultSize;
+    if (batchIdx < batchTo) {
+        const size_t posFrom = batchPositionStart[batchIdx - batchFrom];
+        const size_t posTo = batchPositionStart[batchIdx - batchFrom + 1];
+        size_t kmerListLen = 0;
+        unsigned short indexTo = 0;
+        indexPointer[0] = databaseHits + batchPositionHits[posFrom];
+        for (size_t pos = posFrom; pos < posTo; pos++) {
+            const PendingPosition &position = pendingPositions[pos];
+            indexPointer[position.i] = databaseHits + batchPositionHits[pos];
+            indexTo = position.i;
+            kmerListLen += position.end - position.start;
+        }
+        indexPointer[indexTo + 1] = databaseHits + batchPositionHits[posTo];
+        stats->diagonalOverflow = false;
+        resultSize = countDiagonals(querySeq, 0, indexTo, 0, kmerListLen, batchPositionHits[posTo] - batchPositionHits[posFrom]);
+    } else {
+        // the hits of this query alone overflow databaseHits, match handles the overflow
+        if (querySeq->profile_matrix != NULL) {
+            kmerGenerator->updateProfileMatrix(querySeq->profile_matrix);
+        }
+        querySeq->resetCurrPos();
+        resultSize = match(querySeq, bias);
+    }
+    return scoreQuery(querySeq, bias, resultSize, identityId);
+}
+
+std::pair<hit_t*, size_t> QueryMatcher::scoreQuery(Sequence *querySeq, float *compositionBias, size_t resultSize, unsigned int identityId) {
     std::pair<hit_t *, size_t> queryResult;
     if (diagonalScoring) {
         // write diagonal scores in count value
@@ -154,6 +310,36 @@ std::pair<hit_t*, size_t> QueryMatcher::matchQuery(Sequence *querySeq, unsigned
     return queryResult;
 }
 
+void QueryMatcher::generateNextKmerList(Sequence *seq, float *compositionBias) {
+    const unsigned char *kmer = seq->nextKmer();
+    const unsigned char *pos = seq->getAAPosInSpacedPattern();
+    PendingPosition position;
+    position.i = seq->getCurrentPosition();
+    position.containsX = seq->kmerContainsX();
+    position.start = pendingKmers.size();
+    if (position.containsX == false) {
+        float biasCorrection = 0;
+        for (int i = 0; i < kmerSize; i++){
+            biasCorrection += compositionBias[position.i + static_cast<short>(pos[i])];
+        }
+        // round bias to next higher or lower value
+        short bias = static_cast<short>((biasCorrection < 0.0) ? biasCorrection - 0.5: biasCorrection + 0.5);
+        short kmerMatchScore = std::max(kmerThr - bias, 0);
+
+        // adjust kmer threshold based on composition bias
+        kmerGenerator->setThreshold(kmerMatchScore);
+
+        if (takeOnlyBestKmer) {
+            pendingKmers.push_back(idx.int2index(kmer));
+        } else {
+            std::pair<size_t*, size_t> kmerList = kmerGenerator->generateKmerList(kmer);
+            pendingKmers.insert(pendingKmers.end(), kmerList.first, kmerList.first + kmerList.second);
+        }
+    }
+    position.end = pendingKmers.size();
+    pendingPositions.push_back(position);
+}
+
 size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
     // go through the query sequence
     size_t kmerListLen = 0;
@@ -166,53 +352,53 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
     size_t seqListSize;
     unsigned short indexStart = 0;
     unsigned short indexTo = 0;
-    while (seq->hasNextKmer()) {
-        const unsigned char *kmer = seq->nextKmer();
-        const unsigned char *pos = seq->getAAPosInSpacedPattern();
-        const unsigned short current_i = seq->getCurrentPosition();
-
-        float biasCorrection = 0;
-        for (int i = 0; i < kmerSize; i++){
-            biasCorrection += compositionBias[current_i + static_cast<short>(pos[i])];
+    // the k-mer lists are generated ahead into pendingKmers, possibly several positions ahead,
+    // the offsets of a k-mer are prefetched 2 * prefetchDistance lookups before it is matched
+    // and its first list entries prefetchDistance lookups before
+    pendingKmers.clear();
+    pendingPositions.clear();
+    size_t positionCursor = 0;
+    while (true) {
+        if (positionCursor == pendingPositions.size()) {
+            if (seq->hasNextKmer() == false) {
+                break;
+            }
+            generateNextKmerList(seq, compositionBias);
         }
-        if (seq->kmerContainsX()) {
+        const PendingPosition position = pendingPositions[positionCursor];
+        positionCursor++;
+        const unsigned short current_i = position.i;
+        if (position.containsX) {
             indexTo = current_i;
             indexPointer[current_i] = sequenceHits;
             continue;
         }
-        // round bias to next higher or lower value
-        short bias = static_cast<short>((biasCorrection < 0.0) ? biasCorrection - 0.5: biasCorrection + 0.5);
-        short kmerMatchScore = std::max(kmerThr - bias, 0);
-
-        // adjust kmer threshold based on composition bias
-        kmerGenerator->setThreshold(kmerMatchScore);
-
-        const size_t *index;
-        size_t exactKmer;
-        size_t kmerElementSize;
-        if (takeOnlyBestKmer) {
-            kmerElementSize = 1;
-            exactKmer = idx.int2index(kmer);
-            index = &exactKmer;
-        } else {
-            std::pair<size_t*, size_t> kmerList = kmerGenerator->generateKmerList(kmer);
-            kmerElementSize = kmerList.second;
-            index = kmerList.first;
-        }
         //std::cout << kmer << std::endl;
         indexPointer[current_i] = sequenceHits;
         // match the index table
 
         //idx.printKmer(kmerList.index[0], kmerSize, m->num2aa);
         //std::cout << "\t" << kmerMatchScore << std::endl;
-        kmerListLen += kmerElementSize;
+        kmerListLen += position.end - position.start;
 
-        for (unsigned int kmerPos = 0; kmerPos < kmerElementSize; kmerPos++) {
-            const IndexEntryLocal *entries = indexTable->getDBSeqList(index[kmerPos], &seqListSize);
+        for (size_t kmerPos = position.start; kmerPos < position.end; kmerPos++) {
+            if (prefetchDistance > 0) {
+                const size_t offsetsAhead = kmerPos + 2 * prefetchDistance;
+                while (offsetsAhead >= pendingKmers.size() && seq->hasNextKmer()) {
+                    generateNextKmerList(seq, compositionBias);
+                }
+                if (offsetsAhead < pendingKmers.size()) {
+                    indexTable->prefetchOffsets(pendingKmers[offsetsAhead]);
+                }
+                if (kmerPos + prefetchDistance < pendingKmers.size()) {
+                    indexTable->prefetchDBSeqList(pendingKmers[kmerPos + prefetchDistance]);
+                }
+            }
+            const IndexEntryLocal *entries = indexTable->getDBSeqList(pendingKmers[kmerPos], &seqListSize);
             // DEBUG
             //std::cout << seq->getDbKey() << std::endl;
-            //idx.printKmer(index[kmerPos], kmerSize, kmerSubMat->num2aa);
-            //std::cout << "\t" << current_i << "\t"<< index[kmerPos] << std::endl;
+            //idx.printKmer(pendingKmers[kmerPos], kmerSize, kmerSubMat->num2aa);
+            //std::cout << "\t" << current_i << "\t"<< pendingKmers[kmerPos] << std::endl;
             //for (size_t i = 0; i < seqListSize; i++) {
             //    char diag = entries[i].position_j - current_i;
             //    std::cout << "(" << entries[i].seqId << " " << (int) diag << ")\t";
@@ -252,9 +438,23 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
             numMatches += seqListSize;
         }
         indexTo = current_i;
+
+        // drop the matched k-mers, only the lists of the few positions ahead remain
+        if (position.end >= PENDING_KMERS_COMPACT) {
+            pendingKmers.erase(pendingKmers.begin(), pendingKmers.begin() + position.end);
+            for (size_t i = positionCursor; i < pendingPositions.size(); i++) {
+                pendingPositions[i].start -= position.end;
+                pendingPositions[i].end -= position.end;
+            }
+        }
     }
     outer:
     indexPointer[indexTo + 1] = databaseHits + numMatches;
+    return countDiagonals(seq, indexStart, indexTo, overflowHitCount, kmerListLen, overflowNumMatches + numMatches);
+}
+
+size_t QueryMatcher::countDiagonals(Sequence *seq, unsigned short indexStart, unsigned short indexTo,
+                                    size_t overflowHitCount, size_t kmerListLen, size_t dbMatches) {
     // fill the output
     size_t hitCount = findDuplicates(indexPointer, foundDiagonals + overflowHitCount,
                                      foundDiagonalsSize - overflowHitCount, indexStart, indexTo, (diagonalScoring == false));
@@ -270,7 +470,7 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
     }
     stats->kmersPerPos = ((double)kmerListLen/(double)seq->L);
     stats->querySeqLen = seq->L;
-    stats->dbMatches   = overflowNumMatches + numMatches;
+    stats->dbMatches   = dbMatches;
 
     return hitCount;
 }
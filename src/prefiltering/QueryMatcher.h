@@ -6,11 +6,13 @@
 #define MMSEQS_QUERYTEMPLATEMATCHEREXACTMATCH_H
 
 #include <cstdlib>
+#include <vector>
 #include "itoa.h"
 #include "EvalueComputation.h"
 #include "CacheFriendlyOperations.h"
 #include "UngappedAlignment.h"
 #include "KmerGenerator.h"
+#include "QueryProfileCache.h"
 
 
 struct statistics_t{
@@ -63,6 +65,14 @@ public:
     // identityId is the id of the identitical sequence in the target database if there is any, UINT_MAX otherwise
     std::pair<hit_t*, size_t> matchQuery(Sequence *querySeq, unsigned int identityId);
 
+    // collects the k-mer lists of the queries of a batch, orders them by k-mer and copies the index table
+    // lists of all queries with one sweep in k-mer order, the queries have to stay mapped until
+    // their results were requested with matchBatchQuery. Large batches are split into several sweeps
+    void prepareBatch(Sequence **querySeqs, size_t count);
+
+    // returns the result of a query of the prepared batch, results have to be requested in batch order
+    std::pair<hit_t*, size_t> matchBatchQuery(size_t batchIdx, unsigned int identityId);
+
     // set substituion matrix for KmerGenerator
     void setProfileMatrix(ScoreMatrix **matrix){
         kmerGenerator->setDivideStrategy(matrix);
@@ -73,6 +83,16 @@ public:
         kmerGenerator->setDivideStrategy(three, two);
     }
 
+    // number of k-mers the index lookups are prefetched ahead, 0 disables prefetching
+    void setPrefetchDistance(unsigned int distance) {
+        prefetchDistance = distance;
+    }
+
+    // reuse the composition bias of queries that were matched before, e.g. in a previous target split
+    void setProfileCache(QueryProfileCache *cache) {
+        profileCache = cache;
+    }
+
     // get statistics
     const statistics_t *getStatistics() {
         return stats;
@@ -183,6 +203,7 @@ protected:
     size_t maxHitsPerQuery;
 
     float *compositionBias;
+    QueryProfileCache *profileCache;
 
     // diagonal scoring active
     bool diagonalScoring;
@@ -192,6 +213,64 @@ protected:
 
     const static size_t SCORE_RANGE = 256;
 
+    const static unsigned int DEFAULT_PREFETCH_DISTANCE = 16;
+    // consumed pending k-mers are removed once there are this many
+    const static size_t PENDING_KMERS_COMPACT = 65536;
+
+    // query position whose k-mer list was generated but not matched yet
+    struct PendingPosition {
+        unsigned short i;
+        bool containsX;
+        size_t start;
+        size_t end;
+    };
+
+    // k-mer lists of the upcoming query positions, generated ahead of the lookups to prefetch them
+    std::vector<size_t> pendingKmers;
+    std::vector<PendingPosition> pendingPositions;
+    unsigned int prefetchDistance;
+
+    void generateNextKmerList(Sequence *seq, float *compositionBias);
+
+    struct BatchKmer {
+        size_t kmer;
+        // position of the k-mer in pendingKmers
+        size_t order;
+    };
+
+    unsigned int maxSeqLen;
+    // queries of the current batch and their composition bias (maxSeqLen values per query)
+    std::vector<Sequence *> batchSeqs;
+    std::vector<float> batchCompositionBias;
+    // first pending position of each batch query
+    std::vector<size_t> batchPositionStart;
+    // k-mers of the batch bucketed by k-mer
+    std::vector<BatchKmer> batchKmers;
+    const static size_t BATCH_BUCKETS = 4096;
+    std::vector<size_t> batchBuckets;
+    unsigned int batchBucketShift;
+    // for each pending k-mer the position of its list in databaseHits
+    std::vector<size_t> batchHitOffsets;
+    // for each pending position the offset of its first hit in databaseHits
+    std::vector<size_t> batchPositionHits;
+    // the k-mers of the batch queries from batchFrom on are pending, the hits of batchFrom to batchTo are in databaseHits
+    size_t batchFrom;
+    size_t batchTo;
+    // limits the memory of the pending k-mers of a batch (32 byte per k-mer)
+    const static size_t MAX_BATCH_KMERS = 1024 * 1024;
+
+    void computeCompositionBias(Sequence *querySeq, float *compositionBias);
+
+    // generates the k-mers of the batch queries starting at from and copies the hits of as many as fit
+    void collectBatch(size_t from);
+
+    // computes the scores and the result list from the diagonals found by match
+    std::pair<hit_t *, size_t> scoreQuery(Sequence *querySeq, float *compositionBias, size_t resultSize, unsigned int identityId);
+
+    // counts the hits on each diagonal between indexPointer[indexStart] and indexPointer[indexTo + 1]
+    size_t countDiagonals(Sequence *seq, unsigned short indexStart, unsigned short indexTo,
+                          size_t overflowHitCount, size_t kmerListLen, size_t dbMatches);
+
     void updateScoreBins(CounterResult *result, size_t elementCount);
 
     static unsigned int computeScoreThreshold(unsigned int * scoreSizes, size_t maxHitsPerQuery) {
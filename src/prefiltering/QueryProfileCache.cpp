@@ -0,0 +1,62 @@
+#include "QueryProfileCache.h"
+
+#include <cstdlib>
+#include <cstring>
+
+QueryProfileCache::QueryProfileCache(size_t querySize, size_t memoryLimit)
+        : entries(querySize, NULL), memoryLimit(memoryLimit), usedMemory(getIndexSize(querySize)) {}
+
+QueryProfileCache::~QueryProfileCache() {
+    for (size_t i = 0; i < entries.size(); i++) {
+        free(entries[i]);
+    }
+}
+
+QueryProfileCache::Entry *QueryProfileCache::allocateEntry(size_t id, int L, size_t dataSize) {
+    if (id >= entries.size() || entries[id] != NULL) {
+        return NULL;
+    }
+    const size_t entrySize = offsetof(Entry, data) + dataSize;
+    if (__sync_add_and_fetch(&usedMemory, entrySize) > memoryLimit) {
+        __sync_fetch_and_sub(&usedMemory, entrySize);
+        return NULL;
+    }
+    Entry *entry = static_cast<Entry *>(malloc(entrySize));
+    if (entry == NULL) {
+        __sync_fetch_and_sub(&usedMemory, entrySize);
+        return NULL;
+    }
+    entry->L = L;
+    entries[id] = entry;
+    return entry;
+}
+
+bool QueryProfileCache::getCompositionBias(size_t id, float *compositionBias, int L) const {
+    if (id >= entries.size() || entries[id] == NULL || entries[id]->L != L) {
+        return false;
+    }
+    memcpy(compositionBias, entries[id]->data, L * sizeof(float));
+    return true;
+}
+
+void QueryProfileCache::addCompositionBias(size_t id, const float *compositionBias, int L) {
+    Entry *entry = allocateEntry(id, L, L * sizeof(float));
+    if (entry != NULL) {
+        memcpy(entry->data, compositionBias, L * sizeof(float));
+    }
+}
+
+bool QueryProfileCache::mapProfile(Sequence *seq, size_t id, unsigned int dbKey) const {
+    if (id >= entries.size() || entries[id] == NULL) {
+        return false;
+    }
+    seq->restoreMappedProfile(id, dbKey, entries[id]->data, entries[id]->L);
+    return true;
+}
+
+void QueryProfileCache::addProfile(const Sequence *seq) {
+    Entry *entry = allocateEntry(seq->getId(), seq->L, seq->getMappedProfileSize());
+    if (entry != NULL) {
+        seq->storeMappedProfile(entry->data);
+    }
+}
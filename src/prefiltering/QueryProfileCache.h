@@ -0,0 +1,48 @@
+#ifndef MMSEQS_QUERYPROFILECACHE_H
+#define MMSEQS_QUERYPROFILECACHE_H
+
+#include "Sequence.h"
+
+#include <cstddef>
+#include <vector>
+
+// Keeps the mapped queries of the prefilter between target splits, so that the composition bias of sequences
+// and the pseudo-counts and scores of profiles are computed once per query. Entries are added until the memory
+// limit is reached and are never evicted, since every split visits all queries again.
+// Each query is added and read by one thread at a time, the splits are separated by the end of a parallel region.
+class QueryProfileCache {
+public:
+    QueryProfileCache(size_t querySize, size_t memoryLimit);
+    ~QueryProfileCache();
+
+    // composition bias of an amino acid query
+    bool getCompositionBias(size_t id, float *compositionBias, int L) const;
+    void addCompositionBias(size_t id, const float *compositionBias, int L);
+
+    // mapped scores of a profile HMM query
+    bool mapProfile(Sequence *seq, size_t id, unsigned int dbKey) const;
+    void addProfile(const Sequence *seq);
+
+    size_t getMemorySize() const {
+        return usedMemory;
+    }
+
+    // memory of the per-query entry pointers that every cache allocates up front
+    static size_t getIndexSize(size_t querySize) {
+        return querySize * sizeof(Entry *);
+    }
+
+private:
+    struct Entry {
+        int L;
+        char data[1];
+    };
+
+    Entry *allocateEntry(size_t id, int L, size_t dataSize);
+
+    std::vector<Entry *> entries;
+    const size_t memoryLimit;
+    size_t usedMemory;
+};
+
+#endif
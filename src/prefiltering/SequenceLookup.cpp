@@ -7,13 +7,14 @@
 #include "Debug.h"
 #include "Util.h"
 #include "SequenceLookup.h"
+#include "PageAllocator.h"
 
 SequenceLookup::SequenceLookup(size_t sequenceCount, size_t dataSize)
         : sequenceCount(sequenceCount), dataSize(dataSize), currentIndex(0), currentOffset(0), externalData(false) {
-    data = new(std::nothrow) char[dataSize + 1];
+    data = PageAllocator::allocateArray<char>(dataSize + 1);
     Util::checkAllocation(data, "Can not allocate data memory in SequenceLookup");
 
-    offsets = new(std::nothrow) size_t[sequenceCount + 1];
+    offsets = PageAllocator::allocateArray<size_t>(sequenceCount + 1);
     Util::checkAllocation(offsets, "Can not allocate offsets memory in SequenceLookup");
     offsets[sequenceCount] = dataSize;
 }
@@ -24,8 +25,8 @@ SequenceLookup::SequenceLookup(size_t sequenceCount)
 
 SequenceLookup::~SequenceLookup() {
     if(externalData == false){
-        delete[] data;
-        delete[] offsets;
+        PageAllocator::free(data);
+        PageAllocator::free(offsets);
     }
 }
 
@@ -14,6 +14,7 @@
 #include "NucleotideMatrix.h"
 #include "FastSort.h"
 #include "SubstitutionMatrixProfileStates.h"
+#include "Metrics.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -77,6 +78,7 @@ int doRescorealldiagonal(Parameters &par, DBReader<unsigned int> &qdbr, DBWriter
 
     Debug::Progress progress(dbSize);
 
+    Metrics::startPhase("ungapped_alignment");
 #pragma omp parallel
     {
         unsigned int thread_idx = 0;
@@ -147,6 +149,8 @@ int doRescorealldiagonal(Parameters &par, DBReader<unsigned int> &qdbr, DBWriter
             shortResults.clear();
         }
     }
+    Metrics::stopPhase("ungapped_alignment");
+    Metrics::addCounter("queries", dbSize);
 
     qdbr.close();
     if (sameDB == false) {
@@ -104,6 +104,8 @@ int filtertaxseqdb(int argc, const char **argv, const Command& command) {
         DBReader<unsigned int>::softlinkDb(par.db1, par.db2, DBFiles::SEQUENCE_NO_DATA_INDEX);
     } else {
         DBWriter::writeDbtypeFile(par.db2.c_str(), reader.getDbtype(), isCompressed);
+        // the compressed entries are copied as they are and need the dictionary of the input
+        DBReader<unsigned int>::copyDb(par.db1, par.db2, DBFiles::DATA_ZDICT);
         DBReader<unsigned int>::softlinkDb(par.db1, par.db2, DBFiles::SEQUENCE_ANCILLARY);
     }
 
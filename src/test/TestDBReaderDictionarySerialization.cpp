@@ -0,0 +1,57 @@
+#include "Debug.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "MemoryMapped.h"
+#include "Parameters.h"
+
+#include <cstring>
+
+const char* binary_name = "test_dbreaderdictionaryserialization";
+
+// compressed entries of a precomputed index are read by unserialized readers, which get the dictionary from the index
+int main (int, const char**) {
+    const char * data = "CTGGCGAAACCCAGACCGGTAAGCTTTTCCGTATGCGCGGTAAAGGCGTCAAGTCTGTCC"
+                        "GCGGTGGCGCACAGGGTGATTTGCTGTGCCGCGTTGTCGTCGAAACACCGGTAGGCCTGA"
+                        "ACGAGAAGCAGAAACAGCTGCTGCAAGAGCTGCAAGAAAGCTTCGGTGGCCCAACCGGTG";
+
+    DBWriter writer("dataDict", "dataDict.index", 1, Parameters::WRITER_COMPRESSED_MODE, Parameters::DBTYPE_NUCLEOTIDES);
+    // a raw content dictionary, the entries refer to it instead of containing the sequence
+    writer.setDictionary(std::string(data));
+    writer.open();
+    for (unsigned int key = 0; key < 10; key++) {
+        writer.writeData(data + key, strlen(data) - key, key, 0);
+    }
+    writer.close();
+
+    DBReader<unsigned int> reader("dataDict", "dataDict.index", 1, DBReader<unsigned int>::USE_DATA | DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::NOSORT);
+
+    char* index = DBReader<unsigned int>::serialize(reader);
+    DBReader<unsigned int>* newdbr = DBReader<unsigned int>::unserialize(index, 1);
+    newdbr->open(DBReader<unsigned int>::NOSORT);
+    newdbr->setData(reader.getDataForFile(0), reader.getDataSizeForFile(0));
+    newdbr->setMode(DBReader<unsigned int>::USE_DATA);
+
+    MemoryMapped dictData("dataDict.zdict", MemoryMapped::WholeFile, MemoryMapped::SequentialScan);
+    newdbr->setDictionary((const char *) dictData.getData(), dictData.size());
+    dictData.close();
+
+    int status = EXIT_SUCCESS;
+    for (size_t i = 0; i < newdbr->getSize(); i++) {
+        const unsigned int key = newdbr->getDbKey(i);
+        const char *expected = data + key;
+        const char *entry = newdbr->getData(i, 0);
+        if (strncmp(entry, expected, strlen(expected)) != 0) {
+            Debug(Debug::ERROR) << "Entry " << key << " differs after unserialize\n";
+            status = EXIT_FAILURE;
+        }
+    }
+    Debug(Debug::INFO) << newdbr->getSize() << " entries read\n";
+    free(index);
+
+    newdbr->close();
+    delete newdbr;
+    reader.close();
+    DBReader<unsigned int>::removeDb("dataDict");
+    return status;
+}
@@ -1,84 +1,73 @@
-#include "Sequence.h"
-#include "Indexer.h"
-#include "ExtendedSubstitutionMatrix.h"
-#include "SubstitutionMatrix.h"
-#include "ReducedMatrix.h"
-#include "KmerGenerator.h"
-#include "BaseMatrix.h"
-#include "Timer.h"
+// Measures the similar k-mer enumeration of the KmerGenerator in ns per generated k-mer and per
+// query position for random queries.
+// usage: test_kmergeneratorperf [queries] [k-mer threshold] [k-mer size]
 
 #include <iostream>
-#include <unistd.h>
-#include <string>
+#include <chrono>
+#include <random>
+#include <cstdlib>
 
-const char* binary_name = "test_kmergeneratorperf";
-
-int main (int argc, const char * argv[])
-{
-    const size_t kmer_size = 7;
+#include "SubstitutionMatrix.h"
+#include "ExtendedSubstitutionMatrix.h"
+#include "KmerGenerator.h"
+#include "Sequence.h"
+#include "Parameters.h"
 
-    SubstitutionMatrix subMat("../../data/blosum62.out",8.0);
-    std::cout << "Subustitution matrix:\n";
-    std::cout << "lala matrix:\n";
+const char* binary_name = "test_kmergeneratorperf";
 
- //   BaseMatrix::print(subMat.subMatrix, subMat.alphabetSize);
-    std::cout << "\n";
+static std::string randomSequence(std::mt19937 &rng, std::discrete_distribution<int> &residues,
+                                  const BaseMatrix &subMat, size_t length) {
+    std::string seq(length, 'A');
+    for (size_t i = 0; i < length; i++) {
+        seq[i] = subMat.num2aa[residues(rng)];
+    }
+    return seq;
+}
 
-    std::cout << "subMatrix:\n";
-//    ReducedMatrix redMat(subMat.probMatrix, 20);
- //   BaseMatrix::print(redMat.subMatrix, redMat.alphabetSize);
-    std::cout << "\n";
- 
-    const int  testSeq[]={1,2,3,1,1,1};
-    ExtendedSubstitutionMatrix extMattwo(subMat.subMatrix, 2,subMat.alphabetSize);
-    ExtendedSubstitutionMatrix extMatthree(subMat.subMatrix, 3,subMat.alphabetSize);
+int main (int argc, const char** argv) {
+    const size_t querySize = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000;
+    const short kmerThr = (argc > 2) ? atoi(argv[2]) : 112;
+    const int kmerSize = (argc > 3) ? atoi(argv[3]) : 6;
+    const size_t seqLen = 300;
 
-    Indexer idx(subMat.alphabetSize,kmer_size);
-    
-    std::cout << "Sequence (id 0):\n";
-    char* sequence = (char *) argv[1];
-    std::cout << sequence << "\n\n";
- 
-    Sequence* s = new Sequence (10000, subMat.aa2num, subMat.num2aa,0);
-    s->mapSequence(0,"lala",sequence);
-    
-    printf("Normal alphabet : ");
-    for(int i = 0; i<subMat.alphabetSize;i++)
-        printf("%c\t",subMat.num2aa[i]);
-    printf("\nNormal int code: ");
-    for(int i = 'A'; i<'Z';i++)
-        printf("%d\t",subMat.aa2num[i]);
-    
-    
-    std::cout << "\nInt reduced sequence:\n";
-    for (int i = 0; i < s->L; i++)
-        std::cout << s->int_sequence[i] << " ";
-    std::cout << "\nChar reduced sequence:\n";
-    
-    KmerGenerator kmerGen(kmer_size,subMat.alphabetSize,10);
-    kmerGen.setDivideStrategy(extMatthree.scoreMatrix, extMattwo.scoreMatrix );
-    
-    int* testKmer = new int[kmer_size];
-    Timer timer;
-    for (int x = 0; x <10; x++) {
-	    s->mapSequence(x, "LALA", sequence);
-        int i = 0;
-        while (s->hasNextKmer(kmer_size)) {
-            const int * curr_pos = s->nextKmer(kmer_size);
-            printf("pos: %d kmerpos1: %d\tkmerpos2: %d\n",i++,curr_pos[0],curr_pos[1]);
+    Parameters& par = Parameters::getInstance();
+    SubstitutionMatrix subMat(par.seedScoringMatrixFile.aminoacids, 8.0, -0.2f);
+    ScoreMatrix twoMer = ExtendedSubstitutionMatrix::calcScoreMatrix(subMat, 2);
+    ScoreMatrix threeMer = ExtendedSubstitutionMatrix::calcScoreMatrix(subMat, 3);
 
-            unsigned int idx_val=idx.int2index(curr_pos);
-            std::cout << "Index:    " <<idx_val << "\n";
-    //        std::cout << "MaxScore: " << extMattwo.scoreMatrix[idx_val]->back().first<< "\n";
+    // residues drawn from the background distribution, X is never sampled
+    std::mt19937 rng(42);
+    std::discrete_distribution<int> residues(subMat.pBack, subMat.pBack + subMat.alphabetSize - 1);
+    std::vector<std::string> querySeqs;
+    for (size_t i = 0; i < querySize; i++) {
+        querySeqs.push_back(randomSequence(rng, residues, subMat, seqLen));
+    }
 
-            ScoreMatrix kmer_list = kmerGen.generateKmerList(curr_pos);
+    Sequence seq(seqLen + 1, Parameters::DBTYPE_AMINO_ACIDS, &subMat, kmerSize, false, false);
+    KmerGenerator kmerGenerator(kmerSize, subMat.alphabetSize, kmerThr);
+    kmerGenerator.setDivideStrategy(&threeMer, &twoMer);
 
-            std::cout << "Similar k-mer list size:" << kmer_list.elementSize << "\n\n";
-            std::cout << "Similar " << kmer_size << "-mer list for pos 0:\n";
+    // the first round warms up the caches
+    for (size_t round = 0; round < 2; round++) {
+        size_t kmerCount = 0;
+        size_t positionCount = 0;
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < querySize; i++) {
+            seq.mapSequence(i, i, querySeqs[i].c_str(), querySeqs[i].size());
+            while (seq.hasNextKmer()) {
+                const unsigned char *kmer = seq.nextKmer();
+                kmerCount += kmerGenerator.generateKmerList(kmer).second;
+                positionCount++;
+            }
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+        if (round == 1) {
+            std::cout << kmerCount << " k-mers, " << (elapsed.count() / kmerCount) << " ns/k-mer, "
+                      << (elapsed.count() / positionCount) << " ns/position\n";
         }
     }
-    std::cout << "Time: " << timer.lap() << "\n";
 
+    ExtendedSubstitutionMatrix::freeScoreMatrix(twoMer);
+    ExtendedSubstitutionMatrix::freeScoreMatrix(threeMer);
     return EXIT_SUCCESS;
 }
-
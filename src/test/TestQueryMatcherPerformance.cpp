@@ -0,0 +1,116 @@
+// Measures the k-mer lookups of QueryMatcher::match in ns per similar k-mer for different
+// prefetch distances (distance 0 matches without prefetching).
+// usage: test_querymatcherperformance [db sequences] [queries] [k-mer threshold]
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+
+#include "SubstitutionMatrix.h"
+#include "ExtendedSubstitutionMatrix.h"
+#include "IndexTable.h"
+#include "QueryMatcher.h"
+#include "Parameters.h"
+
+const char* binary_name = "test_querymatcherperformance";
+
+class QueryMatcherBenchmark : public QueryMatcher {
+public:
+    QueryMatcherBenchmark(IndexTable *indexTable, BaseMatrix *subMat, short kmerThr, int kmerSize,
+                          size_t dbSize, unsigned int maxSeqLen)
+            : QueryMatcher(indexTable, NULL, subMat, subMat, kmerThr, kmerSize, dbSize, maxSeqLen,
+                           300, false, false, 0, false) {}
+
+    // only the k-mer matching, without score computation and result sorting
+    size_t matchOnly(Sequence *seq, size_t &kmerCount) {
+        seq->resetCurrPos();
+        memset(compositionBias, 0, sizeof(float) * seq->L);
+        size_t hits = match(seq, compositionBias);
+        kmerCount += static_cast<size_t>(stats->kmersPerPos * stats->querySeqLen + 0.5);
+        return hits;
+    }
+};
+
+static std::string randomSequence(std::mt19937 &rng, std::discrete_distribution<int> &residues,
+                                  const BaseMatrix &subMat, size_t length) {
+    std::string seq(length, 'A');
+    for (size_t i = 0; i < length; i++) {
+        seq[i] = subMat.num2aa[residues(rng)];
+    }
+    return seq;
+}
+
+int main (int argc, const char** argv) {
+    const size_t dbSize = (argc > 1) ? strtoull(argv[1], NULL, 10) : 50000;
+    const size_t querySize = (argc > 2) ? strtoull(argv[2], NULL, 10) : 200;
+    const short kmerThr = (argc > 3) ? atoi(argv[3]) : 112;
+    const int kmerSize = 6;
+    const size_t seqLen = 300;
+
+    Parameters& par = Parameters::getInstance();
+    SubstitutionMatrix subMat(par.seedScoringMatrixFile.aminoacids, 8.0, -0.2f);
+    ScoreMatrix twoMer = ExtendedSubstitutionMatrix::calcScoreMatrix(subMat, 2);
+    ScoreMatrix threeMer = ExtendedSubstitutionMatrix::calcScoreMatrix(subMat, 3);
+
+    // residues drawn from the background distribution, X is never sampled
+    std::mt19937 rng(42);
+    std::discrete_distribution<int> residues(subMat.pBack, subMat.pBack + subMat.alphabetSize - 1);
+    std::vector<std::string> dbSeqs;
+    for (size_t i = 0; i < dbSize; i++) {
+        dbSeqs.push_back(randomSequence(rng, residues, subMat, seqLen));
+    }
+
+    Sequence seq(seqLen + 1, Parameters::DBTYPE_AMINO_ACIDS, &subMat, kmerSize, true, false);
+    IndexTable indexTable(subMat.alphabetSize, kmerSize, false);
+    Indexer idxer(subMat.alphabetSize, kmerSize);
+    IndexEntryLocalTmp *buffer = new IndexEntryLocalTmp[seqLen];
+    for (size_t i = 0; i < dbSize; i++) {
+        seq.mapSequence(i, i, dbSeqs[i].c_str(), dbSeqs[i].size());
+        size_t kmers = indexTable.extractUniqueKmers(&seq, &idxer, buffer, 0, NULL);
+        indexTable.addKmerCount(buffer, kmers);
+    }
+    indexTable.initMemory(dbSize);
+    indexTable.init();
+    for (size_t i = 0; i < dbSize; i++) {
+        seq.mapSequence(i, i, dbSeqs[i].c_str(), dbSeqs[i].size());
+        size_t kmers = indexTable.extractUniqueKmers(&seq, &idxer, buffer, 0, NULL);
+        indexTable.addKmers(buffer, kmers);
+    }
+    indexTable.revertPointer();
+    delete[] buffer;
+    std::cout << "Index table: " << dbSize << " sequences, " << indexTable.getTableEntriesNum() << " entries\n";
+
+    std::vector<std::string> querySeqs;
+    for (size_t i = 0; i < querySize; i++) {
+        querySeqs.push_back(randomSequence(rng, residues, subMat, seqLen));
+    }
+
+    QueryMatcherBenchmark matcher(&indexTable, &subMat, kmerThr, kmerSize, dbSize, seqLen + 1);
+    matcher.setSubstitutionMatrix(&threeMer, &twoMer);
+    // warm up the page tables and caches before the first measurement
+    size_t warmupCount = 0;
+    for (size_t i = 0; i < querySize; i++) {
+        seq.mapSequence(i, i, querySeqs[i].c_str(), querySeqs[i].size());
+        matcher.matchOnly(&seq, warmupCount);
+    }
+    const unsigned int distances[] = {0, 4, 8, 16, 32};
+    for (size_t d = 0; d < sizeof(distances) / sizeof(distances[0]); d++) {
+        matcher.setPrefetchDistance(distances[d]);
+        size_t kmerCount = 0;
+        size_t hitCount = 0;
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < querySize; i++) {
+            seq.mapSequence(i, i, querySeqs[i].c_str(), querySeqs[i].size());
+            hitCount += matcher.matchOnly(&seq, kmerCount);
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+        std::cout << "prefetch distance " << distances[d] << ": " << kmerCount << " k-mers, "
+                  << hitCount << " hits, " << (elapsed.count() / kmerCount) << " ns/k-mer\n";
+    }
+
+    ExtendedSubstitutionMatrix::freeScoreMatrix(twoMer);
+    ExtendedSubstitutionMatrix::freeScoreMatrix(threeMer);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Debug.h"
+#include "FileUtil.h"
+#include "Parameters.h"
+#include "Util.h"
+
+#include <map>
+
+int appendclusters(int argc, const char **argv, const Command& command) {
+    Parameters& par = Parameters::getInstance();
+    par.parseParameters(argc, argv, command, true, Parameters::PARSE_VARIADIC, 0);
+
+    if (par.filenames.size() <= 2) {
+        Debug(Debug::ERROR) << "Need at least one database to append\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (par.db1 == par.db2) {
+        Debug(Debug::ERROR) << "Cannot append to the input cluster database in place\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    DBReader<unsigned int> clusterReader(par.db1.c_str(), par.db1Index.c_str(), 1, DBReader<unsigned int>::USE_DATA | DBReader<unsigned int>::USE_INDEX);
+    clusterReader.open(DBReader<unsigned int>::NOSORT);
+    if (clusterReader.isCompressed()) {
+        Debug(Debug::ERROR) << "Compressed cluster databases cannot be appended to. Use mergedbs and concatdbs instead\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    // skip par.db{1,2}
+    const size_t fileCount = par.filenames.size() - 2;
+    DBReader<unsigned int> **filesToAppend = new DBReader<unsigned int>*[fileCount];
+    for (size_t i = 0; i < fileCount; i++) {
+        std::string indexName = par.filenames[i + 2] + ".index";
+        filesToAppend[i] = new DBReader<unsigned int>(par.filenames[i + 2].c_str(), indexName.c_str(), 1, DBReader<unsigned int>::USE_DATA | DBReader<unsigned int>::USE_INDEX);
+        filesToAppend[i]->open(DBReader<unsigned int>::NOSORT);
+    }
+
+    // the data of the old clustering is reused as is: its data files become the first files of the
+    // multi-file output database, only changed and new clusters are written to one additional data file
+    std::vector<std::string> oldDataFiles = clusterReader.getDataFileNames();
+    // data files of a previous output with more files would be picked up as part of the new database
+    std::vector<std::string> staleDataFiles = FileUtil::findDatafiles(par.db2.c_str());
+    for (size_t i = 0; i < staleDataFiles.size(); i++) {
+        FileUtil::remove(staleDataFiles[i].c_str());
+    }
+    for (size_t i = 0; i < oldDataFiles.size(); i++) {
+        std::string outFile = par.db2 + "." + SSTR(i);
+        FileUtil::linkOrCopyFile(oldDataFiles[i].c_str(), outFile.c_str());
+    }
+    const size_t baseOffset = clusterReader.getTotalDataSize();
+
+    std::string deltaFile = par.db2 + "." + SSTR(oldDataFiles.size());
+    FILE *deltaFh = FileUtil::openAndDelete(deltaFile.c_str(), "w");
+
+    // collect all keys that gain members or are new clusters
+    std::map<unsigned int, std::pair<size_t, size_t>> changed;
+    for (size_t i = 0; i < fileCount; i++) {
+        for (size_t id = 0; id < filesToAppend[i]->getSize(); id++) {
+            changed[filesToAppend[i]->getDbKey(id)] = std::make_pair(0, 0);
+        }
+    }
+
+    Debug(Debug::INFO) << "Appending " << changed.size() << " changed clusters to " << par.db2 << "\n";
+    Debug::Progress progress(changed.size());
+    const char nullByte = '\0';
+    size_t deltaOffset = 0;
+    for (std::map<unsigned int, std::pair<size_t, size_t>>::iterator it = changed.begin(); it != changed.end(); ++it) {
+        progress.updateProgress();
+        const unsigned int key = it->first;
+        size_t length = 0;
+        size_t clusterId = clusterReader.getId(key);
+        if (clusterId != UINT_MAX) {
+            const size_t entryLength = clusterReader.getEntryLen(clusterId) - 1;
+            fwrite(clusterReader.getData(clusterId, 0), sizeof(char), entryLength, deltaFh);
+            length += entryLength;
+        }
+        for (size_t i = 0; i < fileCount; i++) {
+            size_t entryId = filesToAppend[i]->getId(key);
+            if (entryId == UINT_MAX) {
+                continue;
+            }
+            const size_t entryLength = filesToAppend[i]->getEntryLen(entryId) - 1;
+            fwrite(filesToAppend[i]->getData(entryId, 0), sizeof(char), entryLength, deltaFh);
+            length += entryLength;
+        }
+        if (fwrite(&nullByte, sizeof(char), 1, deltaFh) != 1) {
+            Debug(Debug::ERROR) << "Could not write to data file " << deltaFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        length += 1;
+        it->second = std::make_pair(baseOffset + deltaOffset, length);
+        deltaOffset += length;
+    }
+    if (fclose(deltaFh) != 0) {
+        Debug(Debug::ERROR) << "Cannot close data file " << deltaFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (deltaOffset == 0) {
+        FileUtil::remove(deltaFile.c_str());
+    }
+
+    // merge the unchanged entries of the old index with the changed ones, both are sorted by key
+    FILE *indexFh = FileUtil::openAndDelete(par.db2Index.c_str(), "w");
+    char buffer[1024];
+    DBReader<unsigned int>::Index *index = clusterReader.getIndex();
+    std::map<unsigned int, std::pair<size_t, size_t>>::const_iterator it = changed.begin();
+    for (size_t id = 0; id < clusterReader.getSize(); id++) {
+        while (it != changed.end() && it->first < index[id].id) {
+            DBReader<unsigned int>::Index entry = {it->first, it->second.first, static_cast<unsigned int>(it->second.second)};
+            DBWriter::writeIndexEntryToFile(indexFh, buffer, entry);
+            ++it;
+        }
+        if (it != changed.end() && it->first == index[id].id) {
+            DBReader<unsigned int>::Index entry = {it->first, it->second.first, static_cast<unsigned int>(it->second.second)};
+            DBWriter::writeIndexEntryToFile(indexFh, buffer, entry);
+            ++it;
+            continue;
+        }
+        DBWriter::writeIndexEntryToFile(indexFh, buffer, index[id]);
+    }
+    for (; it != changed.end(); ++it) {
+        DBReader<unsigned int>::Index entry = {it->first, it->second.first, static_cast<unsigned int>(it->second.second)};
+        DBWriter::writeIndexEntryToFile(indexFh, buffer, entry);
+    }
+    if (fclose(indexFh) != 0) {
+        Debug(Debug::ERROR) << "Cannot close index file " << par.db2Index << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    DBWriter::writeDbtypeFile(par.db2.c_str(), clusterReader.getDbtype(), false);
+
+    for (size_t i = 0; i < fileCount; i++) {
+        filesToAppend[i]->close();
+        delete filesToAppend[i];
+    }
+    delete[] filesToAppend;
+    clusterReader.close();
+
+    return EXIT_SUCCESS;
+}
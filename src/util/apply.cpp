@@ -238,6 +238,164 @@ int apply_by_entry(char* data, size_t size, unsigned int key, DBWriter& writer,
     return WEXITSTATUS(status);
 }
 
+// A persistent worker receives each entry as "key\tsize\n" followed by size bytes on its stdin and answers
+// with "status\tsize\n" followed by size bytes on its stdout. The next entry is only sent after the answer
+// was read completely, so the program can read exactly size bytes with buffered I/O.
+struct persistent_worker_s {
+    pid_t pid;
+    int fd[2];
+};
+
+bool start_worker(persistent_worker_s& worker, const char* program_name, char ** program_argv, char **environ) {
+    worker.pid = create_pipe(program_name, program_argv, environ, worker.fd);
+    return worker.pid != -1;
+}
+
+void stop_worker(persistent_worker_s& worker, bool terminate) {
+    if (worker.pid == -1) {
+        return;
+    }
+    // a worker in an unknown protocol state might still wait for input
+    if (terminate) {
+        kill(worker.pid, SIGKILL);
+    }
+    // end of input tells the program to exit
+    close(worker.fd[1]);
+    close(worker.fd[0]);
+    int status = 0;
+    while (waitpid(worker.pid, &status, 0) == -1) {
+        if (errno == EINTR) {
+            continue;
+        }
+        perror("waitpid");
+        break;
+    }
+    worker.pid = -1;
+}
+
+int apply_by_worker(persistent_worker_s& worker, char* data, size_t size, unsigned int key, DBWriter& writer, unsigned int proc_idx) {
+    char header[64];
+    const size_t header_size = snprintf(header, sizeof(header), "%u\t%zu\n", key, size);
+    size_t header_written = 0;
+    size_t written = 0;
+
+    char answer[64];
+    size_t answer_size = 0;
+    bool answer_started = false;
+    int status = 0;
+    size_t expected = 0;
+    size_t received = 0;
+    int error = 0;
+
+    char buffer[PIPE_BUF];
+    writer.writeStart(proc_idx);
+    struct pollfd plist[2];
+    for (;;) {
+        const bool write_done = header_written == header_size && written == size;
+        const bool read_done = answer_started && received == expected;
+        if (write_done && read_done) {
+            break;
+        }
+
+        plist[0].fd = write_done ? -1 : worker.fd[1];
+        plist[0].events = POLLOUT;
+        plist[0].revents = 0;
+
+        plist[1].fd = read_done ? -1 : worker.fd[0];
+        plist[1].events = POLLIN;
+        plist[1].revents = 0;
+
+        if (poll(plist, 2, -1) == -1) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            error = errno;
+            break;
+        }
+
+        if (plist[0].revents & POLLOUT) {
+            ssize_t w;
+            if (header_written < header_size) {
+                w = write(worker.fd[1], header + header_written, header_size - header_written);
+            } else {
+                w = write(worker.fd[1], data + written, std::min(size - written, static_cast<size_t>(PIPE_BUF)));
+            }
+            if (w < 0) {
+                if (errno != EAGAIN && errno != EINTR) {
+                    perror("write stdin");
+                    error = errno;
+                    break;
+                }
+            } else if (header_written < header_size) {
+                header_written += w;
+            } else {
+                written += w;
+            }
+        } else if (plist[0].revents & (POLLERR | POLLHUP)) {
+            // the program closed its input
+            error = EPIPE;
+            break;
+        }
+
+        if (plist[1].revents & (POLLIN | POLLHUP)) {
+            const size_t max_read = answer_started ? std::min(sizeof(buffer), expected - received) : sizeof(buffer);
+            ssize_t bytes_read = read(worker.fd[0], buffer, max_read);
+            if (bytes_read < 0) {
+                if (errno != EAGAIN && errno != EINTR) {
+                    perror("read stdout");
+                    error = errno;
+                    break;
+                }
+                continue;
+            }
+            if (bytes_read == 0) {
+                // the program exited before answering
+                error = EPIPE;
+                break;
+            }
+            char *pos = buffer;
+            size_t length = bytes_read;
+            if (answer_started == false) {
+                char *newline = (char*)memchr(pos, '\n', length);
+                size_t part = (newline != NULL) ? (newline - pos + 1) : length;
+                if (answer_size + part >= sizeof(answer)) {
+                    error = EPROTO;
+                    break;
+                }
+                memcpy(answer + answer_size, pos, part);
+                answer_size += part;
+                pos += part;
+                length -= part;
+                if (newline != NULL) {
+                    answer[answer_size] = '\0';
+                    if (sscanf(answer, "%d\t%zu", &status, &expected) != 2) {
+                        error = EPROTO;
+                        break;
+                    }
+                    answer_started = true;
+                }
+            }
+            if (length > 0) {
+                if (answer_started == false || length > expected - received) {
+                    error = EPROTO;
+                    break;
+                }
+                writer.writeAdd(pos, length, proc_idx);
+                received += length;
+            }
+        }
+    }
+
+    writer.writeEnd(key, proc_idx, true);
+
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+    return status;
+}
+
 void ignore_signal(int signal) {
     struct sigaction handler;
     handler.sa_handler = SIG_IGN;
@@ -337,6 +495,11 @@ int apply(int argc, const char **argv, const Command& command) {
                 writer.open();
 
                 char **local_environ = local_environment();
+                persistent_worker_s worker;
+                worker.pid = -1;
+                if (par.persistentWorkers) {
+                    snprintf(local_environ[0], 64, "MMSEQS_PERSISTENT_WORKER=1");
+                }
 
                 ignore_signal(SIGPIPE);
                 for (size_t i = 0; i < reader.getSize(); ++i) {
@@ -353,17 +516,33 @@ int apply(int argc, const char **argv, const Command& command) {
                     }
 
                     size_t size = reader.getEntryLen(i) - 1;
-                    int status = apply_by_entry(data, size, key, writer, par.restArgv[0], const_cast<char**>(par.restArgv), local_environ, 0);
+                    int status;
+                    if (par.persistentWorkers) {
+                        if (worker.pid == -1 && start_worker(worker, par.restArgv[0], const_cast<char**>(par.restArgv), local_environ) == false) {
+                            status = -1;
+                        } else {
+                            status = apply_by_worker(worker, data, size, key, writer, 0);
+                            // the program is restarted for the next entry
+                            if (status == -1) {
+                                int error = errno;
+                                stop_worker(worker, true);
+                                errno = error;
+                            }
+                        }
+                    } else {
+                        status = apply_by_entry(data, size, key, writer, par.restArgv[0], const_cast<char**>(par.restArgv), local_environ, 0);
+                    }
                     if (status == -1) {
                         Debug(Debug::WARNING) << "Entry " << key << " system error number " << errno << "!\n";
                         continue;
                     }
                     if (status > 0) {
-                        Debug(Debug::WARNING) << "Entry " << key << " exited with error code " << status << "!\n";
+                        Debug(Debug::WARNING) << "Entry " << key << (par.persistentWorkers ? " returned status " : " exited with error code ") << status << "!\n";
                         continue;
                     }
                 }
 
+                stop_worker(worker, false);
                 writer.close(true);
                 reader.close();
                 free_local_environment(local_environ);
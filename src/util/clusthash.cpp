@@ -9,10 +9,348 @@
 #include "Orf.h"
 #include "FastSort.h"
 
+#include <algorithm>
+#include <cmath>
+
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
+static void appendHit(std::string &result, unsigned int key, const char *seqId, unsigned int queryLength, unsigned int targetLength) {
+    result.append(SSTR(key));
+    result.append("\t255\t");
+    result.append(seqId);
+    result.append("\t0\t0\t");
+    result.append(SSTR(queryLength - 1));
+    result.append(1, '\t');
+    result.append(SSTR(queryLength));
+    result.append("\t0\t");
+    result.append(SSTR(targetLength - 1));
+    result.append(1, '\t');
+    result.append(SSTR(targetLength));
+    result.append(1, '\n');
+}
+
+// the lowest hashes of the mixed k-mer codes are a random sample of the k-mers
+static inline size_t mixKmer(size_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static inline size_t nuclCode(char c) {
+    switch (c) {
+        case 'C': case 'c': return 1;
+        case 'G': case 'g': return 2;
+        case 'T': case 't': case 'U': case 'u': return 3;
+        default: return 0;
+    }
+}
+
+// computes the sorted, distinct hashes of the window minimizers of a sequence. Minimizers only depend on
+// their neighborhood, a sequence contained in a longer one shares almost all of its minimizers with it.
+// Nucleotide k-mers are canonical, a sequence and its reverse complement have the same minimizers
+static void computeMinimizers(const char *seq, size_t length, bool isNucl, std::vector<size_t> &kmerHashes,
+                              std::vector<size_t> &minimizers) {
+    const size_t kmerSize = isNucl ? Parameters::CLUST_HASH_SKETCH_NUCL_KMER_SIZE : Parameters::CLUST_HASH_SKETCH_AA_KMER_SIZE;
+    const size_t window = Parameters::CLUST_HASH_SKETCH_WINDOW;
+    kmerHashes.clear();
+    minimizers.clear();
+    if (length < kmerSize) {
+        return;
+    }
+    const size_t bits = isNucl ? 2 : 5;
+    const size_t mask = (kmerSize * bits < 64) ? ((1ULL << (kmerSize * bits)) - 1) : SIZE_MAX;
+    size_t forward = 0;
+    size_t reverse = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (isNucl) {
+            const size_t code = nuclCode(seq[i]);
+            forward = ((forward << 2) | code) & mask;
+            reverse = (reverse >> 2) | ((3 - code) << (2 * (kmerSize - 1)));
+        } else {
+            // five bits distinguish all letters independent of their case
+            forward = ((forward << 5) | (static_cast<size_t>(seq[i]) & 31)) & mask;
+            reverse = forward;
+        }
+        if (i + 1 >= kmerSize) {
+            kmerHashes.push_back(mixKmer(std::min(forward, reverse)));
+        }
+    }
+    const size_t kmerCount = kmerHashes.size();
+    const size_t windowCount = (kmerCount > window) ? kmerCount - window + 1 : 1;
+    for (size_t start = 0; start < windowCount; start++) {
+        const size_t end = std::min(start + window, kmerCount);
+        size_t minHash = kmerHashes[start];
+        for (size_t i = start + 1; i < end; i++) {
+            minHash = std::min(minHash, kmerHashes[i]);
+        }
+        if (minimizers.empty() || minimizers.back() != minHash) {
+            minimizers.push_back(minHash);
+        }
+    }
+    std::sort(minimizers.begin(), minimizers.end());
+    minimizers.erase(std::unique(minimizers.begin(), minimizers.end()), minimizers.end());
+}
+
+struct SketchEntry {
+    size_t hash;
+    unsigned int id;
+
+    static bool compareByHashAndId(const SketchEntry &first, const SketchEntry &second) {
+        if (first.hash != second.hash) {
+            return first.hash < second.hash;
+        }
+        return first.id < second.id;
+    }
+};
+
+struct SketchEdge {
+    unsigned int member;
+    unsigned int center;
+    float seqId;
+
+    static bool compareByMember(const SketchEdge &first, const SketchEdge &second) {
+        if (first.member != second.member) {
+            return first.member < second.member;
+        }
+        return first.center < second.center;
+    }
+
+    static bool compareByCenter(const SketchEdge &first, const SketchEdge &second) {
+        if (first.center != second.center) {
+            return first.center < second.center;
+        }
+        return first.member < second.member;
+    }
+};
+
+// Groups near-identical sequences of possibly different lengths in linear time. Each sequence is
+// represented by its sketchSize lowest minimizers. The sketch entries are radix partitioned by their
+// leading hash bits, so that every thread sorts and groups its partitions independently. Within a group
+// of equal hashes every sequence is linked to the longest one, the link is accepted if the shorter
+// sequence shares enough of its minimizers to reach the sequence identity threshold. The sequences are
+// then assigned greedily, from the longest on, to the representatives they are linked to.
+static void clusthashSketch(const Parameters &par, DBReader<unsigned int> &reader, DBWriter &writer, bool isNucl) {
+    const size_t dbSize = reader.getSize();
+    const size_t sketchSize = static_cast<size_t>(par.minimizerSketchSize);
+    const size_t kmerSize = isNucl ? Parameters::CLUST_HASH_SKETCH_NUCL_KMER_SIZE : Parameters::CLUST_HASH_SKETCH_AA_KMER_SIZE;
+    const unsigned int partitionBits = 10;
+    const size_t partitionCount = 1 << partitionBits;
+
+    Debug(Debug::INFO) << "Sketching sequences...\n";
+    std::vector<size_t> sketches(dbSize * sketchSize);
+    std::vector<unsigned int> sketchLengths(dbSize, 0);
+    std::vector<size_t> partitionOffsets(static_cast<size_t>(par.threads) * partitionCount, 0);
+    std::vector<SketchEntry> entries;
+    Debug::Progress progress(dbSize);
+#pragma omp parallel
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        std::vector<size_t> kmerHashes;
+        std::vector<size_t> minimizers;
+        size_t *counts = &partitionOffsets[thread_idx * partitionCount];
+        // both loops use the same static schedule, each thread scatters the entries it counted
+#pragma omp for schedule(static)
+        for (size_t id = 0; id < dbSize; ++id) {
+            progress.updateProgress();
+            computeMinimizers(reader.getData(id, thread_idx), reader.getSeqLen(id), isNucl, kmerHashes, minimizers);
+            const size_t length = std::min(sketchSize, minimizers.size());
+            for (size_t i = 0; i < length; i++) {
+                sketches[id * sketchSize + i] = minimizers[i];
+                counts[minimizers[i] >> (64 - partitionBits)]++;
+            }
+            sketchLengths[id] = length;
+        }
+
+#pragma omp single
+        {
+            // partition p of thread t starts behind all smaller partitions and partition p of the threads before t
+            size_t offset = 0;
+            for (size_t partition = 0; partition < partitionCount; partition++) {
+                for (size_t thread = 0; thread < static_cast<size_t>(par.threads); thread++) {
+                    const size_t count = partitionOffsets[thread * partitionCount + partition];
+                    partitionOffsets[thread * partitionCount + partition] = offset;
+                    offset += count;
+                }
+            }
+            entries.resize(offset);
+        }
+
+#pragma omp for schedule(static)
+        for (size_t id = 0; id < dbSize; ++id) {
+            for (size_t i = 0; i < sketchLengths[id]; i++) {
+                const size_t hash = sketches[id * sketchSize + i];
+                SketchEntry &entry = entries[counts[hash >> (64 - partitionBits)]++];
+                entry.hash = hash;
+                entry.id = id;
+            }
+        }
+    }
+    std::vector<size_t>().swap(sketches);
+    // after the scatter the offsets of the last thread point to the end of each partition
+    std::vector<size_t> partitionEnds(partitionCount + 1, 0);
+    for (size_t partition = 0; partition < partitionCount; partition++) {
+        partitionEnds[partition + 1] = partitionOffsets[(par.threads - 1) * partitionCount + partition];
+    }
+
+    Debug(Debug::INFO) << "Linking sequences with shared minimizers...\n";
+    std::vector<SketchEdge> edges;
+#pragma omp parallel
+    {
+        std::vector<SketchEdge> threadEdges;
+#pragma omp for schedule(dynamic, 1)
+        for (size_t partition = 0; partition < partitionCount; partition++) {
+            SketchEntry *begin = entries.data() + partitionEnds[partition];
+            SketchEntry *end = entries.data() + partitionEnds[partition + 1];
+            SORT_SERIAL(begin, end, SketchEntry::compareByHashAndId);
+            for (SketchEntry *group = begin; group < end;) {
+                SketchEntry *groupEnd = group + 1;
+                unsigned int center = group->id;
+                while (groupEnd < end && groupEnd->hash == group->hash) {
+                    // the ids are sorted, the first of the longest sequences is the center
+                    if (reader.getSeqLen(groupEnd->id) > reader.getSeqLen(center)) {
+                        center = groupEnd->id;
+                    }
+                    groupEnd++;
+                }
+                for (SketchEntry *entry = group; entry < groupEnd; entry++) {
+                    if (entry->id != center) {
+                        SketchEdge edge;
+                        edge.member = entry->id;
+                        edge.center = center;
+                        edge.seqId = 0.0f;
+                        threadEdges.push_back(edge);
+                    }
+                }
+                group = groupEnd;
+            }
+        }
+#pragma omp critical (clusthashEdges)
+        edges.insert(edges.end(), threadEdges.begin(), threadEdges.end());
+    }
+    std::vector<SketchEntry>().swap(entries);
+    SORT_PARALLEL(edges.begin(), edges.end(), SketchEdge::compareByMember);
+    edges.erase(std::unique(edges.begin(), edges.end(), [](const SketchEdge &first, const SketchEdge &second) {
+        return first.member == second.member && first.center == second.center;
+    }), edges.end());
+
+    Debug(Debug::INFO) << "Verifying " << edges.size() << " links...\n";
+    const float seqIdThr = par.seqIdThr;
+#pragma omp parallel
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        std::vector<size_t> kmerHashes;
+        std::vector<size_t> memberMinimizers;
+        std::vector<size_t> centerMinimizers;
+        unsigned int lastMember = UINT_MAX;
+#pragma omp for schedule(dynamic, 100)
+        for (size_t i = 0; i < edges.size(); i++) {
+            SketchEdge &edge = edges[i];
+            if (edge.member != lastMember) {
+                computeMinimizers(reader.getData(edge.member, thread_idx), reader.getSeqLen(edge.member), isNucl, kmerHashes, memberMinimizers);
+                lastMember = edge.member;
+            }
+            computeMinimizers(reader.getData(edge.center, thread_idx), reader.getSeqLen(edge.center), isNucl, kmerHashes, centerMinimizers);
+            size_t shared = 0;
+            std::vector<size_t>::const_iterator memberIt = memberMinimizers.begin();
+            std::vector<size_t>::const_iterator centerIt = centerMinimizers.begin();
+            while (memberIt != memberMinimizers.end() && centerIt != centerMinimizers.end()) {
+                if (*memberIt < *centerIt) {
+                    ++memberIt;
+                } else if (*centerIt < *memberIt) {
+                    ++centerIt;
+                } else {
+                    shared++;
+                    ++memberIt;
+                    ++centerIt;
+                }
+            }
+            // a k-mer survives with probability seqId^k, the shared fraction estimates the identity
+            const float containment = static_cast<float>(shared) / static_cast<float>(memberMinimizers.size());
+            const float seqId = std::pow(containment, 1.0f / static_cast<float>(kmerSize));
+            edge.seqId = (seqId >= seqIdThr) ? seqId : -1.0f;
+        }
+    }
+    edges.erase(std::remove_if(edges.begin(), edges.end(), [](const SketchEdge &edge) {
+        return edge.seqId < 0.0f;
+    }), edges.end());
+    SORT_PARALLEL(edges.begin(), edges.end(), SketchEdge::compareByCenter);
+    std::vector<size_t> centerOffsets(dbSize + 1, 0);
+    for (size_t i = 0; i < edges.size(); i++) {
+        centerOffsets[edges[i].center + 1]++;
+    }
+    for (size_t id = 0; id < dbSize; id++) {
+        centerOffsets[id + 1] += centerOffsets[id];
+    }
+
+    // greedy assignment from the longest sequence on, members of a representative cannot be representatives
+    std::vector<unsigned int> order(dbSize);
+    for (size_t id = 0; id < dbSize; id++) {
+        order[id] = id;
+    }
+    SORT_PARALLEL(order.begin(), order.end(), [&reader](unsigned int first, unsigned int second) {
+        if (reader.getSeqLen(first) != reader.getSeqLen(second)) {
+            return reader.getSeqLen(first) > reader.getSeqLen(second);
+        }
+        return first < second;
+    });
+    std::vector<unsigned int> representative(dbSize, UINT_MAX);
+    std::vector<char> keepEdge(edges.size(), false);
+    size_t representativeCount = 0;
+    for (size_t i = 0; i < dbSize; i++) {
+        const unsigned int id = order[i];
+        if (representative[id] != UINT_MAX) {
+            continue;
+        }
+        representative[id] = id;
+        representativeCount++;
+        for (size_t edgeIdx = centerOffsets[id]; edgeIdx < centerOffsets[id + 1]; edgeIdx++) {
+            if (representative[edges[edgeIdx].member] == UINT_MAX) {
+                representative[edges[edgeIdx].member] = id;
+                keepEdge[edgeIdx] = true;
+            }
+        }
+    }
+    Debug(Debug::INFO) << "Found " << representativeCount << " representatives\n";
+
+    Debug::Progress writeProgress(dbSize);
+#pragma omp parallel
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        std::string result;
+        result.reserve(1024);
+        char buffer[64];
+#pragma omp for schedule(dynamic, 100)
+        for (size_t id = 0; id < dbSize; ++id) {
+            writeProgress.updateProgress();
+            const unsigned int queryLength = reader.getSeqLen(id);
+            appendHit(result, reader.getDbKey(id), "1.00", queryLength, queryLength);
+            for (size_t edgeIdx = centerOffsets[id]; edgeIdx < centerOffsets[id + 1]; edgeIdx++) {
+                if (keepEdge[edgeIdx]) {
+                    const SketchEdge &edge = edges[edgeIdx];
+                    Util::fastSeqIdToBuffer(edge.seqId, buffer);
+                    appendHit(result, reader.getDbKey(edge.member), buffer, queryLength, reader.getSeqLen(edge.member));
+                }
+            }
+            writer.writeData(result.c_str(), result.length(), reader.getDbKey(id), thread_idx);
+            result.clear();
+        }
+    }
+}
+
 int clusthash(int argc, const char **argv, const Command &command) {
     Parameters &par = Parameters::getInstance();
     par.alphabetSize = MultiParam<int>(Parameters::CLUST_HASH_DEFAULT_ALPH_SIZE,5);
@@ -34,6 +372,15 @@ int clusthash(int argc, const char **argv, const Command &command) {
 
     DBWriter writer(par.db2.c_str(), par.db2Index.c_str(), par.threads, par.compressed, Parameters::DBTYPE_ALIGNMENT_RES);
     writer.open();
+    if (par.minimizerSketchSize > 0) {
+        clusthashSketch(par, reader, writer, isNuclInput);
+        writer.close();
+        reader.close();
+        if (subMat != NULL) {
+            delete subMat;
+        }
+        return EXIT_SUCCESS;
+    }
     Debug(Debug::INFO) << "Hashing sequences...\n";
     std::pair<size_t, unsigned int> *hashSeqPair = new std::pair<size_t, unsigned int>[reader.getSize() + 1];
     // needed later to check if one of array
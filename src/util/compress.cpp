@@ -25,6 +25,20 @@ int doCompression(int argc, const char **argv, const Command& command, bool shou
     int dbtype = reader.getDbtype();
     dbtype = shouldCompress ? dbtype | (1 << 31) : dbtype & ~(1 << 31);
     DBWriter writer(par.db2.c_str(), par.db2Index.c_str(), par.threads, shouldCompress, dbtype);
+    if (shouldCompress == true && par.compressionDict == true) {
+        // train on evenly spaced entries, so that sorted databases are sampled from all parts
+        std::string samples;
+        std::vector<size_t> sampleSizes;
+        size_t step = std::max(static_cast<size_t>(1), reader.getDataSize() / DBWriter::DICTIONARY_SAMPLE_SIZE);
+        for (size_t i = 0; i < reader.getSize() && samples.size() < DBWriter::DICTIONARY_SAMPLE_SIZE; i += step) {
+            size_t length = std::max(static_cast<unsigned int>(reader.getEntryLen(i)), 1u) - 1u;
+            if (length > 0) {
+                samples.append(reader.getData(i, 0), length);
+                sampleSizes.push_back(length);
+            }
+        }
+        writer.setDictionary(DBWriter::trainDictionary(samples, sampleSizes));
+    }
     writer.open();
     Debug::Progress progress(reader.getSize());
 
@@ -4,6 +4,7 @@
 #include "Debug.h"
 #include "DBReader.h"
 #include "DBWriter.h"
+#include "OrderedFileWriter.h"
 #include "IndexReader.h"
 #include "FileUtil.h"
 #include "TranslateNucl.h"
@@ -11,12 +12,14 @@
 #include "Orf.h"
 #include "MemoryMapped.h"
 #include "NcbiTaxonomy.h"
+#include "itoa.h"
 
 #define ZSTD_STATIC_LINKING_ONLY
 #include <zstd.h>
 #include "result_viz_prelude.html.zst.h"
 
 #include <map>
+#include <cmath>
 
 #ifdef OPENMP
 #include <omp.h>
@@ -61,6 +64,50 @@ void printSeqBasedOnAln(std::string &out, const char *seq, unsigned int offset,
     }
 }
 
+// the append helpers write the same text as SSTR/printf without temporary strings
+static inline void appendInt(std::string &out, int value) {
+    char buffer[16];
+    char *end = Itoa::i32toa_sse2(value, buffer);
+    out.append(buffer, end - buffer - 1);
+}
+
+static inline void appendUInt(std::string &out, unsigned int value) {
+    char buffer[16];
+    char *end = Itoa::u32toa_sse2(value, buffer);
+    out.append(buffer, end - buffer - 1);
+}
+
+// same as printf("%.3f"), a float times 1000 is exact in double, so rounding half to even matches printf
+static inline void appendFixed3(std::string &out, float value) {
+    double scaled = static_cast<double>(value) * 1000.0;
+    if (!(std::fabs(scaled) < 1e15)) {
+        char buffer[64];
+        int count = snprintf(buffer, sizeof(buffer), "%.3f", value);
+        out.append(buffer, count);
+        return;
+    }
+    double rounded = std::nearbyint(scaled);
+    if (std::signbit(value)) {
+        out.push_back('-');
+        rounded = -rounded;
+    }
+    uint64_t fixed = static_cast<uint64_t>(rounded);
+    char buffer[32];
+    char *end = Itoa::u64toa_sse2(fixed / 1000, buffer);
+    out.append(buffer, end - buffer - 1);
+    const unsigned int fraction = static_cast<unsigned int>(fixed % 1000);
+    out.push_back('.');
+    out.push_back(static_cast<char>('0' + fraction / 100));
+    out.push_back(static_cast<char>('0' + (fraction / 10) % 10));
+    out.push_back(static_cast<char>('0' + fraction % 10));
+}
+
+static inline void appendExp(std::string &out, double value, const char *format) {
+    char buffer[64];
+    int count = snprintf(buffer, sizeof(buffer), format, value);
+    out.append(buffer, count);
+}
+
 /*
 query       Query sequence label
 target      Target sequenc label
@@ -263,12 +310,17 @@ int convertalignments(int argc, const char **argv, const Command &command) {
     localThreads = std::min((unsigned int)par.threads, (unsigned int)alnDbr.getSize());
 #endif
 
-    const bool shouldCompress = par.dbOut == true && par.compressed == true;
-    const int dbType = par.dbOut == true ? Parameters::DBTYPE_GENERIC_DB : Parameters::DBTYPE_OMIT_FILE;
-    DBWriter resultWriter(par.db4.c_str(), par.db4Index.c_str(), localThreads, shouldCompress, dbType);
-    resultWriter.open();
-
     const bool isDb = par.dbOut;
+    // flat files are streamed in query order directly into the output file, without per thread files
+    DBWriter *resultWriter = NULL;
+    OrderedFileWriter *fileWriter = NULL;
+    if (isDb) {
+        resultWriter = new DBWriter(par.db4.c_str(), par.db4Index.c_str(), localThreads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+        resultWriter->open();
+    } else {
+        fileWriter = new OrderedFileWriter(par.db4);
+    }
+
     TranslateNucl translateNucl(static_cast<TranslateNucl::GenCode>(par.translationTable));
 
     if (format == Parameters::FORMAT_ALIGNMENT_SAM) {
@@ -276,9 +328,11 @@ int convertalignments(int argc, const char **argv, const Command &command) {
         unsigned int lastKey = tDbr->sequenceReader->getLastKey();
         bool *headerWritten = new bool[lastKey + 1];
         memset(headerWritten, 0, sizeof(bool) * (lastKey + 1));
-        resultWriter.writeStart(0);
         std::string header = "@HD\tVN:1.4\tSO:queryname\n";
-        resultWriter.writeAdd(header.c_str(), header.size(), 0);
+        if (isDb) {
+            resultWriter->writeStart(0);
+            resultWriter->writeAdd(header.c_str(), header.size(), 0);
+        }
 
         for (size_t i = 0; i < alnDbr.getSize(); i++) {
             char *data = alnDbr.getData(i, 0);
@@ -299,21 +353,36 @@ int convertalignments(int argc, const char **argv, const Command &command) {
                         Debug(Debug::WARNING) << "Truncated line in header " << i << "!\n";
                         continue;
                     }
-                    resultWriter.writeAdd(buffer, count, 0);
+                    if (isDb) {
+                        resultWriter->writeAdd(buffer, count, 0);
+                    } else {
+                        header.append(buffer, count);
+                    }
+                }
+                if (isDb) {
+                    resultWriter->writeEnd(0, 0, false, 0);
                 }
-                resultWriter.writeEnd(0, 0, false, 0);
                 data = Util::skipLine(data);
             }
         }
         delete[] headerWritten;
+        if (isDb == false) {
+            fileWriter->write(0, header.c_str(), header.size());
+        }
     } else if (format == Parameters::FORMAT_ALIGNMENT_HTML) {
         size_t dstSize = ZSTD_findDecompressedSize(result_viz_prelude_html_zst, result_viz_prelude_html_zst_len);
         char* dst = (char*)malloc(sizeof(char) * dstSize);
         size_t realSize = ZSTD_decompress(dst, dstSize, result_viz_prelude_html_zst, result_viz_prelude_html_zst_len);
-        resultWriter.writeData(dst, realSize, 0, 0, false, false);
-        const char* scriptBlock = "<script>render([";
-        resultWriter.writeData(scriptBlock, strlen(scriptBlock), 0, 0, false, false);
+        std::string prelude(dst, realSize);
+        prelude.append("<script>render([");
+        if (isDb) {
+            resultWriter->writeData(prelude.c_str(), prelude.size(), 0, 0, false, false);
+        } else {
+            fileWriter->write(0, prelude.c_str(), prelude.size());
+        }
         free(dst);
+    } else if (isDb == false) {
+        fileWriter->write(0, NULL, 0);
     }
 
     Debug::Progress progress(alnDbr.getSize());
@@ -343,6 +412,11 @@ int convertalignments(int argc, const char **argv, const Command &command) {
         std::string newBacktrace;
         newBacktrace.reserve(1024);
 
+        // parsed target identifiers, most targets are hit by many queries
+        const size_t targetIdCacheSize = 65536;
+        std::vector<size_t> targetIdCacheKeys(targetIdCacheSize, SIZE_MAX);
+        std::vector<std::string> targetIdCache(targetIdCacheSize);
+
         const TaxonNode * taxonNode = NULL;
 
 #pragma omp  for schedule(dynamic, 10)
@@ -380,6 +454,10 @@ int convertalignments(int argc, const char **argv, const Command &command) {
                 int count = snprintf(buffer, sizeof(buffer), jsStart, queryId.c_str(), querySeqData);
                 if (count < 0 || static_cast<size_t>(count) >= sizeof(buffer)) {
                     Debug(Debug::WARNING) << "Truncated line in entry" << i << "!\n";
+                    if (isDb == false) {
+                        // every position of the flat file has to be filled
+                        fileWriter->write(i + 1, NULL, 0);
+                    }
                     continue;
                 }
                 result.append(buffer, count);
@@ -403,9 +481,21 @@ int convertalignments(int argc, const char **argv, const Command &command) {
                 }
 
                 size_t tHeaderId = tDbrHeader->sequenceReader->getId(res.dbKey);
-                const char *tHeader = tDbrHeader->sequenceReader->getData(tHeaderId, thread_idx);
-                size_t tHeaderLen = tDbrHeader->sequenceReader->getSeqLen(tHeaderId);
-                std::string targetId = Util::parseFastaHeader(tHeader);
+                const char *tHeader = NULL;
+                size_t tHeaderLen = 0;
+                if (needFullHeaders) {
+                    tHeader = tDbrHeader->sequenceReader->getData(tHeaderId, thread_idx);
+                    tHeaderLen = tDbrHeader->sequenceReader->getSeqLen(tHeaderId);
+                }
+                const size_t cacheSlot = tHeaderId & (targetIdCacheSize - 1);
+                if (targetIdCacheKeys[cacheSlot] != tHeaderId) {
+                    if (tHeader == NULL) {
+                        tHeader = tDbrHeader->sequenceReader->getData(tHeaderId, thread_idx);
+                    }
+                    targetIdCacheKeys[cacheSlot] = tHeaderId;
+                    targetIdCache[cacheSlot] = Util::parseFastaHeader(tHeader);
+                }
+                const std::string &targetId = targetIdCache[cacheSlot];
 
                 unsigned int gapOpenCount = 0;
                 unsigned int alnLen = res.alnLength;
@@ -448,18 +538,31 @@ int convertalignments(int argc, const char **argv, const Command &command) {
                 switch (format) {
                     case Parameters::FORMAT_ALIGNMENT_BLAST_TAB: {
                         if (outcodes.empty()) {
-                            int count = snprintf(buffer, sizeof(buffer),
-                                                 "%s\t%s\t%1.3f\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%.2E\t%d\n",
-                                                 queryId.c_str(), targetId.c_str(), res.seqId, alnLen,
-                                                 missMatchCount, gapOpenCount,
-                                                 res.qStartPos + 1, res.qEndPos + 1,
-                                                 res.dbStartPos + 1, res.dbEndPos + 1,
-                                                 res.eval, res.score);
-                            if (count < 0 || static_cast<size_t>(count) >= sizeof(buffer)) {
-                                Debug(Debug::WARNING) << "Truncated line in entry" << i << "!\n";
-                                continue;
-                            }
-                            result.append(buffer, count);
+                            // query target fident alnlen mismatch gapopen qstart qend tstart tend evalue bits
+                            result.append(queryId);
+                            result.push_back('\t');
+                            result.append(targetId);
+                            result.push_back('\t');
+                            appendFixed3(result, res.seqId);
+                            result.push_back('\t');
+                            appendInt(result, static_cast<int>(alnLen));
+                            result.push_back('\t');
+                            appendInt(result, static_cast<int>(missMatchCount));
+                            result.push_back('\t');
+                            appendInt(result, static_cast<int>(gapOpenCount));
+                            result.push_back('\t');
+                            appendInt(result, res.qStartPos + 1);
+                            result.push_back('\t');
+                            appendInt(result, res.qEndPos + 1);
+                            result.push_back('\t');
+                            appendInt(result, res.dbStartPos + 1);
+                            result.push_back('\t');
+                            appendInt(result, res.dbEndPos + 1);
+                            result.push_back('\t');
+                            appendExp(result, res.eval, "%.2E");
+                            result.push_back('\t');
+                            appendInt(result, res.score);
+                            result.push_back('\n');
                         } else {
                             char *targetSeqData = NULL;
                             targetProfData.clear();
@@ -498,53 +601,53 @@ int convertalignments(int argc, const char **argv, const Command &command) {
                                         result.append(targetId);
                                         break;
                                     case Parameters::OUTFMT_EVALUE:
-                                        result.append(SSTR(res.eval));
+                                        appendExp(result, res.eval, "%.3E");
                                         break;
                                     case Parameters::OUTFMT_GAPOPEN:
-                                        result.append(SSTR(gapOpenCount));
+                                        appendUInt(result, gapOpenCount);
                                         break;
                                     case Parameters::OUTFMT_FIDENT:
-                                        result.append(SSTR(res.seqId));
+                                        appendFixed3(result, res.seqId);
                                         break;
                                     case Parameters::OUTFMT_PIDENT:
-                                        result.append(SSTR(res.seqId*100));
+                                        appendFixed3(result, res.seqId*100);
                                         break;
                                     case Parameters::OUTFMT_NIDENT:
-                                        result.append(SSTR(identical));
+                                        appendUInt(result, identical);
                                         break;
                                     case Parameters::OUTFMT_QSTART:
-                                        result.append(SSTR(res.qStartPos + 1));
+                                        appendInt(result, res.qStartPos + 1);
                                         break;
                                     case Parameters::OUTFMT_QEND:
-                                        result.append(SSTR(res.qEndPos + 1));
+                                        appendInt(result, res.qEndPos + 1);
                                         break;
                                     case Parameters::OUTFMT_QLEN:
-                                        result.append(SSTR(res.qLen));
+                                        appendUInt(result, res.qLen);
                                         break;
                                     case Parameters::OUTFMT_TSTART:
-                                        result.append(SSTR(res.dbStartPos + 1));
+                                        appendInt(result, res.dbStartPos + 1);
                                         break;
                                     case Parameters::OUTFMT_TEND:
-                                        result.append(SSTR(res.dbEndPos + 1));
+                                        appendInt(result, res.dbEndPos + 1);
                                         break;
                                     case Parameters::OUTFMT_TLEN:
-                                        result.append(SSTR(res.dbLen));
+                                        appendUInt(result, res.dbLen);
                                         break;
                                     case Parameters::OUTFMT_ALNLEN:
-                                        result.append(SSTR(alnLen));
+                                        appendUInt(result, alnLen);
                                         break;
                                     case Parameters::OUTFMT_RAW:
-                                        result.append(SSTR(static_cast<int>(evaluer->computeRawScoreFromBitScore(res.score) + 0.5)));
+                                        appendInt(result, static_cast<int>(evaluer->computeRawScoreFromBitScore(res.score) + 0.5));
                                         break;
                                     case Parameters::OUTFMT_BITS:
-                                        result.append(SSTR(res.score));
+                                        appendInt(result, res.score);
                                         break;
                                     case Parameters::OUTFMT_CIGAR:
                                         if(isTranslatedSearch == true && targetNucs == true && queryNucs == true ){
                                             Matcher::result_t::protein2nucl(res.backtrace, newBacktrace);
                                             res.backtrace = newBacktrace;
                                         }
-                                        result.append(SSTR(res.backtrace));
+                                        result.append(res.backtrace);
                                         newBacktrace.clear();
                                         break;
                                     case Parameters::OUTFMT_QSEQ:
@@ -593,28 +696,28 @@ int convertalignments(int argc, const char **argv, const Command &command) {
                                         break;
                                     }
                                     case Parameters::OUTFMT_MISMATCH:
-                                        result.append(SSTR(missMatchCount));
+                                        appendUInt(result, missMatchCount);
                                         break;
                                     case Parameters::OUTFMT_QCOV:
-                                        result.append(SSTR(res.qcov));
+                                        appendFixed3(result, res.qcov);
                                         break;
                                     case Parameters::OUTFMT_TCOV:
-                                        result.append(SSTR(res.dbcov));
+                                        appendFixed3(result, res.dbcov);
                                         break;
                                     case Parameters::OUTFMT_QSET:
                                         result.append(SSTR(qSetToSource[qKeyToSet[queryKey]]));
                                         break;
                                     case Parameters::OUTFMT_QSETID:
-                                        result.append(SSTR(qKeyToSet[queryKey]));
+                                        appendUInt(result, qKeyToSet[queryKey]);
                                         break;
                                     case Parameters::OUTFMT_TSET:
                                         result.append(SSTR(tSetToSource[tKeyToSet[res.dbKey]]));
                                         break;
                                     case Parameters::OUTFMT_TSETID:
-                                        result.append(SSTR(tKeyToSet[res.dbKey]));
+                                        appendUInt(result, tKeyToSet[res.dbKey]);
                                         break;
                                     case Parameters::OUTFMT_TAXID:
-                                        result.append(SSTR(taxon));
+                                        appendUInt(result, taxon);
                                         break;
                                     case Parameters::OUTFMT_TAXNAME:
                                         result.append((taxonNode != NULL) ? taxonNode->name : "unclassified");
@@ -626,16 +729,16 @@ int convertalignments(int argc, const char **argv, const Command &command) {
                                         result.push_back('-');
                                         break;
                                     case Parameters::OUTFMT_QORFSTART:
-                                        result.append(SSTR(res.queryOrfStartPos));
+                                        appendInt(result, res.queryOrfStartPos);
                                         break;
                                     case Parameters::OUTFMT_QORFEND:
-                                        result.append(SSTR(res.queryOrfEndPos));
+                                        appendInt(result, res.queryOrfEndPos);
                                         break;
                                     case Parameters::OUTFMT_TORFSTART:
-                                        result.append(SSTR(res.dbOrfStartPos));
+                                        appendInt(result, res.dbOrfStartPos);
                                         break;
                                     case Parameters::OUTFMT_TORFEND:
-                                        result.append(SSTR(res.dbOrfEndPos));
+                                        appendInt(result, res.dbOrfEndPos);
                                         break;
                                 }
                                 if (i < outcodes.size() - 1) {
@@ -775,18 +878,26 @@ int convertalignments(int argc, const char **argv, const Command &command) {
             if (format == Parameters::FORMAT_ALIGNMENT_HTML) {
                 result.append("]},\n");
             }
-            resultWriter.writeData(result.c_str(), result.size(), queryKey, thread_idx, isDb);
+            if (isDb) {
+                resultWriter->writeData(result.c_str(), result.size(), queryKey, thread_idx);
+            } else {
+                // the prelude takes the first position of the file
+                fileWriter->write(i + 1, result.c_str(), result.size());
+            }
             result.clear();
         }
     }
-    if (format == Parameters::FORMAT_ALIGNMENT_HTML) {
-        const char* endBlock = "]);</script>";
-        resultWriter.writeData(endBlock, strlen(endBlock), 0, localThreads - 1, false, false);
-    }
-    // tsv output
-    resultWriter.close(true);
-    if (isDb == false) {
-        FileUtil::remove(par.db4Index.c_str());
+    const char* endBlock = format == Parameters::FORMAT_ALIGNMENT_HTML ? "]);</script>" : "";
+    if (isDb) {
+        if (format == Parameters::FORMAT_ALIGNMENT_HTML) {
+            resultWriter->writeData(endBlock, strlen(endBlock), 0, localThreads - 1, false, false);
+        }
+        resultWriter->close(true);
+        delete resultWriter;
+    } else {
+        fileWriter->write(alnDbr.getSize() + 1, endBlock, strlen(endBlock));
+        fileWriter->close();
+        delete fileWriter;
     }
     if(needTaxonomy){
         delete t;
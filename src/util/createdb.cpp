@@ -12,6 +12,31 @@
 #include "KSeqWrapper.h"
 #include "itoa.h"
 
+// trains the compression dictionaries of the header and sequence database on the first input entries
+static void trainDictionaries(KSeqWrapper *kseq, DBWriter &hdrWriter, DBWriter &seqWriter) {
+    std::string hdrSamples;
+    std::string seqSamples;
+    std::vector<size_t> hdrSampleSizes;
+    std::vector<size_t> seqSampleSizes;
+    while ((hdrSamples.size() < DBWriter::DICTIONARY_SAMPLE_SIZE || seqSamples.size() < DBWriter::DICTIONARY_SAMPLE_SIZE) && kseq->ReadEntry()) {
+        const KSeqWrapper::KSeqEntry &e = kseq->entry;
+        size_t start = hdrSamples.size();
+        hdrSamples.append(e.name.s, e.name.l);
+        if (e.comment.l > 0) {
+            hdrSamples.append(" ", 1);
+            hdrSamples.append(e.comment.s, e.comment.l);
+        }
+        hdrSamples.push_back('\n');
+        hdrSampleSizes.push_back(hdrSamples.size() - start);
+
+        seqSamples.append(e.sequence.s, e.sequence.l);
+        seqSamples.push_back('\n');
+        seqSampleSizes.push_back(e.sequence.l + 1);
+    }
+    hdrWriter.setDictionary(DBWriter::trainDictionary(hdrSamples, hdrSampleSizes));
+    seqWriter.setDictionary(DBWriter::trainDictionary(seqSamples, seqSampleSizes));
+}
+
 int createdb(int argc, const char **argv, const Command& command) {
     Parameters &par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, true, Parameters::PARSE_VARIADIC, 0);
@@ -104,6 +129,18 @@ int createdb(int argc, const char **argv, const Command& command) {
         fileCount = reader->getSize();
     }
 
+    if (par.compressed && par.compressionDict) {
+        // training reads the input a second time, which would consume a pipe
+        if (dbInput == false && (filenames[0] == "stdin" || FileUtil::isRegularFile(filenames[0].c_str()) == false)) {
+            Debug(Debug::WARNING) << "Compression dictionaries can only be trained on regular input files\n";
+        } else {
+            KSeqWrapper *kseq = (dbInput == true) ? new KSeqBuffer(reader->getData(0, 0), reader->getEntryLen(0) - 1)
+                                                  : KSeqFactory(filenames[0].c_str());
+            trainDictionaries(kseq, hdrWriter, seqWriter);
+            delete kseq;
+        }
+    }
+
     for (size_t fileIdx = 0; fileIdx < fileCount; fileIdx++) {
         unsigned int numEntriesInCurrFile = 0;
         std::string header;
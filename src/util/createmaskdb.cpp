@@ -0,0 +1,121 @@
+#include "NucleotideMatrix.h"
+#include "SubstitutionMatrix.h"
+#include "ReducedMatrix.h"
+#include "Prefiltering.h"
+#include "SequenceMasks.h"
+#include "tantan.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Debug.h"
+#include "Util.h"
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+int createmaskdb(int argc, const char **argv, const Command& command) {
+    Parameters &par = Parameters::getInstance();
+    par.parseParameters(argc, argv, command, true, 0, 0);
+
+    DBReader<unsigned int> reader(par.db1.c_str(), par.db1Index.c_str(), par.threads,
+                                  DBReader<unsigned int>::USE_DATA | DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+
+    // same matrices and tantan settings as the module that uses the masks
+    const bool isNucl = Parameters::isEqualDbtype(reader.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES);
+    if (isNucl == false && Parameters::isEqualDbtype(reader.getDbtype(), Parameters::DBTYPE_AMINO_ACIDS) == false) {
+        Debug(Debug::ERROR) << "Masks can only be computed for amino acid or nucleotide databases\n";
+        EXIT(EXIT_FAILURE);
+    }
+    BaseMatrix *subMat;
+    double repeatOffsetProbDecay = 0.9;
+    double minMaskProb = 0.9;
+    switch (par.maskDbMode) {
+        case Parameters::MASK_DB_MASKSEQUENCE:
+            if (isNucl) {
+                subMat = new NucleotideMatrix(par.scoringMatrixFile.nucleotides, 1.0, 0.0);
+            } else {
+                subMat = new SubstitutionMatrix(par.scoringMatrixFile.aminoacids, 2.0, 0.0);
+            }
+            minMaskProb = 0.5;
+            break;
+        case Parameters::MASK_DB_KMERMATCHER:
+            if (isNucl) {
+                subMat = new NucleotideMatrix(par.scoringMatrixFile.nucleotides, 1.0, 0.0);
+            } else if (par.alphabetSize.aminoacids == 21) {
+                subMat = new SubstitutionMatrix(par.scoringMatrixFile.aminoacids, 2.0, 0.0);
+            } else {
+                SubstitutionMatrix sMat(par.scoringMatrixFile.aminoacids, 8.0, -0.2f);
+                subMat = new ReducedMatrix(sMat.probMatrix, sMat.subMatrixPseudoCounts, sMat.aa2num, sMat.num2aa, sMat.alphabetSize, par.alphabetSize.aminoacids, 2.0);
+            }
+            repeatOffsetProbDecay = 0.5;
+            break;
+        default:
+            if (isNucl) {
+                subMat = new NucleotideMatrix(par.scoringMatrixFile.nucleotides, 1.0, 0.0);
+            } else {
+                subMat = Prefiltering::getSubstitutionMatrix(par.seedScoringMatrixFile, par.alphabetSize, 8.0, false, false);
+            }
+            break;
+    }
+    size_t maxSeqLen = 0;
+    for (size_t i = 0; i < reader.getSize(); i++) {
+        maxSeqLen = std::max(reader.getSeqLen(i), maxSeqLen);
+    }
+    ProbabilityMatrix probMatrix(*subMat);
+
+    std::string maskDb = SequenceMasks::getMaskDbName(par.db1);
+    std::string maskDbIndex = maskDb + ".index";
+    DBWriter writer(maskDb.c_str(), maskDbIndex.c_str(), par.threads, false, Parameters::DBTYPE_GENERIC_DB);
+    writer.open();
+    Debug::Progress progress(reader.getSize());
+    size_t maskedResidues = 0;
+#pragma omp parallel
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = (unsigned int) omp_get_thread_num();
+#endif
+        char *sequence = new char[maxSeqLen + 1];
+        char *maskedSequence = new char[maxSeqLen + 1];
+        std::vector<unsigned int> runs;
+
+#pragma omp for schedule(dynamic, 10) reduction(+:maskedResidues)
+        for (size_t id = 0; id < reader.getSize(); ++id) {
+            progress.updateProgress();
+            char *seqData = reader.getData(id, thread_idx);
+            size_t seqLen = reader.getSeqLen(id);
+            if (par.maskDbMode == Parameters::MASK_DB_MASKSEQUENCE) {
+                // masksequence masks the line break as well
+                seqLen = strlen(seqData);
+            }
+            for (size_t pos = 0; pos < seqLen; pos++) {
+                sequence[pos] = (char) subMat->aa2num[static_cast<int>(seqData[pos])];
+            }
+            memcpy(maskedSequence, sequence, seqLen);
+            maskedResidues += tantan::maskSequences(maskedSequence,
+                                                    maskedSequence + seqLen,
+                                                    50 /*options.maxCycleLength*/,
+                                                    probMatrix.probMatrixPointers,
+                                                    0.005 /*options.repeatProb*/,
+                                                    0.05 /*options.repeatEndProb*/,
+                                                    repeatOffsetProbDecay,
+                                                    0, 0,
+                                                    minMaskProb,
+                                                    probMatrix.hardMaskTable);
+
+            runs.clear();
+            SequenceMasks::encodeRuns(sequence, maskedSequence, seqLen, runs);
+            writer.writeData(reinterpret_cast<const char *>(runs.data()), runs.size() * sizeof(unsigned int), reader.getDbKey(id), thread_idx);
+        }
+        delete[] maskedSequence;
+        delete[] sequence;
+    }
+    writer.close(true);
+    SequenceMasks::writeSettings(par.db1, SequenceMasks::getSettings(reader, *subMat, repeatOffsetProbDecay, minMaskProb));
+    Debug(Debug::INFO) << "Masked residues: " << maskedResidues << "\n";
+    reader.close();
+
+    delete subMat;
+    return EXIT_SUCCESS;
+}
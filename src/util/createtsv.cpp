@@ -1,6 +1,7 @@
 #include "Parameters.h"
 #include "DBReader.h"
 #include "DBWriter.h"
+#include "OrderedFileWriter.h"
 #include "Debug.h"
 #include "Util.h"
 #include "IndexReader.h"
@@ -61,10 +62,15 @@ int createtsv(int argc, const char **argv, const Command &command) {
 
     const std::string& dataFile = hasTargetDB ? par.db4 : par.db3;
     const std::string& indexFile = hasTargetDB ? par.db4Index : par.db3Index;
-    const bool shouldCompress = par.dbOut == true && par.compressed == true;
-    const int dbType = par.dbOut == true ? Parameters::DBTYPE_GENERIC_DB : Parameters::DBTYPE_OMIT_FILE;
-    DBWriter writer(dataFile.c_str(), indexFile.c_str(), par.threads, shouldCompress, dbType);
-    writer.open();
+    // the tsv is streamed in result order directly into the output file, without per thread files
+    DBWriter *writer = NULL;
+    OrderedFileWriter *fileWriter = NULL;
+    if (par.dbOut) {
+        writer = new DBWriter(dataFile.c_str(), indexFile.c_str(), par.threads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+        writer->open();
+    } else {
+        fileWriter = new OrderedFileWriter(dataFile);
+    }
 
     const size_t targetColumn = (par.targetTsvColumn == 0) ? SIZE_T_MAX :  par.targetTsvColumn - 1;
 #pragma omp parallel
@@ -88,6 +94,9 @@ int createtsv(int argc, const char **argv, const Command &command) {
             char *headerData = queryDB->getData(queryIndex, thread_idx);
             if (headerData == NULL) {
                 Debug(Debug::WARNING) << "Invalid header entry in query " << queryKey << "!\n";
+                if (par.dbOut == false) {
+                    fileWriter->write(i, NULL, 0);
+                }
                 continue;
             }
 
@@ -156,19 +165,21 @@ int createtsv(int argc, const char **argv, const Command &command) {
                 data = nextLine;
                 entryIndex++;
             }
-            writer.writeData(outputBuffer.c_str(), outputBuffer.length(), queryKey, thread_idx, par.dbOut);
+            if (par.dbOut) {
+                writer->writeData(outputBuffer.c_str(), outputBuffer.length(), queryKey, thread_idx);
+            } else {
+                fileWriter->write(i, outputBuffer.c_str(), outputBuffer.length());
+            }
             outputBuffer.clear();
         }
         delete[] dbKey;
     }
-    writer.close(par.dbOut == false);
-
-    if (par.dbOut == false) {
-        if (hasTargetDB) {
-            FileUtil::remove(par.db4Index.c_str());
-        } else {
-            FileUtil::remove(par.db3Index.c_str());
-        }
+    if (par.dbOut) {
+        writer->close();
+        delete writer;
+    } else {
+        fileWriter->close();
+        delete fileWriter;
     }
 
     reader->close();
@@ -1,6 +1,7 @@
 #include "NucleotideMatrix.h"
 #include "SubstitutionMatrix.h"
 #include "tantan.h"
+#include "SequenceMasks.h"
 #include "DBReader.h"
 #include "DBWriter.h"
 #include "Debug.h"
@@ -33,6 +34,8 @@ int masksequence(int argc, const char **argv, const Command& command) {
     }
     // need to prune low scoring k-mers through masking
     ProbabilityMatrix probMatrix(*subMat);
+    // masks precomputed by createmaskdb are used instead of running tantan again
+    SequenceMasks *sequenceMasks = SequenceMasks::openIfExists(par.db1, SequenceMasks::getSettings(reader, *subMat, 0.9, 0.5), par.threads);
 
     DBWriter writer(par.db2.c_str(), par.db2Index.c_str(), par.threads, par.compressed, reader.getDbtype());
     writer.open();
@@ -53,16 +56,20 @@ int masksequence(int argc, const char **argv, const Command& command) {
                 charSequence[seqLen] = (char) subMat->aa2num[static_cast<int>(seqData[seqLen])];
                 seqLen++;
             }
-            tantan::maskSequences(charSequence,
-                                  charSequence + seqLen,
-                                  50 /*options.maxCycleLength*/,
-                                  probMatrix.probMatrixPointers,
-                                  0.005 /*options.repeatProb*/,
-                                  0.05 /*options.repeatEndProb*/,
-                                  0.9 /*options.repeatOffsetProbDecay*/,
-                                  0, 0,
-                                  0.5 /*options.minMaskProb*/,
-                                  probMatrix.hardMaskTable);
+            size_t maskedResidues = 0;
+            if (sequenceMasks == NULL || sequenceMasks->applyMask(reader.getDbKey(id), (unsigned char *) charSequence, seqLen,
+                                                                  probMatrix.hardMaskTable[0], thread_idx, maskedResidues) == false) {
+                tantan::maskSequences(charSequence,
+                                      charSequence + seqLen,
+                                      50 /*options.maxCycleLength*/,
+                                      probMatrix.probMatrixPointers,
+                                      0.005 /*options.repeatProb*/,
+                                      0.05 /*options.repeatEndProb*/,
+                                      0.9 /*options.repeatOffsetProbDecay*/,
+                                      0, 0,
+                                      0.5 /*options.minMaskProb*/,
+                                      probMatrix.hardMaskTable);
+            }
 
             for (unsigned int pos = 0; pos < seqLen; pos++) {
                 char aa = seqData[pos];
@@ -73,6 +80,9 @@ int masksequence(int argc, const char **argv, const Command& command) {
         delete[] charSequence;
     }
     writer.close(true);
+    if (sequenceMasks != NULL) {
+        delete sequenceMasks;
+    }
     DBReader<unsigned int>::softlinkDb(par.db1, par.db2, DBFiles::SEQUENCE_ANCILLARY);
     reader.close();
 
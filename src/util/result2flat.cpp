@@ -2,105 +2,91 @@
 #include <Parameters.h>
 
 #include "DBReader.h"
+#include "OrderedFileWriter.h"
 #include "Debug.h"
 #include "Util.h"
 
+#ifdef OPENMP
+#include <omp.h>
+#endif
 
 int result2flat(int argc, const char **argv, const Command &command) {
     Parameters &par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, true, 0, 0);
 
-    DBReader<unsigned int> querydb_header(par.hdr1.c_str(), par.hdr1Index.c_str(), 1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    DBReader<unsigned int> querydb_header(par.hdr1.c_str(), par.hdr1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     querydb_header.open(DBReader<unsigned int>::NOSORT);
     querydb_header.readMmapedDataInMemory();
 
-    DBReader<unsigned int> targetdb_header(par.hdr2.c_str(), par.hdr2Index.c_str(), 1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    DBReader<unsigned int> targetdb_header(par.hdr2.c_str(), par.hdr2Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     targetdb_header.open(DBReader<unsigned int>::NOSORT);
     targetdb_header.readMmapedDataInMemory();
 
-    DBReader<unsigned int> dbr_data(par.db3.c_str(), par.db3Index.c_str(),  1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    DBReader<unsigned int> dbr_data(par.db3.c_str(), par.db3Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     dbr_data.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
-    FILE *fastaFP = fopen(par.db4.c_str(), "w");
-
-    char header_start[] = {'>'};
-    char newline[] = {'\n'};
-
-    for (size_t i = 0; i < dbr_data.getSize(); i++) {
-
-        // Write the header, taken from the original queryDB
-        fwrite(header_start, sizeof(char), 1, fastaFP);
-        unsigned int key = dbr_data.getDbKey(i);
-        char *header_data = querydb_header.getDataByDBKey(key, 0);
-
-        std::string headerStr;
-        if (par.useHeader == true){
-            size_t lineLen = Util::skipLine(header_data) - header_data;
-            headerStr.assign(header_data, lineLen);
-
-            if (headerStr.length() > 0) {
-                if (headerStr[headerStr.length() - 1] == '\n') {
-                    headerStr[headerStr.length() - 1] = ' ';
-                }
-            }
-        }else{
-            headerStr=Util::parseFastaHeader(header_data);
+    // only the first column of result databases refers to target keys
+    bool isResultDb = false;
+    for (size_t i = 0; i < DbValidator::resultDb.size(); i++) {
+        if (Parameters::isEqualDbtype(dbr_data.getDbtype(), DbValidator::resultDb[i])) {
+            isResultDb = true;
         }
-        fwrite(headerStr.c_str(), sizeof(char), headerStr.length(), fastaFP);
-        fwrite(newline, sizeof(char), 1, fastaFP);
+    }
 
-        // write data
-        char *data = dbr_data.getData(i, 0);
-        std::string dbKeyBuffer;
-        const char * words[2];
-        while (*data != '\0') {
-            // dbKeyBuffer can contain sequence
-            Util::getWordsOfLine(data, words, 2);
-            //Util::parseKey(data, dbKeyBuffer);
-            char *target_header_data = NULL;
-            size_t keyLen = 0;
-            for(size_t  i = 0; i < DbValidator::resultDb.size(); i++){
-                if(Parameters::isEqualDbtype(dbr_data.getDbtype(), DbValidator::resultDb[i])  ) {
-                    keyLen = (words[1] - words[0]);
-                    dbKeyBuffer.size();
-                    dbKeyBuffer.append(words[0], keyLen);
-                    const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer.c_str(), NULL, 10);
-                    target_header_data = targetdb_header.getDataByDBKey(dbKey, 0);
+    // entries are formatted in parallel, the writer puts them back into database order
+    OrderedFileWriter writer(par.db4);
+#pragma omp parallel
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        std::string entry;
+        entry.reserve(1024 * 1024);
+#pragma omp for schedule(dynamic, 100)
+        for (size_t i = 0; i < dbr_data.getSize(); i++) {
+            // Write the header, taken from the original queryDB
+            entry.push_back('>');
+            unsigned int key = dbr_data.getDbKey(i);
+            char *header_data = querydb_header.getDataByDBKey(key, thread_idx);
+            if (par.useHeader == true) {
+                const size_t lineLen = Util::skipLine(header_data) - header_data;
+                entry.append(header_data, lineLen);
+                if (lineLen > 0 && entry[entry.length() - 1] == '\n') {
+                    entry[entry.length() - 1] = ' ';
                 }
-            }
-            std::string dataStr;
-            if (par.useHeader == true && target_header_data != NULL)
-            {
-                dataStr = Util::parseFastaHeader(target_header_data);
-                char *endLenData = Util::skipLine(data);
-                char *dataWithoutKey = data + keyLen;
-                size_t dataToCopySize = endLenData - dataWithoutKey;
-                dataStr.append(dataWithoutKey, dataToCopySize);
             } else {
-                char *startLine = data;
-                char *endLine = Util::skipLine(data);
-                size_t n = endLine - startLine;
-                dataStr = std::string(startLine, n);
+                entry.append(Util::parseFastaHeader(header_data));
             }
+            entry.push_back('\n');
 
-            // newline at the end
-            if (dataStr.length() > 0) {
-                if (dataStr[dataStr.length() - 1] != '\n') {
-                    dataStr.push_back('\n');
+            // write data
+            char *data = dbr_data.getData(i, thread_idx);
+            while (*data != '\0') {
+                char *endLine = Util::skipLine(data);
+                char *target_header_data = NULL;
+                const size_t keyLen = Util::skipNoneWhitespace(data);
+                if (par.useHeader == true && isResultDb) {
+                    const unsigned int dbKey = (unsigned int) strtoul(data, NULL, 10);
+                    target_header_data = targetdb_header.getDataByDBKey(dbKey, thread_idx);
+                }
+                if (target_header_data != NULL) {
+                    entry.append(Util::parseFastaHeader(target_header_data));
+                    entry.append(data + keyLen, endLine - (data + keyLen));
+                } else {
+                    entry.append(data, endLine - data);
                 }
+                // newline at the end
+                if (endLine > data && entry[entry.length() - 1] != '\n') {
+                    entry.push_back('\n');
+                }
+                data = endLine;
             }
-
-//            std::cout << dataStr << std::endl;
-            fwrite(dataStr.c_str(), sizeof(char), dataStr.length(), fastaFP);
-            dataStr.clear();
-            data = Util::skipLine(data);
+            writer.write(i, entry.c_str(), entry.size());
+            entry.clear();
         }
     }
-
-    if (fclose(fastaFP) != 0) {
-        Debug(Debug::ERROR) << "Cannot close file " << par.db4 << "\n";
-        EXIT(EXIT_FAILURE);
-    }
+    writer.close();
     targetdb_header.close();
     querydb_header.close();
     dbr_data.close();
@@ -122,6 +122,11 @@ int result2msa(int argc, const char **argv, const Command &command) {
     Debug(Debug::INFO) << "Target database size: " << tDbr->getSize() << " type: " << tDbr->getDbTypeName() << "\n";
 
     const bool isFiltering = par.filterMsa != 0;
+    // streaming writes every member directly, this is only possible for plain MSAs without deletions
+    const bool streamMsa = par.streamMsa && par.compressMSA == false && par.allowDeletion == false;
+    if (par.streamMsa && streamMsa == false) {
+        Debug(Debug::WARNING) << "--stream-msa cannot be combined with --compress or --allow-deletion and is ignored\n";
+    }
     Debug::Progress progress(dbSize - dbFrom);
 #pragma omp parallel num_threads(localThreads)
     {
@@ -162,6 +167,13 @@ int result2msa(int argc, const char **argv, const Command &command) {
         std::string result;
         result.reserve(300 * 1024);
 
+        char *queryRow = NULL;
+        char *memberRow = NULL;
+        if (streamMsa) {
+            queryRow = new char[maxSequenceLength + 1];
+            memberRow = new char[maxSequenceLength + 1];
+        }
+
 #pragma omp  for schedule(dynamic, 10)
         for (size_t id = dbFrom; id < (dbFrom + dbSize); id++) {
             progress.updateProgress();
@@ -192,6 +204,86 @@ int result2msa(int argc, const char **argv, const Command &command) {
 
             bool isQueryInit = false;
             char *data = resultReader.getData(id, thread_idx);
+            if (streamMsa) {
+                const size_t queryLength = centerSequence.L;
+                for (size_t pos = 0; pos < queryLength; pos++) {
+                    queryRow[pos] = static_cast<char>(centerSequence.numSequence[pos]);
+                }
+                if (par.summarizeHeader) {
+                    headers.emplace_back(centerSequenceHeader, centerHeaderLength);
+                }
+                if (par.skipQuery == false) {
+                    result.append(1, '>');
+                    result.append(centerSequenceHeader, centerHeaderLength);
+                    for (size_t pos = 0; pos < queryLength; pos++) {
+                        char aa = queryRow[pos];
+                        result.append(1, ((aa < MultipleAlignment::NAA) ? subMat.num2aa[(int) aa] : '-'));
+                    }
+                    result.append(1, '\n');
+                }
+                while (*data != '\0') {
+                    Util::parseKey(data, dbKey);
+                    const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
+                    if (key == queryKey && sameDatabase == true) {
+                        data = Util::skipLine(data);
+                        continue;
+                    }
+
+                    const size_t edgeId = tDbr->getId(key);
+                    if (edgeId == UINT_MAX) {
+                        Debug(Debug::ERROR) << "Sequence " << key << " does not exist in target sequence database\n";
+                        EXIT(EXIT_FAILURE);
+                    }
+                    edgeSequence.mapSequence(edgeId, key, tDbr->getData(edgeId, thread_idx), tDbr->getSeqLen(edgeId));
+                    const size_t columns = Util::getWordsOfLine(data, entry, 255);
+                    Matcher::result_t aln;
+                    if (columns > Matcher::ALN_RES_WITHOUT_BT_COL_CNT) {
+                        aln = Matcher::parseAlignmentRecord(data, true);
+                    } else {
+                        if (isQueryInit == false) {
+                            matcher.initQuery(&centerSequence);
+                            isQueryInit = true;
+                        }
+                        aln = matcher.getSWResult(&edgeSequence, INT_MAX, false, 0, 0.0, FLT_MAX, Matcher::SCORE_COV_SEQID, 0, false);
+                    }
+                    data = Util::skipLine(data);
+
+                    MultipleAlignment::computeNoDeletionRow(memberRow, queryLength, edgeSequence.numSequence, aln);
+                    if (isFiltering && filter.keepSequence(queryRow, memberRow, queryLength, static_cast<int>(par.covMSAThr * 100), static_cast<int>(par.qid * 100), par.qsc) == false) {
+                        continue;
+                    }
+
+                    char *header = targetHeaderReader->getData(edgeId, thread_idx);
+                    size_t length = targetHeaderReader->getEntryLen(edgeId) - 1;
+                    if (par.summarizeHeader) {
+                        headers.emplace_back(header, length);
+                    }
+                    result.append(1, '>');
+                    result.append(header, length);
+                    for (size_t pos = 0; pos < queryLength; pos++) {
+                        char aa = memberRow[pos];
+                        result.append(1, ((aa < MultipleAlignment::NAA) ? subMat.num2aa[(int) aa] : '-'));
+                    }
+                    result.append(1, '\n');
+                }
+
+                if (par.summarizeHeader) {
+                    std::string summary;
+                    summary.append(1, '#');
+                    summary.append(par.summaryPrefix);
+                    summary.append(1, '-');
+                    summary.append(SSTR(queryKey));
+                    summary.append(1, '|');
+                    summary.append(summarizer.summarize(headers));
+                    summary.append(1, '\n');
+                    result.insert(0, summary);
+                    headers.clear();
+                }
+                resultWriter.writeData(result.c_str(), result.length(), queryKey, thread_idx);
+                result.clear();
+                continue;
+            }
+
             while (*data != '\0') {
                 Util::parseKey(data, dbKey);
                 const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
@@ -333,6 +425,10 @@ int result2msa(int argc, const char **argv, const Command &command) {
         }
 
         delete[] kept;
+        if (streamMsa) {
+            delete[] queryRow;
+            delete[] memberRow;
+        }
     }
     resultWriter.close(true);
     resultReader.close();
@@ -147,6 +147,15 @@ int result2profile(int argc, const char **argv, const Command &command, bool ret
         std::string result;
         result.reserve((maxSequenceLength + 1) * Sequence::PROFILE_READIN_SIZE);
 
+        // streaming mode only keeps one MSA row and the (compressed) alignment of each member
+        char *queryRow = NULL;
+        char *memberRow = NULL;
+        std::vector<std::pair<size_t, Matcher::result_t>> streamMembers;
+        if (par.streamMsa) {
+            queryRow = new char[maxSequenceLength + 1];
+            memberRow = new char[maxSequenceLength + 1];
+        }
+
 #pragma omp for schedule(dynamic, 10)
         for (size_t id = dbFrom; id < (dbFrom + dbSize); id++) {
             progress.updateProgress();
@@ -161,6 +170,89 @@ int result2profile(int argc, const char **argv, const Command &command, bool ret
 
             bool isQueryInit = false;
             char *data = resultReader.getData(id, thread_idx);
+            if (par.streamMsa) {
+                const size_t queryLength = centerSequence.L;
+                for (size_t pos = 0; pos < queryLength; pos++) {
+                    queryRow[pos] = static_cast<char>(centerSequence.numSequence[pos]);
+                }
+                if (returnAlnRes == false) {
+                    calculator.initStreaming(queryLength);
+                    calculator.countStreamingRow(queryRow);
+                }
+                while (*data != '\0') {
+                    Util::parseKey(data, dbKey);
+                    const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
+                    if (key == queryKey && sameDatabase == true) {
+                        data = Util::skipLine(data);
+                        continue;
+                    }
+
+                    const size_t columns = Util::getWordsOfLine(data, entry, 255);
+                    float evalue = 0.0;
+                    if (columns >= 4) {
+                        evalue = strtod(entry[3], NULL);
+                    }
+                    if (evalue >= par.evalProfile) {
+                        data = Util::skipLine(data);
+                        continue;
+                    }
+
+                    const size_t edgeId = tDbr->getId(key);
+                    if (edgeId == UINT_MAX) {
+                        Debug(Debug::ERROR) << "Sequence " << key << " does not exist in target sequence database\n";
+                        EXIT(EXIT_FAILURE);
+                    }
+                    edgeSequence.mapSequence(edgeId, key, tDbr->getData(edgeId, thread_idx), tDbr->getSeqLen(edgeId));
+                    Matcher::result_t aln;
+                    if (columns > Matcher::ALN_RES_WITHOUT_BT_COL_CNT) {
+                        // filterresult writes the alignment again, keep the uncompressed backtrace for it
+                        aln = Matcher::parseAlignmentRecord(data, returnAlnRes == false);
+                    } else {
+                        if (isQueryInit == false) {
+                            matcher.initQuery(&centerSequence);
+                            isQueryInit = true;
+                        }
+                        aln = matcher.getSWResult(&edgeSequence, INT_MAX, false, 0, 0.0, FLT_MAX, Matcher::SCORE_COV_SEQID, 0, false);
+                        if (returnAlnRes == false) {
+                            aln.backtrace = Matcher::compressAlignment(aln.backtrace);
+                        }
+                    }
+                    data = Util::skipLine(data);
+
+                    MultipleAlignment::computeNoDeletionRow(memberRow, queryLength, edgeSequence.numSequence, aln);
+                    if (isFiltering && filter.keepSequence(queryRow, memberRow, queryLength, (int)(par.covMSAThr * 100), (int)(par.qid * 100), par.qsc) == false) {
+                        continue;
+                    }
+                    if (returnAlnRes) {
+                        size_t len = Matcher::resultToBuffer(buffer, aln, true);
+                        result.append(buffer, len);
+                    } else {
+                        calculator.countStreamingRow(memberRow);
+                        streamMembers.emplace_back(edgeId, aln);
+                    }
+                }
+
+                if (returnAlnRes == false) {
+                    // second pass: weights need the residue counts of all members
+                    calculator.addStreamingRow(0, queryRow);
+                    for (size_t i = 0; i < streamMembers.size(); ++i) {
+                        const size_t edgeId = streamMembers[i].first;
+                        edgeSequence.mapSequence(edgeId, tDbr->getDbKey(edgeId), tDbr->getData(edgeId, thread_idx), tDbr->getSeqLen(edgeId));
+                        MultipleAlignment::computeNoDeletionRow(memberRow, queryLength, edgeSequence.numSequence, streamMembers[i].second);
+                        calculator.addStreamingRow(i + 1, memberRow);
+                    }
+                    streamMembers.clear();
+                    PSSMCalculator::Profile pssmRes = calculator.computePSSMFromStreaming();
+                    if (par.maskProfile == true) {
+                        masker.mask(centerSequence, pssmRes);
+                    }
+                    pssmRes.toBuffer(centerSequence, subMat, result);
+                }
+                resultWriter.writeData(result.c_str(), result.length(), queryKey, thread_idx);
+                result.clear();
+                continue;
+            }
+
             while (*data != '\0') {
                 Util::parseKey(data, dbKey);
                 const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
@@ -235,6 +327,11 @@ int result2profile(int argc, const char **argv, const Command &command, bool ret
             MultipleAlignment::deleteMSA(&res);
             seqSet.clear();
         }
+
+        if (par.streamMsa) {
+            delete[] queryRow;
+            delete[] memberRow;
+        }
     }
     resultWriter.close(returnAlnRes == false);
     resultReader.close();
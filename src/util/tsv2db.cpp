@@ -1,10 +1,45 @@
-#include <sstream>
-#include <fstream>
-
 #include "Parameters.h"
 #include "DBWriter.h"
 #include "Debug.h"
 #include "Util.h"
+#include "FileUtil.h"
+
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+// the data is not null terminated if it is mapped, all scans are bounded by end
+static inline const char *lineEnd(const char *line, const char *end) {
+    const char *newline = static_cast<const char *>(memchr(line, '\n', end - line));
+    return (newline == NULL) ? end : newline;
+}
+
+static inline size_t keyLength(const char *line, const char *end) {
+    const char *pos = line;
+    while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\n') {
+        pos++;
+    }
+    return pos - line;
+}
+
+static inline bool sameKey(const char *first, const char *second, const char *end) {
+    const size_t length = keyLength(first, end);
+    return length == keyLength(second, end) && memcmp(first, second, length) == 0;
+}
+
+static void writeEntry(DBWriter &writer, std::string &result, const char *key, size_t keyLen,
+                       bool includeIdentity, unsigned int thread_idx) {
+    const std::string keyStr(key, keyLen);
+    if (includeIdentity) {
+        result.insert(0, keyStr + "\n");
+    }
+    unsigned int keyId = strtoull(keyStr.c_str(), NULL, 10);
+    writer.writeData(result.c_str(), result.length(), keyId, thread_idx);
+    result.clear();
+}
 
 int tsv2db(int argc, const char **argv, const Command& command) {
     Parameters &par = Parameters::getInstance();
@@ -15,63 +50,98 @@ int tsv2db(int argc, const char **argv, const Command& command) {
         Debug(Debug::INFO) << "Consider setting --output-dbtype.\n";
     }
 
-    DBWriter writer(par.db2.c_str(), par.db2Index.c_str(), 1, par.compressed, par.outputDbType);
-    writer.open();
-
-    std::ifstream tsv(par.db1);
-    if (tsv.fail()) {
+    FILE *file = fopen(par.db1.c_str(), "r");
+    if (file == NULL) {
         Debug(Debug::ERROR) << "File " << par.db1 << " not found!\n";
         EXIT(EXIT_FAILURE);
     }
+    // regular files are mapped, pipes are read completely
+    struct stat st;
+    char *data = NULL;
+    size_t dataSize = 0;
+    std::string buffer;
+    const bool isMapped = fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0;
+    if (isMapped) {
+        data = static_cast<char *>(FileUtil::mmapFile(file, &dataSize));
+    } else {
+        char readBuffer[65536];
+        size_t readSize;
+        while ((readSize = fread(readBuffer, sizeof(char), sizeof(readBuffer), file)) > 0) {
+            buffer.append(readBuffer, readSize);
+        }
+        data = &buffer[0];
+        dataSize = buffer.size();
+    }
+    const char *end = data + dataSize;
 
-    std::ostringstream ss;
-    char keyData[255];
-    bool skippedFirst = false;
-    std::string lastKey;
-    std::string line;
-    while(std::getline(tsv, line)) {
-        char* current = (char*) line.c_str();
-        Util::parseKey(current, keyData);
-        const std::string key(keyData);
-
-        if (key != lastKey && skippedFirst == true) {
-            if (par.includeIdentity) {
-                const std::string temp = ss.str();
-                ss.seekp(0);
-                ss << lastKey << "\n";
-                ss << temp;
+    // chunks start at line boundaries, consecutive lines with the same key are never split across chunks
+    const size_t minChunkSize = 1024 * 1024;
+    const size_t chunkCount = std::max(static_cast<size_t>(1), std::min(static_cast<size_t>(par.threads) * 16, dataSize / minChunkSize));
+    std::vector<const char *> chunkStarts(1, data);
+    for (size_t i = 1; i < chunkCount; i++) {
+        const char *pos = std::max<const char *>(data + (dataSize / chunkCount) * i, chunkStarts.back());
+        if (pos > data && pos[-1] != '\n') {
+            pos = std::min<const char *>(lineEnd(pos, end) + 1, end);
+        }
+        const char *previous = NULL;
+        if (pos > data && pos < end) {
+            previous = pos - 1;
+            while (previous > data && previous[-1] != '\n') {
+                previous--;
             }
-            const std::string result = ss.str();
-            unsigned int keyId = strtoull(lastKey.c_str(), NULL, 10);
-            writer.writeData(result.c_str(), result.length(), keyId);
-            ss.str("");
-            ss.clear();
-
         }
-
-        char *restStart = current + key.length();
-        restStart = restStart + Util::skipWhitespace(restStart);
-        char *restEnd = restStart;
-        restEnd = Util::seekToNextEntry(restEnd) - 1;
-
-        const std::string rest(restStart, restEnd - restStart);
-
-        skippedFirst = true;
-        ss << rest << "\n";
-        lastKey = key;
+        while (previous != NULL && pos < end && sameKey(previous, pos, end)) {
+            pos = std::min<const char *>(lineEnd(pos, end) + 1, end);
+        }
+        chunkStarts.push_back(pos);
     }
+    chunkStarts.push_back(end);
 
-    if (par.includeIdentity) {
-        const std::string temp = ss.str();
-        ss.seekp(0);
-        ss << lastKey << "\n";
-        ss << temp;
+    DBWriter writer(par.db2.c_str(), par.db2Index.c_str(), par.threads, par.compressed, par.outputDbType);
+    writer.open();
+#pragma omp parallel
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        std::string result;
+        result.reserve(1024 * 1024);
+#pragma omp for schedule(dynamic, 1)
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            const char *chunkEnd = chunkStarts[chunk + 1];
+            const char *lastKey = NULL;
+            size_t lastKeyLen = 0;
+            for (const char *line = chunkStarts[chunk]; line < chunkEnd;) {
+                const char *lineStop = lineEnd(line, chunkEnd);
+                const size_t keyLen = keyLength(line, lineStop);
+                if (lastKey != NULL && (keyLen != lastKeyLen || memcmp(line, lastKey, keyLen) != 0)) {
+                    writeEntry(writer, result, lastKey, lastKeyLen, par.includeIdentity, thread_idx);
+                }
+                const char *rest = line + keyLen;
+                while (rest < lineStop && (*rest == ' ' || *rest == '\t')) {
+                    rest++;
+                }
+                result.append(rest, lineStop - rest);
+                result.push_back('\n');
+                lastKey = line;
+                lastKeyLen = keyLen;
+                line = lineStop + 1;
+            }
+            if (lastKey != NULL) {
+                writeEntry(writer, result, lastKey, lastKeyLen, par.includeIdentity, thread_idx);
+            }
+        }
     }
-    const std::string result = ss.str();
-    unsigned int keyId = strtoull(lastKey.c_str(), NULL, 10);
-    writer.writeData(result.c_str(), result.length(), keyId);
-
     writer.close();
 
+    if (isMapped) {
+        FileUtil::munmapData(data, dataSize);
+    }
+    if (fclose(file) != 0) {
+        Debug(Debug::ERROR) << "Cannot close file " << par.db1 << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+
     return EXIT_SUCCESS;
 }
@@ -353,6 +353,7 @@ int search(int argc, const char **argv, const Command& command) {
         program = std::string(tmpDir + "/searchtargetprofile.sh");
     } else if (par.numIterations > 1) {
         cmd.addVariable("NUM_IT", SSTR(par.numIterations).c_str());
+        cmd.addVariable("REUSE_HITS", par.reuseIterationHits ? "TRUE" : NULL);
         cmd.addVariable("SUBSTRACT_PAR", par.createParameterString(par.subtractdbs).c_str());
         cmd.addVariable("VERBOSITY_PAR", par.createParameterString(par.onlyverbosity).c_str());
 
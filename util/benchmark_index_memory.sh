@@ -0,0 +1,29 @@
+#!/bin/bash -e
+# Compares the prefilter throughput for all huge page and NUMA placements of the index tables.
+# Explicit huge pages have to be reserved before, e.g. sysctl vm.nr_hugepages=<2 MB pages>.
+# Usage: benchmark_index_memory.sh <queryDB> <targetDB> <tmpDir> [prefilter options]
+QUERY="$1"
+TARGET="$2"
+TMP="$3"
+shift 3
+
+hasCommand() {
+	command -v "$1" >/dev/null 2>&1 || { echo "Please make sure that $1 is in \$PATH."; exit 1; }
+}
+hasCommand mmseqs
+
+mkdir -p "${TMP}"
+METRICS="${TMP}/metrics.jsonl"
+rm -f "${METRICS}"
+
+for HUGE_PAGES in 0 1 2 3; do
+	for NUMA_MODE in 0 1; do
+		mmseqs prefilter "${QUERY}" "${TARGET}" "${TMP}/pref_${HUGE_PAGES}_${NUMA_MODE}" \
+			--huge-pages "${HUGE_PAGES}" --numa-mode "${NUMA_MODE}" --metrics-file "${METRICS}" "$@" >/dev/null
+		mmseqs rmdb "${TMP}/pref_${HUGE_PAGES}_${NUMA_MODE}" >/dev/null
+		WALL_TIME="$(tail -n 1 "${METRICS}" | sed 's/.*"module":"prefilter","wall_time":\([0-9.]*\).*/\1/')"
+		QUERIES="$(wc -l < "${QUERY}.index")"
+		awk -v h="${HUGE_PAGES}" -v n="${NUMA_MODE}" -v t="${WALL_TIME}" -v q="${QUERIES}" \
+			'BEGIN { printf("huge-pages %s numa-mode %s: %.2f s, %.1f queries/s\n", h, n, t, q / t) }'
+	done
+done